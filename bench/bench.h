@@ -0,0 +1,67 @@
+/*
+ * bench.h
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#ifndef __bench_h__
+#define __bench_h__
+
+#include "../wheel.h"
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Helpers shared by the micro-benchmarks. Build them with optimizations
+ * enabled, e.g. "make CFLAGS='-O2 -std=gnu99 -pthread' bench", otherwise
+ * the numbers are not meaningful.
+ */
+
+static inline double
+bench_now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static inline unsigned long
+bench_arg (int argc, char **argv, int index, unsigned long defval)
+{
+    return (argc > index) ? strtoul (argv[index], NULL, 0) : defval;
+}
+
+
+static inline uint64_t
+bench_rand (uint64_t *state)
+{
+    /* xorshift64*, deterministic so runs are comparable. */
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * UINT64_C (0x2545F4914F6CDD1D);
+}
+
+
+static inline void
+bench_report (const char *name, const char *variant,
+              unsigned long ops, double elapsed)
+{
+    W_IO_NORESULT (w_io_format (w_stdout, "$s/$s: $L ops, $L ns/op\n",
+                                name, variant, ops,
+                                (unsigned long) (elapsed * 1e9 / ops)));
+}
+
+
+#define BENCH(_name, _variant, _ops, _body)                  \
+    do {                                                     \
+        double bench_start__ = bench_now ();                 \
+        _body;                                               \
+        bench_report ((_name), (_variant), (_ops),           \
+                      bench_now () - bench_start__);         \
+    } while (0)
+
+#endif /* !__bench_h__ */
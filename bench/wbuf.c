@@ -0,0 +1,76 @@
+/*
+ * wbuf.c
+ * Append throughput of w_buf_t for small and large contents.
+ *
+ * Usage: bench/wbuf [total-bytes]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 16 * 1024 * 1024);
+    uintptr_t sum = 0;
+
+    /* Short contents, as for keys and formatted numbers. */
+    BENCH ("set-str", "short", n / 16, {
+        for (unsigned long i = 0; i < n; i += 16) {
+            w_buf_t b = W_BUF;
+            w_buf_set_str (&b, "some-key");
+            w_buf_append_char (&b, 'a' + i % 26);
+            sum += w_buf_size (&b);
+            w_buf_clear (&b);
+        }
+    });
+
+    BENCH ("variant", "short", n / 16, {
+        for (unsigned long i = 0; i < n; i += 16) {
+            w_variant_t *v = w_variant_new (W_VARIANT_TYPE_STRING, "some-value");
+            sum += strlen (w_variant_string (v));
+            w_obj_unref (v);
+        }
+    });
+
+    /* Many small buffers, as in formatting short strings. */
+    BENCH ("append-char", "small", n, {
+        for (unsigned long i = 0; i < n; i += 100) {
+            w_buf_t b = W_BUF;
+            for (unsigned j = 0; j < 100; j++)
+                w_buf_append_char (&b, 'a' + j % 26);
+            sum += w_buf_size (&b);
+            w_buf_clear (&b);
+        }
+    });
+
+    BENCH ("append-char", "large", n, {
+        w_buf_t b = W_BUF;
+        for (unsigned long i = 0; i < n; i++)
+            w_buf_append_char (&b, 'a' + i % 26);
+        sum += w_buf_size (&b);
+        w_buf_clear (&b);
+    });
+
+    BENCH ("append-str", "large", n / 16, {
+        w_buf_t b = W_BUF;
+        for (unsigned long i = 0; i < n; i += 16)
+            w_buf_append_str (&b, "0123456789abcdef");
+        sum += w_buf_size (&b);
+        w_buf_clear (&b);
+    });
+
+    BENCH ("append-str", "reserved", n / 16, {
+        w_buf_t b = W_BUF;
+        w_buf_reserve (&b, n);
+        for (unsigned long i = 0; i < n; i += 16)
+            w_buf_append_str (&b, "0123456789abcdef");
+        sum += w_buf_size (&b);
+        w_buf_clear (&b);
+    });
+
+    return sum == 42;
+}
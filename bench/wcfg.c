@@ -0,0 +1,95 @@
+/*
+ * wcfg.c
+ * Parsing a big configuration file, reading directly from the file
+ * descriptor ("unbuffered"), through a buffered stream ("buffered"), or
+ * using w_cfg_load_file(), which maps the file into memory ("mmap").
+ * Operations are megabytes.
+ *
+ * Usage: bench/wcfg [megabytes] [path]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+static bool
+generate (const char *path, unsigned long size)
+{
+    w_io_t *fio = w_io_unix_open (path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (!fio)
+        return false;
+
+    w_io_t *io = w_io_buffered_open (fio, 0, 0);
+    w_obj_unref (fio);
+
+    uint64_t seed = 0x1234;
+    unsigned long written = 0;
+    for (unsigned long i = 0; written < size; i++) {
+        w_io_result_t r;
+        if (i == 0)
+            r = w_io_format (io, "section$L {\n", i);
+        else if (i % 1000 == 0)
+            r = w_io_format (io, "  enabled 1\n");
+        else if (i % 1000 == 999)
+            r = w_io_format (io, "  ratio $L.5\n}\nsection$L {\n",
+                             bench_rand (&seed) % 100, i);
+        else if (i % 2)
+            r = w_io_format (io, "  key$L $L\n", i, bench_rand (&seed) % 100000);
+        else
+            r = w_io_format (io, "  name$L \"some string value $L\"\n",
+                             i, bench_rand (&seed) % 1000);
+        if (w_io_failed (r))
+            break;
+        written += w_io_result_bytes (r);
+    }
+
+    bool ok = !w_io_failed (w_io_format (io, "}\n")) &&
+              !w_io_failed (w_io_flush (io));
+    w_obj_unref (io);
+    return ok && written >= size;
+}
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long mb = bench_arg (argc, argv, 1, 100);
+    const char *path = (argc > 2) ? argv[2] : "/tmp/bench-wcfg.conf";
+    uintptr_t sum = 0;
+
+    if (!generate (path, mb * 1024 * 1024)) {
+        fprintf (stderr, "Cannot write '%s'\n", path);
+        return 1;
+    }
+
+    BENCH ("cfg-load", "unbuffered", mb, {
+        w_io_t *io = w_io_unix_open (path, O_RDONLY, 0);
+        w_cfg_t *cfg = w_cfg_load (io, NULL);
+        sum += w_dict_size (cfg);
+        w_obj_unref (cfg);
+        w_obj_unref (io);
+    });
+
+    BENCH ("cfg-load", "buffered", mb, {
+        w_io_t *fio = w_io_unix_open (path, O_RDONLY, 0);
+        w_io_t *io = w_io_buffered_open (fio, 0, 0);
+        w_cfg_t *cfg = w_cfg_load (io, NULL);
+        sum += w_dict_size (cfg);
+        w_obj_unref (cfg);
+        w_obj_unref (io);
+        w_obj_unref (fio);
+    });
+
+    BENCH ("cfg-load", "mmap", mb, {
+        w_cfg_t *cfg = w_cfg_load_file (path, NULL);
+        sum += w_dict_size (cfg);
+        w_obj_unref (cfg);
+    });
+
+    unlink (path);
+    return sum == 42;
+}
@@ -0,0 +1,87 @@
+/*
+ * wdict-alloc.c
+ * Cost of building and tearing down large dictionaries, with and without
+ * slab allocation of items.
+ *
+ * Usage: bench/wdict-alloc [number-of-keys]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+# include <malloc.h>
+# define HAVE_MALLINFO2 1
+#endif
+
+
+static size_t
+heap_in_use (void)
+{
+#ifdef HAVE_MALLINFO2
+    struct mallinfo2 mi = mallinfo2 ();
+    return mi.uordblks + mi.hblkhd;
+#else
+    return 0;
+#endif /* HAVE_MALLINFO2 */
+}
+
+
+static void
+run (const char *variant, w_dict_backend_t backend, bool slab,
+     char **keys, unsigned long n)
+{
+    size_t heap_before = heap_in_use ();
+    size_t keybytes = 0;
+    w_dict_t *d = NULL;
+
+    BENCH ("build", variant, n, {
+        d = w_dict_new_with_backend (false, backend);
+        w_dict_set_slab (d, slab);
+        for (unsigned long i = 0; i < n; i++)
+            w_dict_set (d, keys[i], (void*) (i + 1));
+    });
+
+    /*
+     * Table memory is not per-item overhead, do not count it. Key bytes
+     * are not overhead either.
+     */
+    size_t table = d->size * sizeof (w_dict_node_t*) + (d->ctrl ? d->size + 16 : 0);
+    for (unsigned long i = 0; i < n; i++)
+        keybytes += strlen (keys[i]);
+    size_t used = heap_in_use () - heap_before;
+    if (used)
+        W_IO_NORESULT (w_io_format (w_stdout, "memory/$s: $L bytes/item overhead\n",
+                                    variant,
+                                    (unsigned long) ((used - table - keybytes) / n)));
+
+    BENCH ("destroy", variant, n, {
+        w_obj_unref (d);
+    });
+}
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 1000000);
+    char **keys = w_alloc (char*, n);
+    char buf[64];
+
+    for (unsigned long i = 0; i < n; i++) {
+        snprintf (buf, sizeof (buf), "config.section%lu.key%lu", i % 97, i);
+        keys[i] = w_str_dup (buf);
+    }
+
+    run ("chained", W_DICT_CHAINED, false, keys, n);
+    run ("chained-slab", W_DICT_CHAINED, true, keys, n);
+    run ("open", W_DICT_OPEN_ADDRESSING, false, keys, n);
+    run ("open-slab", W_DICT_OPEN_ADDRESSING, true, keys, n);
+
+    for (unsigned long i = 0; i < n; i++)
+        w_free (keys[i]);
+    w_free (keys);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/*
+ * wdict-image.c
+ * Compares loading a dictionary by parsing a configuration file with
+ * mapping a dictionary image.
+ *
+ * Usage: bench/wdict-image [number-of-keys]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 500000);
+    uint64_t seed = 0x1234567;
+    uintptr_t sum = 0;
+    char key[64];
+
+    w_dict_t *d = w_dict_new (true);
+    for (unsigned long i = 0; i < n; i++) {
+        snprintf (key, sizeof (key), "key_%08lx", i * 2654435761UL);
+        w_variant_t *value = w_variant_new (W_VARIANT_TYPE_FLOAT, (double) i);
+        w_dict_set (d, key, value);
+        w_obj_unref (value);
+    }
+
+    w_buf_t text = W_BUF;
+    w_io_buf_t iobuf;
+    w_io_buf_init (&iobuf, &text, false);
+    W_IO_NORESULT (w_cfg_dump (d, (w_io_t*) &iobuf));
+
+    char path[] = "wdict-image.XXXXXX";
+    w_io_t *io = w_io_unix_open_fd (mkstemp (path));
+    BENCH ("save", "image", n, {
+        W_IO_NORESULT (w_dict_save_image (d, io));
+    });
+    w_obj_unref (io);
+    w_obj_unref (d);
+
+    w_cfg_t *cf = NULL;
+    BENCH ("load", "text", n, {
+        w_io_mem_t iomem;
+        w_io_mem_init (&iomem, (uint8_t*) w_buf_data (&text), w_buf_size (&text));
+        cf = w_cfg_load ((w_io_t*) &iomem, NULL);
+    });
+    BENCH ("lookup", "text", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            snprintf (key, sizeof (key), "key_%08lx",
+                      (bench_rand (&seed) % n) * 2654435761UL);
+            sum += w_variant_float (w_dict_get (cf, key));
+        }
+    });
+    w_obj_unref (cf);
+
+    w_dict_image_t *image = NULL;
+    BENCH ("load", "image", n, {
+        image = w_dict_map_image (path);
+    });
+    BENCH ("lookup", "image", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            snprintf (key, sizeof (key), "key_%08lx",
+                      (bench_rand (&seed) % n) * 2654435761UL);
+            w_variant_t *value = w_dict_image_get_variant (image, key);
+            sum += w_variant_float (value);
+            w_obj_unref (value);
+        }
+    });
+    w_obj_unref (image);
+
+    unlink (path);
+    w_buf_clear (&text);
+
+    /* Prevents the compiler from optimizing away the lookups. */
+    if (sum == 42)
+        W_IO_NORESULT (w_io_format (w_stdout, "\n"));
+    return 0;
+}
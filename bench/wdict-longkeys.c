@@ -0,0 +1,88 @@
+/*
+ * wdict-longkeys.c
+ * Dictionary operations with long keys sharing a common prefix, which is
+ * typical of paths and URLs used as keys.
+ *
+ * Usage: bench/wdict-longkeys [number-of-keys]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <string.h>
+
+
+static char**
+make_keys (unsigned long n, size_t len, const char *suffix)
+{
+    char **keys = w_alloc (char*, n);
+    for (unsigned long i = 0; i < n; i++) {
+        keys[i] = w_alloc (char, len + 1);
+        memset (keys[i], '/', len);
+        snprintf (keys[i] + len - 24, 25, "%s-%016lx", suffix, i * 2654435761UL);
+    }
+    return keys;
+}
+
+
+static void
+free_keys (char **keys, unsigned long n)
+{
+    for (unsigned long i = 0; i < n; i++)
+        w_free (keys[i]);
+    w_free (keys);
+}
+
+
+static void
+run (const char *variant, w_dict_backend_t backend,
+     char **keys, char **miss, unsigned long n)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, backend);
+    uint64_t seed = 0xCAFE;
+    uintptr_t sum = 0;
+
+    BENCH ("insert", variant, n, {
+        for (unsigned long i = 0; i < n; i++)
+            w_dict_set (d, keys[i], (void*) (i + 1));
+    });
+
+    BENCH ("hit", variant, 4 * n, {
+        for (unsigned long i = 0; i < 4 * n; i++)
+            sum += (uintptr_t) w_dict_get (d, keys[bench_rand (&seed) % n]);
+    });
+
+    BENCH ("miss", variant, 4 * n, {
+        for (unsigned long i = 0; i < 4 * n; i++)
+            sum += (uintptr_t) w_dict_get (d, miss[bench_rand (&seed) % n]);
+    });
+
+    w_obj_unref (d);
+
+    if (sum == 42)
+        W_IO_NORESULT (w_io_format (w_stdout, "\n"));
+}
+
+
+int
+main (int argc, char **argv)
+{
+    static const size_t lengths[] = { 32, 128, 512, 2048 };
+    unsigned long n = bench_arg (argc, argv, 1, 50000);
+    char variant[64];
+
+    for (unsigned j = 0; j < w_lengthof (lengths); j++) {
+        char **keys = make_keys (n, lengths[j], "key");
+        char **miss = make_keys (n, lengths[j], "mis");
+
+        snprintf (variant, sizeof (variant), "chained-%zu", lengths[j]);
+        run (variant, W_DICT_CHAINED, keys, miss, n);
+        snprintf (variant, sizeof (variant), "open-%zu", lengths[j]);
+        run (variant, W_DICT_OPEN_ADDRESSING, keys, miss, n);
+
+        free_keys (keys, n);
+        free_keys (miss, n);
+    }
+    return EXIT_SUCCESS;
+}
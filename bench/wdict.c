@@ -0,0 +1,156 @@
+/*
+ * wdict.c
+ * Compares the chained, open addressing, and frozen dictionary layouts.
+ *
+ * Usage: bench/wdict [number-of-keys]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+
+static char**
+make_keys (unsigned long n, const char *prefix)
+{
+    char **keys = w_alloc (char*, n);
+    char buf[64];
+    for (unsigned long i = 0; i < n; i++) {
+        snprintf (buf, sizeof (buf), "%s.%08lx", prefix, i * 2654435761UL);
+        keys[i] = w_str_dup (buf);
+    }
+    return keys;
+}
+
+
+static void
+run (const char *variant, w_dict_backend_t backend,
+     char **keys, char **miss, unsigned long n)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, backend);
+    uint64_t seed = 0x1234567;
+    uintptr_t sum = 0;
+
+    BENCH ("insert", variant, n, {
+        for (unsigned long i = 0; i < n; i++)
+            w_dict_set (d, keys[i], (void*) (i + 1));
+    });
+
+    BENCH ("hit", variant, 4 * n, {
+        for (unsigned long i = 0; i < 4 * n; i++)
+            sum += (uintptr_t) w_dict_get (d, keys[bench_rand (&seed) % n]);
+    });
+
+    BENCH ("miss", variant, 4 * n, {
+        for (unsigned long i = 0; i < 4 * n; i++)
+            sum += (uintptr_t) w_dict_get (d, miss[bench_rand (&seed) % n]);
+    });
+
+    /* 60% hits, 20% misses, 10% deletions, 10% insertions. */
+    BENCH ("mixed", variant, 4 * n, {
+        for (unsigned long i = 0; i < 4 * n; i++) {
+            uint64_t r = bench_rand (&seed);
+            unsigned long k = (r >> 8) % n;
+            switch (r % 10) {
+                case 0: w_dict_del (d, keys[k]); break;
+                case 1: w_dict_set (d, keys[k], (void*) (k + 1)); break;
+                case 2:
+                case 3: sum += (uintptr_t) w_dict_get (d, miss[k]); break;
+                default: sum += (uintptr_t) w_dict_get (d, keys[k]); break;
+            }
+        }
+    });
+
+    BENCH ("delete", variant, n, {
+        for (unsigned long i = 0; i < n; i++)
+            w_dict_del (d, keys[i]);
+    });
+
+    w_obj_unref (d);
+
+    /* Prevents the compiler from optimizing away the lookups. */
+    if (sum == 42)
+        W_IO_NORESULT (w_io_format (w_stdout, "\n"));
+}
+
+
+static void
+run_frozen (char **keys, char **miss, unsigned long n)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, W_DICT_OPEN_ADDRESSING);
+    uint64_t seed = 0x1234567;
+    uintptr_t sum = 0;
+    w_dict_t *f = NULL;
+
+    for (unsigned long i = 0; i < n; i++)
+        w_dict_set (d, keys[i], (void*) (i + 1));
+
+    BENCH ("freeze", "frozen", n, {
+        f = w_dict_freeze (d);
+    });
+
+    BENCH ("hit", "frozen", 4 * n, {
+        for (unsigned long i = 0; i < 4 * n; i++)
+            sum += (uintptr_t) w_dict_get (f, keys[bench_rand (&seed) % n]);
+    });
+
+    BENCH ("miss", "frozen", 4 * n, {
+        for (unsigned long i = 0; i < 4 * n; i++)
+            sum += (uintptr_t) w_dict_get (f, miss[bench_rand (&seed) % n]);
+    });
+
+    w_obj_unref (f);
+    w_obj_unref (d);
+
+    if (sum == 42)
+        W_IO_NORESULT (w_io_format (w_stdout, "\n"));
+}
+
+
+static void
+run_latency (const char *variant, w_dict_backend_t backend, bool incremental,
+             char **keys, unsigned long n)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, backend);
+    double worst = 0.0;
+
+    w_dict_set_growth (d, 0, incremental);
+    double start = bench_now ();
+    for (unsigned long i = 0; i < n; i++) {
+        double t = bench_now ();
+        w_dict_set (d, keys[i], (void*) (i + 1));
+        t = bench_now () - t;
+        if (t > worst) worst = t;
+    }
+    bench_report ("insert", variant, n, bench_now () - start);
+    W_IO_NORESULT (w_io_format (w_stdout, "insert/$s: worst $L ns\n",
+                                variant, (unsigned long) (worst * 1e9)));
+    w_obj_unref (d);
+}
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 200000);
+    char **keys = make_keys (n, "key");
+    char **miss = make_keys (n, "miss");
+
+    run ("chained", W_DICT_CHAINED, keys, miss, n);
+    run ("open", W_DICT_OPEN_ADDRESSING, keys, miss, n);
+    run_frozen (keys, miss, n);
+
+    run_latency ("chained-full", W_DICT_CHAINED, false, keys, n);
+    run_latency ("chained-incremental", W_DICT_CHAINED, true, keys, n);
+    run_latency ("open-full", W_DICT_OPEN_ADDRESSING, false, keys, n);
+    run_latency ("open-incremental", W_DICT_OPEN_ADDRESSING, true, keys, n);
+
+    for (unsigned long i = 0; i < n; i++) {
+        w_free (keys[i]);
+        w_free (miss[i]);
+    }
+    w_free (keys);
+    w_free (miss);
+    return EXIT_SUCCESS;
+}
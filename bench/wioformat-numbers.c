@@ -0,0 +1,83 @@
+/*
+ * wioformat-numbers.c
+ * Formatting integers and floating point numbers to a stream which
+ * discards the output, using the w_io_format_*() functions, and into a
+ * stack buffer using snprintf() for comparison.
+ *
+ * Usage: bench/wioformat-numbers [iterations]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+
+static uintptr_t sum = 0;
+
+static w_io_result_t
+sink_write (w_io_t *io, const void *buf, size_t len)
+{
+    w_unused (io);
+    sum += ((const char*) buf)[0] + len;
+    return W_IO_RESULT (len);
+}
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 1000000);
+    uint64_t seed = 0xC0FFEE;
+
+    unsigned long *values = w_alloc (unsigned long, 1024);
+    double *doubles = w_alloc (double, 1024);
+    for (unsigned i = 0; i < 1024; i++) {
+        /* Spread the amount of digits evenly. */
+        values[i] = bench_rand (&seed) >> (bench_rand (&seed) % 64);
+        doubles[i] = (double) (bench_rand (&seed) % 1000000) / 1000.0;
+    }
+
+    w_io_t io;
+    w_io_init (&io);
+    io.write = sink_write;
+
+#define RUN(_name, _variant, _stmt)                      \
+    BENCH (_name, _variant, n, {                         \
+        for (unsigned long i = 0; i < n; i++) {          \
+            _stmt;                                       \
+        }                                                \
+    })
+
+    char tmp[64];
+
+    RUN ("ulong", "wheel",
+         W_IO_NORESULT (w_io_format_ulong (&io, values[i % 1024])));
+    RUN ("ulong", "snprintf",
+         sum += snprintf (tmp, sizeof (tmp), "%lu", values[i % 1024]));
+
+    RUN ("long", "wheel",
+         W_IO_NORESULT (w_io_format_long (&io, (long) values[i % 1024])));
+    RUN ("long", "snprintf",
+         sum += snprintf (tmp, sizeof (tmp), "%ld", (long) values[i % 1024]));
+
+    RUN ("hex", "wheel",
+         W_IO_NORESULT (w_io_format_ulong_hex (&io, values[i % 1024])));
+    RUN ("hex", "snprintf",
+         sum += snprintf (tmp, sizeof (tmp), "%lX", values[i % 1024]));
+
+    RUN ("double", "wheel",
+         W_IO_NORESULT (w_io_format_double (&io, doubles[i % 1024])));
+    RUN ("double", "snprintf",
+         sum += snprintf (tmp, sizeof (tmp), "%.17g", doubles[i % 1024]));
+
+    RUN ("double-integral", "wheel",
+         W_IO_NORESULT (w_io_format_double (&io, values[i % 1024] % 1000000)));
+    RUN ("double-integral", "snprintf",
+         sum += snprintf (tmp, sizeof (tmp), "%.17g",
+                          (double) (values[i % 1024] % 1000000)));
+
+    w_free (values);
+    w_free (doubles);
+    return sum == 42;
+}
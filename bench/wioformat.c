@@ -0,0 +1,78 @@
+/*
+ * wioformat.c
+ * Formatting short lines with literal text and a few arguments, written
+ * to an unbuffered stream on /dev/null ("unix"), or appended to a
+ * w_buf_t ("buf"), parsing the format string each time or using a
+ * compiled format ("-compiled").
+ *
+ * Usage: bench/wioformat [iterations]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <fcntl.h>
+#include <stdio.h>
+
+
+#define LINE_FORMAT "request $L from $s took $i ms, status: $I\n"
+
+static w_format_t line_format = W_FORMAT_STATIC (LINE_FORMAT);
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 1000000);
+    uintptr_t sum = 0;
+
+    w_io_t *io = w_io_unix_open ("/dev/null", O_WRONLY, 0);
+    if (!io) {
+        fprintf (stderr, "Cannot open /dev/null\n");
+        return 1;
+    }
+
+    BENCH ("format", "unix", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            sum += w_io_result_bytes (w_io_format (io,
+                    LINE_FORMAT,
+                    i, "localhost", (int) (i % 1000) - 500, 200u));
+        }
+    });
+
+    BENCH ("format", "buf", n, {
+        w_buf_t b = W_BUF;
+        for (unsigned long i = 0; i < n; i++) {
+            w_buf_format (&b, LINE_FORMAT,
+                          i, "localhost", (int) (i % 1000) - 500, 200u);
+            if (w_buf_size (&b) > 64 * 1024) {
+                sum += w_buf_size (&b);
+                w_buf_clear (&b);
+            }
+        }
+        w_buf_clear (&b);
+    });
+
+    BENCH ("format", "unix-compiled", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            sum += w_io_result_bytes (w_io_format_compiled (io, &line_format,
+                    i, "localhost", (int) (i % 1000) - 500, 200u));
+        }
+    });
+
+    BENCH ("format", "buf-compiled", n, {
+        w_buf_t b = W_BUF;
+        for (unsigned long i = 0; i < n; i++) {
+            w_buf_format_compiled (&b, &line_format,
+                                   i, "localhost", (int) (i % 1000) - 500, 200u);
+            if (w_buf_size (&b) > 64 * 1024) {
+                sum += w_buf_size (&b);
+                w_buf_clear (&b);
+            }
+        }
+        w_buf_clear (&b);
+    });
+
+    w_obj_unref (io);
+    return sum == 42;
+}
@@ -0,0 +1,89 @@
+/*
+ * wiofscan.c
+ * Scanning space-separated integers and floating point numbers from a
+ * memory stream ("buf"), which is done character by character, and from
+ * a buffered stream ("buffered"), where numbers are scanned directly from
+ * the buffered data. Also compares w_str_scan_double() with strtod().
+ *
+ * Usage: bench/wiofscan [count]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+
+static unsigned long
+scan_all (w_io_t *io, unsigned long n)
+{
+    unsigned long sum = 0;
+    double dsum = 0.0;
+
+    for (unsigned long i = 0; i < n; i++) {
+        long lval;
+        double dval;
+        if (w_io_fscan_long (io, &lval) || w_io_getchar (io) != ' ' ||
+            w_io_fscan_double (io, &dval) || w_io_getchar (io) != ' ')
+            break;
+        sum += lval;
+        dsum += dval;
+    }
+    return sum + (unsigned long) dsum;
+}
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 1000000);
+    uint64_t seed = 0x1234;
+    uintptr_t sum = 0;
+
+    w_buf_t text = W_BUF;
+    for (unsigned long i = 0; i < n; i++) {
+        uint64_t r = bench_rand (&seed);
+        w_buf_format (&text, "$l $L.$L ",
+                      (long) (r % 2000000) - 1000000,
+                      (r >> 24) % 100000, (r >> 40) % 1000);
+    }
+
+    BENCH ("fscan", "buf", n, {
+        w_io_buf_t io;
+        w_io_buf_init (&io, &text, false);
+        sum += scan_all ((w_io_t*) &io, n);
+    });
+
+    BENCH ("fscan", "buffered", n, {
+        w_io_buf_t io;
+        w_io_buf_init (&io, &text, false);
+        w_io_t *bio = w_io_buffered_open ((w_io_t*) &io, 0, 0);
+        sum += scan_all (bio, n);
+        w_obj_unref (bio);
+    });
+
+    /* Scan only the floating point numbers, every other token. */
+    BENCH ("scan-double", "strtod", n, {
+        const char *p = w_buf_const_data (&text);
+        for (unsigned long i = 0; i < n; i++) {
+            p = strchr (p, ' ') + 1;
+            char *end;
+            sum += (uintptr_t) strtod (p, &end);
+            p = end + 1;
+        }
+    });
+
+    BENCH ("scan-double", "w_str_scan_double", n, {
+        const char *p = w_buf_const_data (&text);
+        const char *end = p + w_buf_size (&text);
+        for (unsigned long i = 0; i < n; i++) {
+            p = strchr (p, ' ') + 1;
+            double value;
+            p += w_str_scan_double (p, end - p, &value) + 1;
+            sum += (uintptr_t) value;
+        }
+    });
+
+    w_buf_clear (&text);
+    return sum == 42;
+}
@@ -0,0 +1,135 @@
+/*
+ * wioreadline.c
+ * Counting the lines of a log file, with w_io_read_line() ("read-line")
+ * and with a w_io_lines_t splitter, either one line at a time ("lines")
+ * or in batches ("lines-batch"). Input comes from a memory stream ("buf"),
+ * and from a file read directly ("unix") or through a buffered stream
+ * ("buffered"). Operations are lines.
+ *
+ * Usage: bench/wioreadline [lines] [path]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+static unsigned long
+read_lines (w_io_t *io)
+{
+    w_buf_t line = W_BUF;
+    w_buf_t overflow = W_BUF;
+    unsigned long total = 0;
+
+    for (;;) {
+        w_io_result_t r = w_io_read_line (io, &line, &overflow, 0);
+        if (w_io_failed (r) || w_io_eof (r))
+            break;
+        total += w_buf_size (&line);
+        w_buf_resize (&line, 0);
+    }
+
+    w_buf_clear (&overflow);
+    w_buf_clear (&line);
+    return total;
+}
+
+
+static unsigned long
+split_lines (w_io_t *io, const char *delimiters)
+{
+    w_io_lines_t lines;
+    w_io_lines_init (&lines, io, delimiters, 0);
+
+    const char *data;
+    size_t size;
+    unsigned long total = 0;
+    while (!w_io_eof (w_io_lines_next (&lines, &data, &size)))
+        total += size;
+
+    w_io_lines_clear (&lines);
+    return total;
+}
+
+
+static unsigned long
+count_lines (w_io_t *io)
+{
+    w_io_lines_t lines;
+    w_io_lines_init (&lines, io, "\n", 0);
+
+    struct iovec iov[256];
+    unsigned long count = 0;
+    for (;;) {
+        int n = w_lengthof (iov);
+        w_io_result_t r = w_io_lines_batch (&lines, iov, &n);
+        if (w_io_failed (r) || w_io_eof (r))
+            break;
+        count += n;
+    }
+
+    w_io_lines_clear (&lines);
+    return count;
+}
+
+
+#define BENCH_INPUTS(_name, _expr)                                 \
+    do {                                                           \
+        BENCH (_name, "buf", n, {                                  \
+            w_io_buf_t iobuf;                                      \
+            w_io_buf_init (&iobuf, &text, false);                  \
+            w_io_t *io = (w_io_t*) &iobuf;                         \
+            sum += (_expr);                                        \
+        });                                                        \
+        BENCH (_name, "unix", n, {                                 \
+            w_io_t *io = w_io_unix_open (path, O_RDONLY, 0);       \
+            sum += (_expr);                                        \
+            w_obj_unref (io);                                      \
+        });                                                        \
+        BENCH (_name, "buffered", n, {                             \
+            w_io_t *fio = w_io_unix_open (path, O_RDONLY, 0);      \
+            w_io_t *io = w_io_buffered_open (fio, 0, 0);           \
+            w_obj_unref (fio);                                     \
+            sum += (_expr);                                        \
+            w_obj_unref (io);                                      \
+        });                                                        \
+    } while (0)
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 1000000);
+    const char *path = (argc > 2) ? argv[2] : "/tmp/bench-wioreadline.txt";
+    uint64_t seed = 0x1234;
+    uintptr_t sum = 0;
+
+    w_buf_t text = W_BUF;
+    for (unsigned long i = 0; i < n; i++) {
+        uint64_t r = bench_rand (&seed);
+        w_buf_format (&text, "$L [info] request from 10.0.$L.$L took $L ms\n",
+                      i, (r >> 8) % 256, (r >> 16) % 256, (r >> 32) % 5000);
+    }
+
+    w_io_t *out = w_io_unix_open (path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (!out || w_io_failed (w_io_write (out, w_buf_const_data (&text),
+                                         w_buf_size (&text)))) {
+        fprintf (stderr, "Cannot write '%s'\n", path);
+        return 1;
+    }
+    w_obj_unref (out);
+
+    BENCH_INPUTS ("read-line", read_lines (io));
+    BENCH_INPUTS ("lines", split_lines (io, "\n"));
+    BENCH_INPUTS ("lines-batch", count_lines (io));
+
+    /* Several delimiters use a vectorized search; three records per line. */
+    BENCH_INPUTS ("lines-multi", split_lines (io, "\n[]"));
+
+    unlink (path);
+    w_buf_clear (&text);
+    return sum == 42;
+}
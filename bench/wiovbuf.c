@@ -0,0 +1,60 @@
+/*
+ * wiovbuf.c
+ * Writing responses made of a few formatted headers and a large body to
+ * /dev/null, assembled in a w_buf_t or in a w_iovbuf_t.
+ *
+ * Usage: bench/wiovbuf [iterations] [body-size]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <fcntl.h>
+#include <stdio.h>
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 100000);
+    unsigned long body_size = bench_arg (argc, argv, 2, 64 * 1024);
+    uintptr_t sum = 0;
+
+    w_io_t *io = w_io_unix_open ("/dev/null", O_WRONLY, 0);
+    if (!io) {
+        fprintf (stderr, "Cannot open /dev/null\n");
+        return 1;
+    }
+
+    char *data = w_malloc (body_size);
+    memset (data, 'x', body_size);
+    w_bytes_t *body = w_bytes_new (data, body_size);
+    w_free (data);
+
+    BENCH ("response", "buf", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            w_buf_t b = W_BUF;
+            w_buf_format (&b, "Status: 200\r\nX-Request: $L\r\n", i);
+            w_buf_format (&b, "Content-Length: $L\r\n\r\n", w_bytes_size (body));
+            w_buf_append_mem (&b, w_bytes_data (body), w_bytes_size (body));
+            sum += w_io_result_bytes (w_io_write (io, w_buf_const_data (&b),
+                                                  w_buf_size (&b)));
+            w_buf_clear (&b);
+        }
+    });
+
+    BENCH ("response", "iovbuf", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            w_iovbuf_t v = W_IOVBUF;
+            w_iovbuf_format (&v, "Status: 200\r\nX-Request: $L\r\n", i);
+            w_iovbuf_format (&v, "Content-Length: $L\r\n\r\n", w_bytes_size (body));
+            w_iovbuf_append_bytes (&v, body);
+            sum += w_io_result_bytes (w_io_write_iovbuf (io, &v));
+            w_iovbuf_clear (&v);
+        }
+    });
+
+    w_obj_unref (body);
+    w_obj_unref (io);
+    return sum == 42;
+}
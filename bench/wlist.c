@@ -0,0 +1,66 @@
+/*
+ * wlist.c
+ * Compares the linked and array backends of w_list_t.
+ *
+ * Usage: bench/wlist [number-of-items] [rounds]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+
+static void
+run (const char *variant, w_list_backend_t backend,
+     unsigned long n, unsigned long rounds)
+{
+    w_list_t *list = w_list_new_with_backend (false, backend);
+    uint64_t seed = 42;
+    uintptr_t sum = 0;
+
+    BENCH ("push+pop", variant, n * rounds, {
+        for (unsigned long r = 0; r < rounds; r++) {
+            for (unsigned long i = 0; i < n; i++) {
+                if (i & 1) w_list_push_head (list, (void*) i);
+                else w_list_push_tail (list, (void*) i);
+            }
+            for (unsigned long i = 0; i < n; i++)
+                sum += (uintptr_t) ((i & 1) ? w_list_pop_head (list)
+                                            : w_list_pop_tail (list));
+        }
+    });
+
+    for (unsigned long i = 0; i < n; i++)
+        w_list_push_tail (list, (void*) i);
+
+    BENCH ("iterate", variant, n * rounds, {
+        for (unsigned long r = 0; r < rounds; r++)
+            w_list_foreach (i, list)
+                sum += (uintptr_t) *i;
+    });
+
+    /* Indexed access is O(n) for linked lists, do fewer rounds. */
+    unsigned long lookups = (backend == W_LIST_ARRAY) ? n * rounds : n * 10;
+    BENCH ("at", variant, lookups, {
+        for (unsigned long i = 0; i < lookups; i++)
+            sum += (uintptr_t) w_list_at (list, bench_rand (&seed) % n);
+    });
+
+    w_obj_unref (list);
+
+    if (sum == 42)
+        W_IO_NORESULT (w_io_format (w_stdout, "\n"));
+}
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 10000);
+    unsigned long rounds = bench_arg (argc, argv, 2, 200);
+
+    run ("linked", W_LIST_LINKED, n, rounds);
+    run ("array", W_LIST_ARRAY, n, rounds);
+    return 0;
+}
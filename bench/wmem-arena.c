@@ -0,0 +1,60 @@
+/*
+ * wmem-arena.c
+ * Parses and releases a tnetstring repeatedly, with and without an arena.
+ *
+ * Usage: bench/wmem-arena [number-of-parses]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 20000);
+    uintptr_t sum = 0;
+
+    /* A request-like dictionary with 50 string items. */
+    w_dict_t *d = w_dict_new (true);
+    for (unsigned i = 0; i < 50; i++) {
+        char key[32], val[64];
+        snprintf (key, sizeof (key), "header-%u", i);
+        snprintf (val, sizeof (val), "some value for the header number %u", i);
+        w_variant_t *v = w_variant_new (W_VARIANT_TYPE_STRING, val);
+        w_dict_set (d, key, v);
+        w_obj_unref (v);
+    }
+    w_variant_t *root = w_variant_new (W_VARIANT_TYPE_DICT, d);
+    w_buf_t input = W_BUF;
+    W_IO_NORESULT (w_tnetstr_dump (&input, root));
+    w_obj_unref (root);
+    w_obj_unref (d);
+
+    BENCH ("parse", "malloc", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            w_variant_t *v = w_tnetstr_parse (&input);
+            sum += w_dict_size (w_variant_dict (v));
+            w_obj_unref (v);
+        }
+    });
+
+    w_arena_t *arena = w_arena_new (0, 0);
+    BENCH ("parse", "arena", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            w_variant_t *v = w_tnetstr_parse_in (arena, &input);
+            sum += w_dict_size (w_variant_dict (v));
+            w_arena_clear (arena);
+        }
+    });
+    w_obj_unref (arena);
+
+    w_buf_clear (&input);
+
+    /* Prevents the compiler from optimizing away the parsing. */
+    if (sum == 42)
+        W_IO_NORESULT (w_io_format (w_stdout, "\n"));
+    return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * wmem.c
+ * Allocation-heavy operations: growing buffers, filling dictionaries and
+ * creating variants.
+ *
+ * Usage: bench/wmem [number-of-operations]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 1000000);
+    uintptr_t sum = 0;
+
+    BENCH ("append", "w_buf", n, {
+        w_buf_t buf = W_BUF;
+        for (unsigned long i = 0; i < n; i++)
+            w_buf_append_mem (&buf, "0123456789abcdef", 16);
+        sum += w_buf_size (&buf);
+        w_buf_clear (&buf);
+    });
+
+    BENCH ("small", "w_buf", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            w_buf_t buf = W_BUF;
+            w_buf_append_mem (&buf, "0123456789abcdef", 16);
+            sum += w_buf_size (&buf);
+            w_buf_clear (&buf);
+        }
+    });
+
+    char key[32];
+    w_dict_t *d = w_dict_new (false);
+    BENCH ("set", "w_dict", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            snprintf (key, sizeof (key), "key-%lu", i);
+            w_dict_set (d, key, (void*) i);
+        }
+    });
+    w_obj_unref (d);
+
+    BENCH ("new", "w_variant", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            w_variant_t *v = w_variant_new (W_VARIANT_TYPE_NUMBER, (long) i);
+            sum += w_variant_number (v);
+            w_obj_unref (v);
+        }
+    });
+
+    BENCH ("new", "w_dict", n / 100, {
+        for (unsigned long i = 0; i < n / 100; i++)
+            w_obj_unref (w_dict_new (false));
+    });
+
+    /* Prevents the compiler from optimizing away the operations. */
+    if (sum == 42)
+        W_IO_NORESULT (w_io_format (w_stdout, "\n"));
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * wobj-pool.c
+ * Creates and destroys objects at a high rate, with and without a pool.
+ *
+ * Usage: bench/wobj-pool [number-of-objects]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+
+typedef struct {
+    w_obj_t parent;
+    char    payload[48];
+} churn_t;
+
+static w_obj_pool_t churn_pool = W_OBJ_POOL (churn_t, 256);
+
+/* Objects kept alive at once, interleaving allocations and releases. */
+#define LIVE 64
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 5000000);
+    churn_t *live[LIVE] = { NULL };
+    uint64_t seed = 42;
+    uintptr_t sum = 0;
+
+    BENCH ("churn", "malloc", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            unsigned slot = bench_rand (&seed) % LIVE;
+            w_obj_unref (live[slot]);
+            live[slot] = w_obj_new (churn_t);
+            sum += (uintptr_t) live[slot];
+        }
+    });
+    for (unsigned i = 0; i < LIVE; i++)
+        live[i] = w_obj_unref (live[i]);
+
+    seed = 42;
+    BENCH ("churn", "pooled", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            unsigned slot = bench_rand (&seed) % LIVE;
+            w_obj_unref (live[slot]);
+            live[slot] = w_obj_new_pooled (&churn_pool, churn_t);
+            sum += (uintptr_t) live[slot];
+        }
+    });
+    for (unsigned i = 0; i < LIVE; i++)
+        live[i] = w_obj_unref (live[i]);
+
+    BENCH ("variant", "new+unref", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            w_variant_t *v = w_variant_new (W_VARIANT_TYPE_NUMBER, (long) i);
+            sum += (uintptr_t) w_variant_number (v);
+            w_obj_unref (v);
+        }
+    });
+
+    w_obj_pool_stats_t stats;
+    w_obj_pool_stats (&churn_pool, &stats);
+    W_IO_NORESULT (w_io_format (w_stdout,
+                                "pool: $L hits, $L misses, $L high water\n",
+                                stats.hits, stats.misses, stats.high_water));
+
+    return sum == 42;
+}
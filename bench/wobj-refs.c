@@ -0,0 +1,64 @@
+/*
+ * wobj-refs.c
+ * Cost of non-atomic and atomic reference counting on a list of objects
+ * which takes references to its items.
+ *
+ * Usage: bench/wobj-refs [number-of-items] [rounds]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+
+static void
+run (const char *variant, unsigned long n, unsigned long rounds, bool atomic)
+{
+    w_list_t *list = w_list_new (true);
+    w_obj_t **items = w_alloc (w_obj_t*, n);
+    uintptr_t sum = 0;
+
+    for (unsigned long i = 0; i < n; i++) {
+        items[i] = w_obj_new (w_obj_t);
+        if (atomic)
+            w_obj_mark_atomic (items[i]);
+    }
+
+    BENCH ("ref+unref", variant, n * rounds, {
+        for (unsigned long r = 0; r < rounds; r++)
+            for (unsigned long i = 0; i < n; i++)
+                w_obj_unref (w_obj_ref (items[i]));
+    });
+
+    /* Filling and clearing the list takes and drops a reference per item. */
+    BENCH ("list-refs", variant, n * rounds, {
+        for (unsigned long r = 0; r < rounds; r++) {
+            for (unsigned long i = 0; i < n; i++)
+                w_list_append (list, items[i]);
+            w_list_foreach (i, list)
+                sum += (uintptr_t) *i;
+            w_list_clear (list);
+        }
+    });
+
+    for (unsigned long i = 0; i < n; i++)
+        w_obj_unref (items[i]);
+    w_free (items);
+    w_obj_unref (list);
+
+    if (sum == 42)
+        W_IO_NORESULT (w_io_format (w_stdout, "\n"));
+}
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 1000);
+    unsigned long rounds = bench_arg (argc, argv, 2, 2000);
+
+    run ("plain", n, rounds, false);
+    run ("atomic", n, rounds, true);
+    return 0;
+}
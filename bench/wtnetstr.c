@@ -0,0 +1,122 @@
+/*
+ * wtnetstr.c
+ * Decoding of a large tnetstring message, copying string values or
+ * sharing the memory of the input with w_tnetstr_parse_bytes(). Then,
+ * reading a file with many short records using w_tnetstr_read(), through
+ * a buffered stream ("buffered") or from the memory-mapped file ("mmap").
+ *
+ * Usage: bench/wtnetstr [iterations] [path]
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "bench.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+int
+main (int argc, char **argv)
+{
+    unsigned long n = bench_arg (argc, argv, 1, 20000);
+    const char *path = (argc > 2) ? argv[2] : "/tmp/bench-wtnetstr.tns";
+    uintptr_t sum = 0;
+
+    /* A list of records with a few short fields and a longer body. */
+    w_list_t *records = w_list_new (true);
+    w_buf_t body = W_BUF;
+    for (unsigned i = 0; i < 1800; i++)
+        w_buf_append_char (&body, 'a' + i % 26);
+    for (unsigned i = 0; i < 40; i++) {
+        w_dict_t *record = w_dict_new (true);
+        w_variant_t *v = w_variant_new (W_VARIANT_TYPE_STRING, "some-author");
+        w_dict_set (record, "author", v);
+        w_obj_unref (v);
+        v = w_variant_new (W_VARIANT_TYPE_STRING, "A title for the record");
+        w_dict_set (record, "title", v);
+        w_obj_unref (v);
+        v = w_variant_new (W_VARIANT_TYPE_BUFFER, &body);
+        w_dict_set (record, "body", v);
+        w_obj_unref (v);
+        v = w_variant_new (W_VARIANT_TYPE_DICT, record);
+        w_list_append (records, v);
+        w_obj_unref (v);
+        w_obj_unref (record);
+    }
+    w_buf_clear (&body);
+
+    w_buf_t message = W_BUF;
+    w_variant_t *v = w_variant_new (W_VARIANT_TYPE_LIST, records);
+    if (w_io_failed (w_tnetstr_dump (&message, v))) {
+        fprintf (stderr, "Message too big\n");
+        return 1;
+    }
+    w_obj_unref (v);
+    w_obj_unref (records);
+
+    fprintf (stderr, "# message size: %zu bytes\n", w_buf_size (&message));
+    w_bytes_t *bytes = w_bytes_new (w_buf_const_data (&message),
+                                    w_buf_size (&message));
+
+    BENCH ("parse", "copy", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            v = w_tnetstr_parse (&message);
+            sum += w_list_size (w_variant_list (v));
+            w_obj_unref (v);
+        }
+    });
+
+    BENCH ("parse", "shared", n, {
+        for (unsigned long i = 0; i < n; i++) {
+            v = w_tnetstr_parse_bytes (bytes);
+            sum += w_list_size (w_variant_list (v));
+            w_obj_unref (v);
+        }
+    });
+
+    /* Each record is a short list: [number, "some-author", true]. */
+    w_io_t *fio = w_io_unix_open (path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (!fio) {
+        fprintf (stderr, "Cannot write '%s'\n", path);
+        return 1;
+    }
+    w_io_t *io = w_io_buffered_open (fio, 0, 0);
+    w_obj_unref (fio);
+
+    unsigned long count = n * 50;
+    w_buf_t payload = W_BUF;
+    for (unsigned long i = 0; i < count; i++) {
+        W_IO_NORESULT (w_tnetstr_dump_number (&payload, i));
+        W_IO_NORESULT (w_tnetstr_dump_string (&payload, "some-author"));
+        W_IO_NORESULT (w_tnetstr_dump_bool (&payload, true));
+        W_IO_NORESULT (w_io_format (io, "$I:$B]", w_buf_size (&payload), &payload));
+        w_buf_clear (&payload);
+    }
+    w_obj_unref (io);
+
+    BENCH ("read", "buffered", count, {
+        fio = w_io_unix_open (path, O_RDONLY, 0);
+        io = w_io_buffered_open (fio, 0, 0);
+        while ((v = w_tnetstr_read (io))) {
+            sum += w_list_size (w_variant_list (v));
+            w_obj_unref (v);
+        }
+        w_obj_unref (io);
+        w_obj_unref (fio);
+    });
+
+    BENCH ("read", "mmap", count, {
+        io = w_io_mmap_open (path, 0);
+        while ((v = w_tnetstr_read (io))) {
+            sum += w_list_size (w_variant_list (v));
+            w_obj_unref (v);
+        }
+        w_obj_unref (io);
+    });
+
+    unlink (path);
+    w_obj_unref (bytes);
+    w_buf_clear (&message);
+    return sum == 42;
+}
@@ -16,8 +16,10 @@ main (int argc, char *argv[])
     w_unused (argc);
     w_unused (argv);
 
-    if (w_tnetstr_read_dict (w_stdin, cfg))
+    w_io_t *input = w_io_buffered_open (w_stdin, 0, 0);
+    if (w_tnetstr_read_dict (input, cfg))
         w_die ("Could not parse input tnetstring");
+    w_obj_unref (input);
 
     W_IO_NORESULT (w_cfg_dump (cfg, w_stdout));
     w_obj_unref (cfg);
@@ -7,6 +7,7 @@
 
 #include "../wheel.h"
 #include <check.h>
+#include <limits.h>
 
 
 START_TEST (test_wbuf_init)
@@ -83,6 +84,28 @@ START_TEST (test_wbuf_append_mem)
 END_TEST
 
 
+START_TEST (test_wbuf_append_empty)
+{
+    w_buf_t b = W_BUF;
+    w_buf_t empty = W_BUF;
+
+    /* Appending nothing to a buffer without storage keeps it empty. */
+    w_buf_append_mem (&b, "", 0);
+    w_buf_append_buf (&b, &empty);
+    w_buf_append_str (&b, "");
+    ck_assert_int_eq (0, w_buf_size (&b));
+    fail_unless (w_buf_is_empty (&b), "Buffer is not empty");
+
+    w_buf_set_str (&b, "XX");
+    w_buf_append_buf (&b, &empty);
+    w_buf_append_str (&b, "");
+    ck_assert_str_eq ("XX", w_buf_str (&b));
+
+    w_buf_clear (&b);
+}
+END_TEST
+
+
 START_TEST (test_wbuf_append_char)
 {
     w_buf_t b = W_BUF;
@@ -181,6 +204,76 @@ START_TEST (test_wbuf_format)
 END_TEST
 
 
+START_TEST (test_wbuf_format_numbers)
+{
+    w_buf_t b = W_BUF;
+
+    fail_if (w_io_failed (w_buf_format (&b, "$i|$l|$I|$X|$O|$$|$c",
+                                        0, LONG_MIN, UINT_MAX, 0xCAFEUL,
+                                        8UL, 'x')),
+             "w_buf_format() should never fail at I/O");
+
+    w_buf_t expected = W_BUF;
+    w_buf_append_str (&expected, "0|");
+    w_buf_append_str (&expected, (sizeof (long) == 8)
+                      ? "-9223372036854775808" : "-2147483648");
+    w_buf_append_str (&expected, "|4294967295|CAFE|10|$|x");
+    ck_assert_str_eq (w_buf_str (&expected), w_buf_str (&b));
+
+    w_buf_clear (&expected);
+    w_buf_clear (&b);
+}
+END_TEST
+
+
+START_TEST (test_wbuf_format_double)
+{
+    w_buf_t b = W_BUF;
+
+    fail_if (w_io_failed (w_buf_format (&b, "$f|$f|$f|$f|$f",
+                                        42.0, -1234567.0, 0.5, -0.0, 1.0)),
+             "w_buf_format() should never fail at I/O");
+    ck_assert_str_eq ("42|-1234567|0.5|-0|1", w_buf_str (&b));
+
+    w_buf_clear (&b);
+}
+END_TEST
+
+
+static w_format_t static_format = W_FORMAT_STATIC ("$s=$i$$");
+
+
+START_TEST (test_wbuf_format_compiled)
+{
+    static const char *formats[] = {
+        "", "plain text", "$s", "$s: $i, $L, $X$c", "$$ and $", "100$%",
+    };
+    w_buf_t expected = W_BUF;
+    w_buf_t b = W_BUF;
+
+    for (unsigned i = 0; i < w_lengthof (formats); i++) {
+        w_format_t *f = w_format_compile (formats[i]);
+        W_IO_NORESULT (w_buf_format (&expected, formats[i],
+                                     "str", -42, 42UL, 0xFFUL, '!'));
+        W_IO_NORESULT (w_buf_format_compiled (&b, f,
+                                              "str", -42, 42UL, 0xFFUL, '!'));
+        ck_assert_str_eq (w_buf_str (&expected), w_buf_str (&b));
+        w_buf_clear (&expected);
+        w_buf_clear (&b);
+        w_obj_unref (f);
+    }
+
+    /* Static formats are compiled on first use. */
+    fail_unless (static_format.ops == NULL, "Static format was compiled");
+    W_IO_NORESULT (w_buf_format_compiled (&b, &static_format, "answer", 42));
+    fail_if (static_format.ops == NULL, "Static format was not compiled");
+    W_IO_NORESULT (w_buf_format_compiled (&b, &static_format, ", half", 21));
+    ck_assert_str_eq ("answer=42$, half=21$", w_buf_str (&b));
+    w_buf_clear (&b);
+}
+END_TEST
+
+
 START_TEST (test_wbuf_format_buf)
 {
     w_buf_t b1 = W_BUF;
@@ -216,3 +309,89 @@ START_TEST (test_wbuf_format_multiple)
     w_buf_clear (&b);
 }
 END_TEST
+
+
+START_TEST (test_wbuf_growth)
+{
+    w_buf_t b = W_BUF;
+    unsigned reallocs = 0;
+    char *data = NULL;
+
+    for (unsigned i = 0; i < 1024 * 1024; i++) {
+        w_buf_append_char (&b, 'a' + i % 26);
+        if (w_buf_data (&b) != data) {
+            data = w_buf_data (&b);
+            reallocs++;
+        }
+    }
+    ck_assert_int_eq (1024 * 1024, w_buf_size (&b));
+    fail_unless (reallocs < 64, "Too many reallocations (%u)", reallocs);
+    fail_unless (b.alloc >= w_buf_size (&b), "Allocation is too small");
+    ck_assert_int_eq ('a' + 12345 % 26, w_buf_data (&b)[12345]);
+
+    /* Shrinking the contents does not release memory. */
+    w_buf_resize (&b, 10);
+    fail_unless (b.alloc >= 1024 * 1024, "Memory was released");
+
+    w_buf_shrink_to_fit (&b);
+    ck_assert_int_eq (W_BUF_INLINE_SIZE > 10 ? W_BUF_INLINE_SIZE - 1 : 10,
+                      b.alloc);
+    ck_assert_str_eq ("abcdefghij", w_buf_str (&b));
+
+    w_buf_clear (&b);
+}
+END_TEST
+
+
+START_TEST (test_wbuf_reserve)
+{
+    w_buf_t b = W_BUF;
+
+    w_buf_reserve (&b, 1000);
+    ck_assert_int_eq (1000, b.alloc);
+    ck_assert_int_eq (0, w_buf_size (&b));
+
+    char *data = w_buf_data (&b);
+    for (unsigned i = 0; i < 100; i++)
+        w_buf_append_str (&b, "0123456789");
+    fail_unless (data == w_buf_data (&b), "Buffer was reallocated");
+
+    /* Reserving less than the allocated size does nothing. */
+    w_buf_reserve (&b, 10);
+    ck_assert_int_eq (1000, b.alloc);
+
+    w_buf_resize (&b, 0);
+    w_buf_shrink_to_fit (&b);
+    fail_if (w_buf_data (&b), "Empty buffer was not released");
+    ck_assert_int_eq (0, b.alloc);
+}
+END_TEST
+
+
+START_TEST (test_wbuf_inline)
+{
+#if W_BUF_INLINE_SIZE > 8
+    w_buf_t b = W_BUF;
+
+    w_buf_set_str (&b, "short");
+    fail_unless (w_buf_data (&b) == b.inline_data, "Contents are not inline");
+    ck_assert_str_eq ("short", w_buf_cstr (&b));
+    fail_unless (w_buf_data (&b) == b.inline_data, "Contents were moved");
+
+    /* Growing moves the contents to the heap. */
+    for (unsigned i = 0; i < W_BUF_INLINE_SIZE; i++)
+        w_buf_append_char (&b, '.');
+    fail_if (w_buf_data (&b) == b.inline_data, "Contents are inline");
+    ck_assert_int_eq (5 + W_BUF_INLINE_SIZE, w_buf_size (&b));
+    fail_unless (!memcmp ("short...", w_buf_data (&b), 8), "Wrong contents");
+    w_buf_clear (&b);
+
+    /* Strings returned by w_buf_str() can be freed. */
+    w_buf_set_str (&b, "short");
+    char *str = w_buf_str (&b);
+    fail_if (str == b.inline_data, "String was not moved to the heap");
+    ck_assert_str_eq ("short", str);
+    w_free (str);
+#endif /* W_BUF_INLINE_SIZE > 8 */
+}
+END_TEST
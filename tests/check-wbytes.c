@@ -0,0 +1,198 @@
+/*
+ * check-wbytes.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../wheel.h"
+#include <check.h>
+
+
+#define REFS(_o) (((w_obj_t*) (_o))->__refs & ~W__OBJ_FLAGS)
+
+
+START_TEST (test_wbytes_new)
+{
+    static const char data[] = "Hello, world";
+    w_bytes_t *b = w_bytes_new (data, w_lengthof (data) - 1);
+    ck_assert_int_eq (w_lengthof (data) - 1, w_bytes_size (b));
+    fail_if (w_bytes_data (b) == data, "Data was not copied");
+    fail_if (memcmp (data, w_bytes_data (b), w_bytes_size (b)));
+    fail_unless (w_bytes_owner (b) == b, "Owner is not the object itself");
+    w_obj_unref (b);
+
+    b = w_bytes_new (NULL, 0);
+    ck_assert_int_eq (0, w_bytes_size (b));
+    w_obj_unref (b);
+}
+END_TEST
+
+
+START_TEST (test_wbytes_from_buf)
+{
+    w_buf_t buf = W_BUF;
+    for (unsigned i = 0; i < 100; i++)
+        w_buf_append_char (&buf, 'a' + i % 26);
+    const char *data = w_buf_const_data (&buf);
+
+    w_bytes_t *b = w_bytes_new_from_buf (&buf);
+    fail_unless (w_bytes_data (b) == data, "Heap contents were copied");
+    ck_assert_int_eq (100, w_bytes_size (b));
+    ck_assert_int_eq (0, w_buf_size (&buf));
+    fail_unless (w_buf_const_data (&buf) == NULL, "Buffer was not reset");
+    w_obj_unref (b);
+
+    /* Short contents may be stored inline, and get copied. */
+    w_buf_set_str (&buf, "short");
+    b = w_bytes_new_from_buf (&buf);
+    ck_assert_int_eq (5, w_bytes_size (b));
+    fail_if (memcmp ("short", w_bytes_data (b), 5));
+    ck_assert_int_eq (0, w_buf_size (&buf));
+    w_buf_set_str (&buf, "reused");
+    ck_assert_str_eq ("reused", w_buf_cstr (&buf));
+    w_buf_clear (&buf);
+    w_obj_unref (b);
+
+    /* Memory from arenas is copied. */
+    w_arena_t *arena = w_arena_new (0, 0);
+    w_buf_t abuf = W_BUF_ARENA (arena);
+    w_buf_set_str (&abuf, "from an arena");
+    b = w_bytes_new_from_buf (&abuf);
+    w_obj_unref (arena);
+    ck_assert_int_eq (13, w_bytes_size (b));
+    fail_if (memcmp ("from an arena", w_bytes_data (b), 13));
+    w_obj_unref (b);
+}
+END_TEST
+
+
+START_TEST (test_wbytes_slice)
+{
+    static const char data[] = "Hello, world";
+    w_bytes_t *b = w_bytes_new (data, w_lengthof (data) - 1);
+
+    w_bytes_t *s = w_bytes_slice (b, 7, 5);
+    ck_assert_int_eq (2, REFS (b));
+    ck_assert_int_eq (5, w_bytes_size (s));
+    fail_unless (w_bytes_data (s) == w_bytes_data (b) + 7, "Data was copied");
+    fail_unless (w_bytes_owner (s) == b, "Owner is not the parent");
+
+    /* Slices of slices reference the owner of the memory directly. */
+    w_bytes_t *ss = w_bytes_slice (s, 1, 3);
+    ck_assert_int_eq (3, REFS (b));
+    ck_assert_int_eq (1, REFS (s));
+    fail_unless (w_bytes_owner (ss) == b, "Owner is not the root parent");
+    fail_if (memcmp ("orl", w_bytes_data (ss), 3));
+
+    /* Slices keep the memory alive. */
+    w_obj_unref (b);
+    w_obj_unref (s);
+    ck_assert_int_eq (1, REFS (w_bytes_owner (ss)));
+    fail_if (memcmp ("orl", w_bytes_data (ss), 3));
+
+    w_bytes_t *e = w_bytes_slice (ss, 3, 0);
+    ck_assert_int_eq (0, w_bytes_size (e));
+    w_obj_unref (ss);
+    w_obj_unref (e);
+}
+END_TEST
+
+
+START_TEST (test_wbytes_io_dict)
+{
+    w_bytes_t *b = w_bytes_new ("keykey2", 7);
+    w_bytes_t *k1 = w_bytes_slice (b, 0, 3);
+    w_bytes_t *k2 = w_bytes_slice (b, 3, 4);
+
+    w_buf_t out = W_BUF;
+    w_io_buf_t iobuf;
+    w_io_buf_init (&iobuf, &out, false);
+    w_io_result_t r = w_io_write_bytes ((w_io_t*) &iobuf, k2);
+    ck_assert_int_eq (4, w_io_result_bytes (r));
+    ck_assert_str_eq ("key2", w_buf_cstr (&out));
+    w_buf_clear (&out);
+
+    w_dict_t *d = w_dict_new (false);
+    w_dict_setb (d, k1, "one");
+    w_dict_setb (d, k2, "two");
+    ck_assert_str_eq ("one", (const char*) w_dict_get (d, "key"));
+    ck_assert_str_eq ("two", (const char*) w_dict_getb (d, k2));
+    w_dict_delb (d, k1);
+    fail_unless (w_dict_getb (d, k1) == NULL, "Item was not deleted");
+    w_obj_unref (d);
+
+    w_obj_unref (k1);
+    w_obj_unref (k2);
+    w_obj_unref (b);
+}
+END_TEST
+
+
+START_TEST (test_wbytes_variant)
+{
+    w_bytes_t *b = w_bytes_new ("Hello, world", 12);
+    w_bytes_t *s = w_bytes_slice (b, 0, 5);
+
+    w_variant_t *v = w_variant_new (W_VARIANT_TYPE_BYTES, s);
+    w_obj_unref (s);
+    fail_unless (w_variant_is_string (v), "Variant is not a string");
+    ck_assert_int_eq (2, REFS (b));
+    ck_assert_int_eq (5, w_buf_size (w_variant_buffer (v)));
+    fail_unless (w_buf_const_data (w_variant_buffer (v)) == w_bytes_data (b),
+                 "Variant does not share memory");
+
+    /* Getting a C string copies the contents, which are not shared anymore. */
+    ck_assert_str_eq ("Hello", w_variant_string (v));
+    ck_assert_int_eq (1, REFS (b));
+    w_obj_unref (v);
+
+    v = w_variant_new (W_VARIANT_TYPE_NULL);
+    w_variant_set_bytes (v, b);
+    ck_assert_int_eq (2, REFS (b));
+    w_variant_set_number (v, 42);
+    ck_assert_int_eq (1, REFS (b));
+    w_variant_set_bytes (v, b);
+    w_obj_unref (v);
+    ck_assert_int_eq (1, REFS (b));
+
+    w_obj_unref (b);
+}
+END_TEST
+
+
+START_TEST (test_wbytes_tnetstr)
+{
+    static const char data[] = "40:4:name,5:wheel,4:tags,14:4:fast,4:tiny,]}";
+    w_bytes_t *b = w_bytes_new (data, w_lengthof (data) - 1);
+
+    w_io_result_t r;
+    w_variant_t *v = w_tnetstr_parse_bytes (b);
+    fail_unless (v != NULL, "Parsing failed");
+    fail_unless (w_variant_is_dict (v), "Value is not a dict");
+
+    /* Strings share the memory of the input, and keep it alive. */
+    w_obj_unref (b);
+    w_variant_t *name = w_dict_get (w_variant_dict (v), "name");
+    const w_buf_t *nbuf = w_variant_buffer (name);
+    ck_assert_int_eq (5, w_buf_size (nbuf));
+    fail_unless (w_buf_const_data (nbuf) >= w_bytes_data (name->shared) &&
+                 w_buf_const_data (nbuf) < w_bytes_data (name->shared) + 44,
+                 "String value was copied");
+    fail_if (memcmp ("wheel", w_buf_const_data (nbuf), 5));
+
+    w_variant_t *tags = w_dict_get (w_variant_dict (v), "tags");
+    w_list_t *list = w_variant_list (tags);
+    ck_assert_int_eq (2, w_list_size (list));
+    ck_assert_str_eq ("fast", w_variant_string (w_list_at (list, 0)));
+    ck_assert_str_eq ("tiny", w_variant_string (w_list_at (list, 1)));
+
+    w_buf_t out = W_BUF;
+    r = w_tnetstr_dump (&out, v);
+    fail_if (w_io_failed (r));
+    ck_assert_int_eq (w_lengthof (data) - 1, w_buf_size (&out));
+    w_buf_clear (&out);
+
+    w_obj_unref (v);
+}
+END_TEST
@@ -24,6 +24,43 @@ START_TEST (test_wcfg_load_empty)
 END_TEST
 
 
+START_TEST (test_wcfg_freeze)
+{
+    static const char input[] =
+        "name \"wheel\"\n"
+        "version 2\n"
+        "build { flags { debug 1 } jobs 4 }\n";
+    w_io_mem_t iomem;
+    w_io_mem_init (&iomem, (uint8_t*) input, w_lengthof (input) - 1);
+
+    char *message = NULL;
+    w_cfg_t *cf = w_cfg_load ((w_io_t*) &iomem, &message);
+    fail_if (cf == NULL, "w_cfg_load failed: %s", message);
+
+    w_cfg_t *frozen = w_cfg_freeze (cf);
+    w_obj_unref (cf);
+
+    const char *name = NULL;
+    double version = 0, jobs = 0;
+    fail_unless (w_cfg_get (frozen,
+                            W_CFG_STRING, "name", &name,
+                            W_CFG_NUMBER, "version", &version,
+                            W_CFG_NUMBER, "build.jobs", &jobs,
+                            W_CFG_END),
+                 "w_cfg_get failed on a frozen configuration");
+    ck_assert_str_eq ("wheel", name);
+    fail_unless (version == 2, "Wrong value for 'version'");
+    fail_unless (jobs == 4, "Wrong value for 'build.jobs'");
+    fail_unless (w_cfg_isnode (frozen, "build.flags"),
+                 "'build.flags' is not a node");
+    fail_unless (w_cfg_isnone (frozen, "build.missing"),
+                 "Unexpected 'build.missing' node");
+
+    w_obj_unref (frozen);
+}
+END_TEST
+
+
 #define S_(_x) { (uint8_t*) (_x), (w_lengthof (_x) - 1) }
 static const struct {
     uint8_t *data;
@@ -0,0 +1,87 @@
+/*
+ * check-wdeque.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../wheel.h"
+#include <check.h>
+
+
+START_TEST (test_wdeque_push_pop)
+{
+    w_deque_t *d = w_deque_new (false);
+    fail_unless (w_deque_is_empty (d), "New deque is not empty");
+
+    /* Wrap around the ring buffer while growing it. */
+    for (long i = 1; i <= 100; i++) {
+        w_deque_push_tail (d, (void*) i);
+        w_deque_push_head (d, (void*) -i);
+    }
+    ck_assert_int_eq (200, w_deque_size (d));
+    ck_assert_int_eq (-100, (long) w_deque_head (d));
+    ck_assert_int_eq (100, (long) w_deque_tail (d));
+    ck_assert_int_eq (-1, (long) w_deque_at (d, 99));
+    ck_assert_int_eq (1, (long) w_deque_at (d, 100));
+    ck_assert_int_eq (99, (long) w_deque_at (d, -2));
+
+    for (long i = 100; i > 0; i--) {
+        ck_assert_int_eq (i, (long) w_deque_pop_tail (d));
+        ck_assert_int_eq (-i, (long) w_deque_pop_head (d));
+    }
+    fail_unless (w_deque_is_empty (d), "Deque is not empty");
+
+    /* Steady state: the buffer is not reallocated. */
+    void **items = d->items;
+    for (long i = 0; i < 1000; i++) {
+        w_deque_push_tail (d, (void*) i);
+        ck_assert_int_eq (i, (long) w_deque_pop_head (d));
+    }
+    fail_unless (items == d->items, "Buffer was reallocated");
+
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdeque_del_at)
+{
+    w_deque_t *d = w_deque_new (false);
+
+    for (long i = 0; i < 10; i++)
+        w_deque_push_tail (d, (void*) i);
+
+    w_deque_del_at (d, 2);
+    w_deque_del_at (d, -3);
+    w_deque_del_at (d, 0);
+    w_deque_del_at (d, -1);
+    ck_assert_int_eq (6, w_deque_size (d));
+
+    const long expected[] = { 1, 3, 4, 5, 6, 8 };
+    for (unsigned i = 0; i < w_lengthof (expected); i++)
+        ck_assert_int_eq (expected[i], (long) w_deque_at (d, i));
+
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdeque_refs)
+{
+    w_deque_t *d = w_deque_new (true);
+    w_obj_t *obj = w_obj_new (w_obj_t);
+
+    for (unsigned i = 0; i < 10; i++)
+        w_deque_push_head (d, obj);
+    ck_assert_int_eq (11, obj->__refs & ~W__OBJ_FLAGS);
+
+    w_deque_del_at (d, 4);
+    w_obj_unref (w_deque_pop_tail (d));
+    ck_assert_int_eq (9, obj->__refs & ~W__OBJ_FLAGS);
+
+    w_obj_unref (d);
+    ck_assert_int_eq (1, obj->__refs & ~W__OBJ_FLAGS);
+    w_obj_unref (obj);
+}
+END_TEST
@@ -6,6 +6,11 @@
  */
 
 #include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include "../wheel.h"
 
@@ -201,3 +206,552 @@ START_TEST (test_wdict_iter)
     w_obj_unref (d);
 }
 END_TEST
+
+
+START_TEST (test_wdict_open_get_set)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, W_DICT_OPEN_ADDRESSING);
+
+    w_dict_set (d, "foo", "FOO");
+    w_dict_set (d, "bar", "BAR");
+    fail_unless (w_dict_size (d) == 2,
+                 "Expected two items in dict");
+    fail_if (strcmp ("FOO", w_dict_get (d, "foo")),
+             "String 'FOO' does not match");
+    fail_if (strcmp ("BAR", w_dict_get (d, "bar")),
+             "String 'BAR' does not match");
+    fail_if (strcmp ("FOO", w_dict_getn (d, "foobar", 3)),
+             "String 'FOO' does not match (getn)");
+    fail_unless (w_dict_get (d, "fo") == NULL,
+                 "Prefix of a key must not match");
+    fail_unless (w_dict_get (d, "baz") == NULL,
+                 "Missing key returned a value");
+
+    w_dict_set (d, "foo", "BAZINGA");
+    fail_unless (w_dict_size (d) == 2,
+                 "Expected two items in dict");
+    fail_if (strcmp ("BAZINGA", w_dict_get (d, "foo")),
+             "String 'BAZINGA' does not match");
+
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdict_open_del)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, W_DICT_OPEN_ADDRESSING);
+
+    w_dict_set (d, "no.1", (void*) 1);
+    w_dict_set (d, "no.2", (void*) 2);
+    w_dict_set (d, "no.3", (void*) 3);
+
+    w_dict_del (d, "no.2");
+    fail_unless (w_dict_size (d) == 2,
+                 "Expected 2 items in dict");
+    fail_unless (w_dict_get (d, "no.2") == NULL,
+                 "Deleted key is still present");
+    fail_unless (w_dict_get (d, "no.3") == (void*) 3,
+                 "Key 'no.3' lost after deletion");
+
+    w_dict_deln (d, "no.1234", 4);
+    fail_unless (w_dict_size (d) == 1,
+                 "Expected 1 item in dict");
+
+    w_dict_set (d, "no.2", (void*) 22);
+    fail_unless (w_dict_get (d, "no.2") == (void*) 22,
+                 "Key 'no.2' not re-added");
+
+    w_dict_clear (d);
+    fail_unless (w_dict_size (d) == 0,
+                 "Expected 0 items in dict");
+    fail_unless (w_dict_get (d, "no.3") == NULL,
+                 "Key 'no.3' present after clear");
+
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdict_open_grow)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, W_DICT_OPEN_ADDRESSING);
+    char key[32];
+
+    for (unsigned long i = 0; i < 5000; i++) {
+        snprintf (key, sizeof (key), "key-%lu", i);
+        w_dict_set (d, key, (void*) (i + 1));
+    }
+    fail_unless (w_dict_size (d) == 5000,
+                 "Expected 5000 items, got %zu", w_dict_size (d));
+
+    /* Delete and re-add keys many times, to exercise tombstones. */
+    for (unsigned round = 0; round < 4; round++) {
+        for (unsigned long i = 0; i < 5000; i += 2) {
+            snprintf (key, sizeof (key), "key-%lu", i);
+            w_dict_del (d, key);
+        }
+        fail_unless (w_dict_size (d) == 2500,
+                     "Expected 2500 items, got %zu", w_dict_size (d));
+        for (unsigned long i = 0; i < 5000; i += 2) {
+            snprintf (key, sizeof (key), "key-%lu", i);
+            w_dict_set (d, key, (void*) (i + 1));
+        }
+    }
+
+    for (unsigned long i = 0; i < 5000; i++) {
+        snprintf (key, sizeof (key), "key-%lu", i);
+        fail_unless (w_dict_get (d, key) == (void*) (i + 1),
+                     "Wrong value for key '%s'", key);
+    }
+
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdict_open_iter)
+{
+    w_dict_t *c = w_dict_new_with_backend (false, W_DICT_CHAINED);
+    w_dict_t *o = w_dict_new_with_backend (false, W_DICT_OPEN_ADDRESSING);
+    char key[32];
+
+    for (unsigned long i = 0; i < 500; i++) {
+        snprintf (key, sizeof (key), "item.%lu", i);
+        w_dict_set (c, key, (void*) i);
+        w_dict_set (o, key, (void*) i);
+    }
+    w_dict_del (c, "item.42");
+    w_dict_del (o, "item.42");
+
+    w_iterator_t ic = w_dict_first (c);
+    w_dict_foreach (io, o) {
+        fail_unless (ic != NULL, "Open dict has more items");
+        ck_assert_str_eq (w_dict_iterator_get_key (ic),
+                          w_dict_iterator_get_key (io));
+        fail_unless (*ic == *io, "Values do not match");
+        ic = w_dict_next (c, ic);
+    }
+    fail_unless (ic == NULL, "Chained dict has more items");
+
+    w_obj_unref (c);
+    w_obj_unref (o);
+}
+END_TEST
+
+
+static void
+check_incremental_rehash (w_dict_backend_t backend, unsigned factor)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, backend);
+    bool saw_pending = false;
+    char key[32];
+
+    w_dict_set_growth (d, factor, true);
+
+    for (unsigned long i = 0; i < 20000; i++) {
+        snprintf (key, sizeof (key), "key-%lu", i);
+        w_dict_set (d, key, (void*) (i + 1));
+        if (w_dict_rehash_pending (d))
+            saw_pending = true;
+
+        /* Items must be reachable while the rehash is ongoing. */
+        if (i % 97 == 0) {
+            snprintf (key, sizeof (key), "key-%lu", i / 2);
+            fail_unless (w_dict_get (d, key) == (void*) (i / 2 + 1),
+                         "Key '%s' not found during rehash", key);
+        }
+        if (i % 5 == 0) {
+            snprintf (key, sizeof (key), "key-%lu", i / 3);
+            w_dict_del (d, key);
+            w_dict_set (d, key, (void*) (i / 3 + 1));
+        }
+    }
+    fail_unless (saw_pending, "Rehash was not done incrementally");
+    fail_unless (w_dict_size (d) == 20000,
+                 "Expected 20000 items, got %zu", w_dict_size (d));
+
+    unsigned long count = 0;
+    w_dict_foreach (i, d)
+        count++;
+    fail_unless (count == 20000,
+                 "Iterated over %lu items, expected 20000", count);
+
+    for (unsigned long i = 0; i < 20000; i++) {
+        snprintf (key, sizeof (key), "key-%lu", i);
+        fail_unless (w_dict_get (d, key) == (void*) (i + 1),
+                     "Wrong value for key '%s'", key);
+    }
+    fail_unless (w_dict_rehash_pending (d) == 0,
+                 "Rehash did not finish after lookups");
+
+    w_obj_unref (d);
+}
+
+
+START_TEST (test_wdict_rehash_incremental_chained)
+{
+    check_incremental_rehash (W_DICT_CHAINED, 0);
+    check_incremental_rehash (W_DICT_CHAINED, 2);
+}
+END_TEST
+
+
+START_TEST (test_wdict_rehash_incremental_open)
+{
+    check_incremental_rehash (W_DICT_OPEN_ADDRESSING, 0);
+    check_incremental_rehash (W_DICT_OPEN_ADDRESSING, 4);
+}
+END_TEST
+
+
+START_TEST (test_wdict_rehash_finish)
+{
+    w_dict_t *d = w_dict_new (false);
+    char key[32];
+
+    w_dict_set_growth (d, 0, true);
+    for (unsigned long i = 0; w_dict_rehash_pending (d) == 0; i++) {
+        snprintf (key, sizeof (key), "key-%lu", i);
+        w_dict_set (d, key, (void*) (i + 1));
+    }
+
+    /* Disabling incremental mode completes the ongoing rehash. */
+    w_dict_set_growth (d, 0, false);
+    fail_unless (w_dict_rehash_pending (d) == 0,
+                 "Rehash still pending");
+
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdict_binkey_chained)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, W_DICT_CHAINED);
+
+    w_dict_setn (d, "a\0b", 3, "A-B");
+    w_dict_setn (d, "a\0c", 3, "A-C");
+    w_dict_set (d, "a", "A");
+    fail_unless (w_dict_size (d) == 3,
+                 "Expected 3 items in dict");
+    ck_assert_str_eq ("A-B", w_dict_getn (d, "a\0b", 3));
+    ck_assert_str_eq ("A-C", w_dict_getn (d, "a\0c", 3));
+    ck_assert_str_eq ("A", w_dict_get (d, "a"));
+    fail_unless (w_dict_getn (d, "a\0d", 3) == NULL,
+                 "Unexpected match for binary key");
+
+    w_dict_foreach (i, d) {
+        if (w_dict_iterator_get_keylen (i) == 3)
+            fail_unless (w_dict_iterator_get_key (i)[1] == '\0',
+                         "Binary key not preserved");
+    }
+
+    w_dict_deln (d, "a\0b", 3);
+    fail_unless (w_dict_getn (d, "a\0b", 3) == NULL,
+                 "Binary key not deleted");
+    ck_assert_str_eq ("A-C", w_dict_getn (d, "a\0c", 3));
+
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdict_binkey_open)
+{
+    w_dict_t *d = w_dict_new_with_backend (false, W_DICT_OPEN_ADDRESSING);
+    w_dict_t *c = w_dict_new (false);
+
+    w_dict_setn (d, "x\0y", 3, "X-Y");
+    w_dict_set (d, "x", "X");
+    ck_assert_str_eq ("X-Y", w_dict_getn (d, "x\0y", 3));
+    ck_assert_str_eq ("X", w_dict_get (d, "x"));
+
+    /* Copying must keep the full length of the keys. */
+    w_dict_update (c, d);
+    fail_unless (w_dict_size (c) == 2,
+                 "Expected 2 items in dict");
+    ck_assert_str_eq ("X-Y", w_dict_getn (c, "x\0y", 3));
+
+    w_obj_unref (c);
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdict_slab_basic)
+{
+    w_dict_t *d = w_dict_new (false);
+    char key[1024];
+
+    w_dict_set_slab (d, true);
+
+    /* Mix of small keys and keys too big to be allocated from the slab. */
+    for (unsigned long i = 0; i < 3000; i++) {
+        size_t len = 1 + (i * 7) % (sizeof (key) - 32);
+        memset (key, 'k', len);
+        snprintf (key + len, sizeof (key) - len, "%lu", i);
+        w_dict_set (d, key, (void*) (i + 1));
+    }
+    fail_unless (w_dict_size (d) == 3000,
+                 "Expected 3000 items, got %zu", w_dict_size (d));
+
+    for (unsigned long i = 0; i < 3000; i++) {
+        size_t len = 1 + (i * 7) % (sizeof (key) - 32);
+        memset (key, 'k', len);
+        snprintf (key + len, sizeof (key) - len, "%lu", i);
+        fail_unless (w_dict_get (d, key) == (void*) (i + 1),
+                     "Wrong value for key #%lu", i);
+        if (i % 3 == 0)
+            w_dict_del (d, key);
+    }
+    fail_unless (w_dict_size (d) == 2000,
+                 "Expected 2000 items, got %zu", w_dict_size (d));
+
+    /* Memory of deleted items gets reused. */
+    for (unsigned long i = 0; i < 1000; i++) {
+        snprintf (key, sizeof (key), "new-%lu", i);
+        w_dict_set (d, key, (void*) i);
+    }
+    fail_unless (w_dict_size (d) == 3000,
+                 "Expected 3000 items, got %zu", w_dict_size (d));
+    ck_assert_int_eq ((uintptr_t) w_dict_get (d, "new-999"), 999);
+
+    w_dict_clear (d);
+    fail_unless (w_dict_size (d) == 0,
+                 "Expected 0 items in dict");
+    w_dict_set (d, "foo", "FOO");
+    ck_assert_str_eq ("FOO", w_dict_get (d, "foo"));
+
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdict_slab_refs)
+{
+    w_dict_t *d = w_dict_new_with_backend (true, W_DICT_OPEN_ADDRESSING);
+    w_dict_set_slab (d, true);
+
+    for (unsigned i = 0; i < 100; i++) {
+        char key[16];
+        w_dict_t *value = w_dict_new (false);
+        snprintf (key, sizeof (key), "d%u", i);
+        w_dict_set (d, key, value);
+        w_obj_unref (value);
+    }
+    w_dict_del (d, "d42");
+    fail_unless (w_dict_size (d) == 99,
+                 "Expected 99 items, got %zu", w_dict_size (d));
+
+    /* Values are released along with the slab. */
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdict_frozen_get)
+{
+    w_dict_t *d = w_dict_new (false);
+    char key[32];
+
+    for (unsigned long i = 0; i < 5000; i++) {
+        snprintf (key, sizeof (key), "key-%lu", i);
+        w_dict_set (d, key, (void*) (i + 1));
+    }
+    w_dict_setn (d, "a\0b", 3, (void*) 42);
+
+    w_dict_t *f = w_dict_freeze (d);
+    fail_unless (w_dict_size (f) == w_dict_size (d),
+                 "Expected %zu items, got %zu",
+                 w_dict_size (d), w_dict_size (f));
+
+    for (unsigned long i = 0; i < 5000; i++) {
+        snprintf (key, sizeof (key), "key-%lu", i);
+        fail_unless (w_dict_get (f, key) == (void*) (i + 1),
+                     "Wrong value for key '%s'", key);
+        snprintf (key, sizeof (key), "nokey-%lu", i);
+        fail_unless (w_dict_get (f, key) == NULL,
+                     "Unexpected value for key '%s'", key);
+    }
+    ck_assert_int_eq ((uintptr_t) w_dict_getn (f, "a\0b", 3), 42);
+    fail_unless (w_dict_getn (f, "a", 1) == NULL,
+                 "Unexpected value for key 'a'");
+
+    /* Items are iterated in the same order. */
+    w_iterator_t j = w_dict_first (f);
+    w_dict_foreach (i, d) {
+        fail_unless (j != NULL, "Frozen dictionary has less items");
+        fail_unless (*i == *j, "Items iterated in different order");
+        j = w_dict_next (f, j);
+    }
+    fail_unless (j == NULL, "Frozen dictionary has more items");
+
+    w_obj_unref (d);
+    w_obj_unref (f);
+}
+END_TEST
+
+
+START_TEST (test_wdict_frozen_small)
+{
+    w_dict_t *d = w_dict_new (false);
+    w_dict_t *f = w_dict_freeze (d);
+    fail_unless (w_dict_is_empty (f), "Frozen dictionary is not empty");
+    fail_unless (w_dict_get (f, "foo") == NULL, "Unexpected value");
+    fail_unless (w_dict_first (f) == NULL, "Unexpected first item");
+    w_obj_unref (f);
+
+    w_dict_set (d, "foo", "FOO");
+    f = w_dict_freeze (d);
+    ck_assert_str_eq ("FOO", w_dict_get (f, "foo"));
+    fail_unless (w_dict_get (f, "bar") == NULL, "Unexpected value");
+    w_obj_unref (f);
+    w_obj_unref (d);
+}
+END_TEST
+
+
+START_TEST (test_wdict_frozen_refs)
+{
+    w_dict_t *d = w_dict_new (true);
+    w_dict_t *value = w_dict_new (false);
+    w_dict_set (d, "value", value);
+
+    w_dict_t *f = w_dict_freeze (d);
+    w_obj_unref (d);
+    fail_unless (w_dict_get (f, "value") == value,
+                 "Value not kept alive by the frozen dictionary");
+    fail_unless ((value->parent.__refs & ~W__OBJ_FLAGS) == 2,
+                 "Expected 2 references, got %zu",
+                 value->parent.__refs & ~W__OBJ_FLAGS);
+
+    w_obj_unref (f);
+    w_obj_unref (value);
+}
+END_TEST
+
+
+static char*
+save_image (const w_dict_t *d)
+{
+    char *path = w_str_dup ("check-wdict-image.XXXXXX");
+    int fd = mkstemp (path);
+    fail_unless (fd >= 0, "Cannot create temporary file");
+
+    w_io_t *io = w_io_unix_open_fd (fd);
+    fail_if (w_io_failed (w_dict_save_image (d, io)),
+             "Cannot save dictionary image");
+    w_obj_unref (io);
+    return path;
+}
+
+
+START_TEST (test_wdict_image)
+{
+    w_dict_t *d = w_dict_new (true);
+    char key[32];
+
+    for (long i = 0; i < 2000; i++) {
+        snprintf (key, sizeof (key), "key-%li", i);
+        w_variant_t *value = w_variant_new (W_VARIANT_TYPE_NUMBER, i);
+        w_dict_set (d, key, value);
+        w_obj_unref (value);
+    }
+    w_variant_t *value = w_variant_new (W_VARIANT_TYPE_STRING, "Hello");
+    w_dict_setn (d, "a\0b", 3, value);
+    w_obj_unref (value);
+
+    char *path = save_image (d);
+    w_dict_image_t *image = w_dict_map_image (path);
+    unlink (path);
+    w_free (path);
+
+    fail_unless (image != NULL, "Cannot map dictionary image");
+    fail_unless (w_dict_image_size (image) == w_dict_size (d),
+                 "Expected %zu items, got %zu",
+                 w_dict_size (d), w_dict_image_size (image));
+    w_obj_unref (d);
+
+    for (long i = 0; i < 2000; i++) {
+        snprintf (key, sizeof (key), "key-%li", i);
+        value = w_dict_image_get_variant (image, key);
+        fail_unless (value != NULL, "No value for key '%s'", key);
+        fail_unless (w_variant_is_number (value), "Value is not a number");
+        ck_assert_int_eq (i, w_variant_number (value));
+        w_obj_unref (value);
+
+        snprintf (key, sizeof (key), "nokey-%li", i);
+        fail_unless (w_dict_image_get_variant (image, key) == NULL,
+                     "Unexpected value for key '%s'", key);
+    }
+
+    w_buf_t buf;
+    fail_if (w_dict_image_getn (image, "a\0b", 3, &buf),
+             "No value for binary key");
+    fail_unless (w_buf_size (&buf) == 8 &&
+                 !memcmp ("5:Hello,", w_buf_const_data (&buf), 8),
+                 "Wrong encoded value for binary key");
+    fail_unless (w_dict_image_getn (image, "a", 1, &buf),
+                 "Unexpected value for key 'a'");
+
+    w_obj_unref (image);
+}
+END_TEST
+
+
+START_TEST (test_wdict_image_invalid)
+{
+    w_dict_t *d = w_dict_new (true);
+    char *path = save_image (d);
+    w_obj_unref (d);
+
+    w_dict_image_t *image = w_dict_map_image (path);
+    fail_unless (image != NULL, "Cannot map empty dictionary image");
+    fail_unless (w_dict_image_size (image) == 0, "Image is not empty");
+    fail_unless (w_dict_image_get_variant (image, "foo") == NULL,
+                 "Unexpected value in empty image");
+    w_obj_unref (image);
+    unlink (path);
+    w_free (path);
+
+    /* Displacements which do not map to a valid slot. */
+    d = w_dict_new (true);
+    w_variant_t *value = w_variant_new (W_VARIANT_TYPE_NUMBER, 42);
+    w_dict_set (d, "foo", value);
+    w_obj_unref (value);
+    path = save_image (d);
+    w_obj_unref (d);
+
+    int fd = open (path, O_RDWR);
+    fail_unless (fd >= 0, "Cannot open image");
+    uint64_t n_buckets;
+    fail_unless (pread (fd, &n_buckets, sizeof (n_buckets), 32) == sizeof (n_buckets),
+                 "Cannot read image header");
+    for (uint64_t i = 0; i < n_buckets; i++) {
+        int32_t disp = INT32_MIN;
+        fail_unless (pwrite (fd, &disp, sizeof (disp), 48 + i * sizeof (disp)) == sizeof (disp),
+                     "Cannot write displacement");
+    }
+    close (fd);
+
+    image = w_dict_map_image (path);
+    fail_unless (image != NULL, "Cannot map dictionary image");
+    fail_unless (w_dict_image_get_variant (image, "foo") == NULL,
+                 "Unexpected value for bad displacement");
+    w_obj_unref (image);
+
+    /* Truncated image. */
+    fail_if (truncate (path, 16), "Cannot truncate image");
+    fail_unless (w_dict_map_image (path) == NULL,
+                 "Truncated image was mapped");
+    ck_assert_int_eq (EINVAL, errno);
+
+    unlink (path);
+    w_free (path);
+
+    fail_unless (w_dict_map_image ("/nonexistent/image") == NULL,
+                 "Nonexistent image was mapped");
+    ck_assert_int_eq (ENOENT, errno);
+}
+END_TEST
@@ -0,0 +1,124 @@
+/*
+ * check-wevent.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../wheel.h"
+#include <check.h>
+#include <unistd.h>
+
+
+static int      ready_write_fd = -1;
+static unsigned ready_calls    = 0;
+
+
+static bool
+ready_cb (w_event_loop_t *loop, w_event_t *event)
+{
+    (void) loop;
+    (void) event;
+    ready_calls++;
+    fail_unless (write (ready_write_fd, "x", 1) == 1, "Cannot write to pipe");
+    return false;
+}
+
+
+/*
+ * Adds an event for the read end of a pipe, which writes to the pipe each
+ * time it is handled. Events are edge-triggered, so this keeps the loop
+ * from blocking and idle events run on each iteration.
+ */
+static void
+add_ready_event (w_event_loop_t *loop, int fds[2])
+{
+    fail_if (pipe (fds) != 0, "Cannot create pipe");
+    ready_write_fd = fds[1];
+    w_event_t *event = w_event_new (W_EVENT_FD, ready_cb, fds[0], W_EVENT_IN);
+    fail_if (w_event_loop_add (loop, event), "Cannot add event");
+    w_obj_unref (event);
+    fail_unless (write (fds[1], "x", 1) == 1, "Cannot write to pipe");
+}
+
+
+static unsigned first_calls   = 0;
+static unsigned counter_calls = 0;
+
+
+static bool
+self_del_cb (w_event_loop_t *loop, w_event_t *event)
+{
+    first_calls++;
+    fail_if (w_event_loop_del (loop, event), "Cannot remove event");
+    return false;
+}
+
+
+static bool
+oneshot_cb (w_event_loop_t *loop, w_event_t *event)
+{
+    (void) loop;
+    (void) event;
+    first_calls++;
+    return false;
+}
+
+
+static bool
+counter_cb (w_event_loop_t *loop, w_event_t *event)
+{
+    (void) event;
+    if (++counter_calls == 3)
+        w_event_loop_stop (loop);
+    return false;
+}
+
+
+static void
+run_idle_events (w_event_callback_t callback, w_event_flags_t flags)
+{
+    first_calls = counter_calls = ready_calls = 0;
+
+    int fds[2];
+    w_event_loop_t *loop = w_event_loop_new ();
+    add_ready_event (loop, fds);
+
+    /* The loop holds the only reference to the events. */
+    w_event_t *event = w_event_new (W_EVENT_IDLE, callback, flags);
+    w_event_loop_add (loop, event);
+    w_obj_unref (event);
+    event = w_event_new (W_EVENT_IDLE, counter_cb, 0);
+    w_event_loop_add (loop, event);
+    w_obj_unref (event);
+
+    fail_if (w_event_loop_run (loop), "Event loop failed");
+    ck_assert_int_eq (1, first_calls);
+    ck_assert_int_eq (3, counter_calls);
+
+    /* Idle events run after each poll, none of them is skipped. */
+    ck_assert_int_eq (ready_calls, counter_calls);
+
+    w_obj_unref (loop);
+    close (fds[0]);
+    close (fds[1]);
+}
+
+
+START_TEST (test_wevent_idle_del_self)
+{
+    /* The event after the removed one still runs on each iteration. */
+    run_idle_events (self_del_cb, 0);
+}
+END_TEST
+
+
+START_TEST (test_wevent_idle_oneshot)
+{
+    /* One-shot events run once, and the one following them keeps running. */
+    run_idle_events (oneshot_cb, W_EVENT_ONESHOT);
+
+    /* Removing a one-shot event does not remove the one following it. */
+    run_idle_events (self_del_cb, W_EVENT_ONESHOT);
+}
+END_TEST
@@ -8,6 +8,7 @@
 #include "../wheel.h"
 #include <check.h>
 #include <string.h>
+#include <errno.h>
 
 
 static const char *msg = "Too much work and no joy makes Jack a dull boy.\n"
@@ -102,6 +103,60 @@ START_TEST (test_wio_buf_getchar)
 END_TEST
 
 
+static void
+check_peek (w_io_t *io)
+{
+    const char *data;
+
+    /* All the remaining data is visible, without consuming it. */
+    w_io_result_t r = w_io_peek (io, 1, &data);
+    ck_assert_int_eq (5, w_io_result_bytes (r));
+    fail_if (memcmp ("abcde", data, 5));
+    w_io_consume (io, 2);
+    ck_assert_int_eq ('c', w_io_getchar (io));
+
+    /* Putting back the last character read is supported. */
+    w_io_putback (io, 'c');
+    r = w_io_peek (io, 1, &data);
+    ck_assert_int_eq (3, w_io_result_bytes (r));
+    fail_if (memcmp ("cde", data, 3));
+
+    /* Any other character cannot be part of the view. */
+    ck_assert_int_eq ('c', w_io_getchar (io));
+    w_io_putback (io, 'X');
+    r = w_io_peek (io, 1, &data);
+    ck_assert_int_eq (ENOTSUP, w_io_result_error (r));
+    ck_assert_int_eq ('X', w_io_getchar (io));
+
+    w_io_consume (io, 2);
+    r = w_io_peek (io, 1, &data);
+    fail_unless (w_io_eof (r), "End of file not reached");
+}
+
+
+START_TEST (test_wio_buf_peek)
+{
+    w_buf_t buf = W_BUF;
+    w_buf_set_str (&buf, "abcde");
+    w_io_t *io = w_io_buf_open (&buf);
+    check_peek (io);
+    w_obj_unref (io);
+    w_buf_clear (&buf);
+}
+END_TEST
+
+
+START_TEST (test_wio_mem_peek)
+{
+    uint8_t data[5];
+    memcpy (data, "abcde", 5);
+    w_io_t *io = w_io_mem_open (data, sizeof (data));
+    check_peek (io);
+    w_obj_unref (io);
+}
+END_TEST
+
+
 START_TEST (test_wio_buf_write)
 {
     w_io_t *io = w_io_buf_open (NULL);
@@ -140,3 +195,41 @@ START_TEST (test_wio_buf_format)
 }
 END_TEST
 
+
+
+static unsigned format_fd_writes = 0;
+
+static w_io_result_t
+format_fd_write (w_io_t *io, const void *buf, size_t len)
+{
+    format_fd_writes++;
+    w_buf_append_mem (w_io_buf_get_buffer ((w_io_buf_t*) io), buf, len);
+    return W_IO_RESULT (len);
+}
+
+static int
+format_fd_getfd (w_io_t *io)
+{
+    w_unused (io);
+    return 0;
+}
+
+
+START_TEST (test_wio_buf_format_fd)
+{
+    /* Streams with a file descriptor get the formatted output at once. */
+    w_io_buf_t io;
+    w_io_buf_init (&io, NULL, false);
+    io.parent.write = format_fd_write;
+    io.parent.getfd = format_fd_getfd;
+
+    w_io_result_t r = w_io_format ((w_io_t*) &io, "$s: $i, $L ($c)\n",
+                                   "answer", -42, 42UL, '!');
+    ck_assert_int_eq (20, w_io_result_bytes (r));
+    ck_assert_int_eq (1, format_fd_writes);
+    ck_assert_str_eq ("answer: -42, 42 (!)\n",
+                      w_buf_str (w_io_buf_get_buffer (&io)));
+
+    W_IO_NORESULT (w_io_close ((w_io_t*) &io));
+}
+END_TEST
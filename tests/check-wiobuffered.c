@@ -0,0 +1,204 @@
+/*
+ * check-wiobuffered.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../wheel.h"
+#include <check.h>
+#include <unistd.h>
+
+
+/* Memory stream which counts the operations done on it. */
+struct counting_io
+{
+    w_io_buf_t parent;
+    unsigned   reads;
+    unsigned   writes;
+};
+
+static w_io_result_t (*buf_read) (w_io_t*, void*, size_t);
+static w_io_result_t (*buf_write) (w_io_t*, const void*, size_t);
+
+static w_io_result_t
+counting_read (w_io_t *io, void *data, size_t size)
+{
+    ((struct counting_io*) io)->reads++;
+    return (*buf_read) (io, data, size);
+}
+
+static w_io_result_t
+counting_write (w_io_t *io, const void *data, size_t size)
+{
+    ((struct counting_io*) io)->writes++;
+    return (*buf_write) (io, data, size);
+}
+
+static struct counting_io*
+counting_io_new (w_buf_t *buf)
+{
+    struct counting_io *io = w_obj_new (struct counting_io);
+    w_io_buf_init (&io->parent, buf, false);
+    buf_read = io->parent.parent.read;
+    buf_write = io->parent.parent.write;
+    io->parent.parent.read = counting_read;
+    io->parent.parent.write = counting_write;
+    return io;
+}
+
+
+START_TEST (test_wio_buffered_read)
+{
+    w_buf_t data = W_BUF;
+    for (unsigned i = 0; i < 1000; i++)
+        w_buf_append_char (&data, 'a' + i % 26);
+
+    struct counting_io *cio = counting_io_new (&data);
+    w_io_t *io = w_io_buffered_open ((w_io_t*) cio, 256, 0);
+
+    /* Reading character by character is done in blocks. */
+    for (unsigned i = 0; i < 1000; i++)
+        ck_assert_int_eq ('a' + i % 26, w_io_getchar (io));
+    ck_assert_int_eq (W_IO_EOF, w_io_getchar (io));
+    ck_assert_int_eq (5, cio->reads);
+
+    w_obj_unref (cio);
+    w_obj_unref (io);
+    w_buf_clear (&data);
+}
+END_TEST
+
+
+START_TEST (test_wio_buffered_read_big)
+{
+    w_buf_t data = W_BUF;
+    for (unsigned i = 0; i < 1000; i++)
+        w_buf_append_char (&data, 'a' + i % 26);
+
+    struct counting_io *cio = counting_io_new (&data);
+    w_io_t *io = w_io_buffered_open ((w_io_t*) cio, 256, 0);
+
+    /* Buffered data is returned first, then big reads bypass the buffer. */
+    char buf[600];
+    ck_assert_int_eq ('a', w_io_getchar (io));
+    w_io_result_t r = w_io_read (io, buf, sizeof (buf));
+    ck_assert_int_eq (255, w_io_result_bytes (r));
+    fail_if (memcmp (w_buf_const_data (&data) + 1, buf, 255));
+    r = w_io_read (io, buf, sizeof (buf));
+    ck_assert_int_eq (600, w_io_result_bytes (r));
+    fail_if (memcmp (w_buf_const_data (&data) + 256, buf, 600));
+    ck_assert_int_eq (2, cio->reads);
+
+    w_obj_unref (cio);
+    w_obj_unref (io);
+    w_buf_clear (&data);
+}
+END_TEST
+
+
+START_TEST (test_wio_buffered_write)
+{
+    w_buf_t data = W_BUF;
+    struct counting_io *cio = counting_io_new (&data);
+    w_io_t *io = w_io_buffered_open ((w_io_t*) cio, 0, 64);
+
+    for (unsigned i = 0; i < 100; i++)
+        ck_assert_int_eq (1, w_io_result_bytes (w_io_format (io, "$c", 'a' + i % 26)));
+    ck_assert_int_eq (1, cio->writes);
+    ck_assert_int_eq (64, w_buf_size (&data));
+
+    /* Big writes go straight to the wrapped stream. */
+    char big[100];
+    memset (big, 'x', sizeof (big));
+    w_io_result_t r = w_io_write (io, big, sizeof (big));
+    ck_assert_int_eq (100, w_io_result_bytes (r));
+    ck_assert_int_eq (3, cio->writes);
+    ck_assert_int_eq (200, w_buf_size (&data));
+
+    W_IO_NORESULT (w_io_format (io, "end"));
+    ck_assert_int_eq (200, w_buf_size (&data));
+    fail_if (w_io_failed (w_io_flush (io)));
+    ck_assert_int_eq (203, w_buf_size (&data));
+    fail_if (memcmp ("xend", w_buf_const_data (&data) + 199, 4));
+
+    /* Closing writes pending data and releases the wrapped stream. */
+    W_IO_NORESULT (w_io_format (io, "!"));
+    ck_assert_int_eq (2, ((w_obj_t*) cio)->__refs & ~W__OBJ_FLAGS);
+    w_obj_unref (io);
+    ck_assert_int_eq (204, w_buf_size (&data));
+    ck_assert_int_eq (1, ((w_obj_t*) cio)->__refs & ~W__OBJ_FLAGS);
+
+    w_obj_unref (cio);
+    w_buf_clear (&data);
+}
+END_TEST
+
+
+START_TEST (test_wio_buffered_peek)
+{
+    w_buf_t data = W_BUF;
+    w_buf_set_str (&data, "Hello, world");
+
+    struct counting_io *cio = counting_io_new (&data);
+    w_io_buffered_t io;
+    w_io_buffered_init (&io, (w_io_t*) cio, 4, 0);
+
+    /* Peeking more than the read size grows the buffer. */
+    const char *p;
+    w_io_result_t r = w_io_peek ((w_io_t*) &io, 7, &p);
+    ck_assert_int_eq (7, w_io_result_bytes (r));
+    fail_if (memcmp ("Hello, ", p, 7));
+    w_io_consume ((w_io_t*) &io, 7);
+
+    /* Any amount of data can be pushed back. */
+    w_io_buffered_unread (&io, "Goodbye, ", 9);
+    w_io_putback ((w_io_t*) &io, '>');
+    r = w_io_peek ((w_io_t*) &io, 100, &p);
+    ck_assert_int_eq (15, w_io_result_bytes (r));
+    fail_if (memcmp (">Goodbye, world", p, 15));
+    w_io_consume ((w_io_t*) &io, 1);
+
+    char buf[20];
+    r = w_io_read ((w_io_t*) &io, buf, sizeof (buf));
+    ck_assert_int_eq (14, w_io_result_bytes (r));
+    fail_if (memcmp ("Goodbye, world", buf, 14));
+
+    r = w_io_peek ((w_io_t*) &io, 1, &p);
+    fail_unless (w_io_eof (r), "End of file not reached");
+
+    W_IO_NORESULT (w_io_close ((w_io_t*) &io));
+    w_obj_unref (cio);
+    w_buf_clear (&data);
+}
+END_TEST
+
+
+START_TEST (test_wio_buffered_pipe)
+{
+    int fds[2];
+    fail_if (pipe (fds) != 0, "Cannot create pipe");
+    w_io_t *rio = w_io_unix_open_fd (fds[0]);
+    w_io_t *wio = w_io_unix_open_fd (fds[1]);
+
+    w_io_t *in = w_io_buffered_open (rio, 0, 0);
+    w_io_t *out = w_io_buffered_open (wio, 0, 0);
+    w_obj_unref (rio);
+    w_obj_unref (wio);
+    ck_assert_int_eq (fds[0], w_io_get_fd (in));
+
+    /* Nothing reaches the pipe until the output is flushed. */
+    W_IO_NORESULT (w_io_format (out, "12:5:hello,1:1#]"));
+    fail_if (w_io_failed (w_io_flush (out)));
+    w_obj_unref (out);
+
+    w_list_t *list = w_list_new (true);
+    fail_if (w_tnetstr_read_list (in, list), "Reading tnetstring failed");
+    ck_assert_int_eq (2, w_list_size (list));
+    ck_assert_str_eq ("hello", w_variant_string (w_list_at (list, 0)));
+    w_obj_unref (list);
+
+    fail_unless (w_io_getchar (in) == W_IO_EOF, "End of file not reached");
+    w_obj_unref (in);
+}
+END_TEST
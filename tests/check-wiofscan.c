@@ -7,7 +7,9 @@
 
 #include "../wheel.h"
 #include <check.h>
+#include <limits.h>
 #include <math.h>
+#include <unistd.h>
 
 #define IOSTR(_s) \
     w_buf_t __buf = W_BUF; \
@@ -111,6 +113,21 @@ START_TEST (test_wiofscan_ulong_leadplus)
 END_TEST
 
 
+START_TEST (test_wiofscan_ulong_overflow)
+{
+    unsigned long uval;
+    IOSTR ("123456789012345678901234567890:");
+
+    fail_unless (w_io_fscan_ulong (io, &uval),
+                 "conversion succeeded for value bigger than ULONG_MAX");
+    fail_unless (uval == ULONG_MAX, "converted value is not ULONG_MAX");
+    ck_assert_int_eq (':', w_io_getchar (io));
+
+    w_obj_unref (io);
+}
+END_TEST
+
+
 START_TEST (test_wiofscan_ulong_leadminus)
 {
     unsigned long uval;
@@ -391,3 +408,113 @@ START_TEST (test_wio_fscan_badinput)
     w_obj_unref (io);
 }
 END_TEST
+
+START_TEST (test_wio_fscan_buffered)
+{
+    unsigned long uval;
+    long lval;
+    double dval;
+    IOSTR ("1234567890 -42 3.25e1 1e 99999999999999999999 7");
+    w_io_t *bio = w_io_buffered_open (io, 16, 0);
+
+    /* Numbers are scanned from the buffered data when possible. */
+    fail_if (w_io_fscan_ulong (bio, &uval), "Could not scan ulong");
+    fail_unless (uval == 1234567890UL, "Read value is not 1234567890");
+    ck_assert_int_eq (' ', w_io_getchar (bio));
+    fail_if (w_io_fscan_long (bio, &lval), "Could not scan long");
+    ck_assert_int_eq (-42, lval);
+    ck_assert_int_eq (' ', w_io_getchar (bio));
+    fail_if (w_io_fscan_double (bio, &dval), "Could not scan double");
+    fail_unless (dval == 32.5, "Read value is not 32.5");
+    ck_assert_int_eq (' ', w_io_getchar (bio));
+    fail_if (w_io_fscan_double (bio, &dval), "Could not scan double");
+    fail_unless (dval == 1.0, "Read value is not 1.0");
+    ck_assert_int_eq (' ', w_io_getchar (bio));
+    fail_unless (w_io_fscan_ulong (bio, &uval), "Scanned too big ulong");
+    ck_assert_int_eq (' ', w_io_getchar (bio));
+    fail_if (w_io_fscan_long (bio, &lval), "Could not scan long");
+    ck_assert_int_eq (7, lval);
+    ck_assert_int_eq (W_IO_EOF, w_io_getchar (bio));
+
+    w_obj_unref (bio);
+    w_obj_unref (io);
+}
+END_TEST
+
+
+/* Inputs whose scanning must not depend on the kind of stream. */
+static const char *consistent_input[] = {
+    "-inf", "+nan", "-nan", "+infinity", "-Infinity", "infin", "infx",
+    "-9223372036854775808", "-9223372036854775809", "9223372036854775808",
+    "+42", "-0.5", "1.5e", "2e+", "-", "+x",
+};
+
+static w_io_t*
+pipe_with_data (const char *data)
+{
+    int fds[2];
+    fail_if (pipe (fds) != 0, "Cannot create pipe");
+    fail_if (write (fds[1], data, strlen (data)) != (ssize_t) strlen (data));
+    close (fds[1]);
+    return w_io_unix_open_fd (fds[0]);
+}
+
+START_TEST (test_wio_fscan_peek_consistent)
+{
+    /* Numbers are followed by more input, so they can be peeked. */
+    for (unsigned i = 0; i < w_lengthof (consistent_input); i++) {
+        w_buf_t b = W_BUF;
+        w_buf_format (&b, "$s|", consistent_input[i]);
+        w_io_t *mio = w_io_buf_open (&b);
+        w_io_t *pio = pipe_with_data (w_buf_str (&b));
+
+        double md = 0.0, pd = 0.0;
+        bool mfail = w_io_fscan_double (mio, &md);
+        bool pfail = w_io_fscan_double (pio, &pd);
+        fail_unless (mfail == pfail, "Scanning double \"%s\" differs: %i/%i",
+                     consistent_input[i], mfail, pfail);
+        if (!mfail) {
+            fail_unless ((isnan (md) && isnan (pd)) || md == pd,
+                         "Double \"%s\" differs: %g/%g",
+                         consistent_input[i], md, pd);
+            fail_unless (!!signbit (md) == !!signbit (pd),
+                         "Double \"%s\" sign differs", consistent_input[i]);
+            ck_assert_int_eq (w_io_getchar (mio), w_io_getchar (pio));
+        }
+        w_obj_unref (mio);
+        w_obj_unref (pio);
+
+        mio = w_io_buf_open (&b);
+        pio = pipe_with_data (w_buf_str (&b));
+        long ml = 0, pl = 0;
+        mfail = w_io_fscan_long (mio, &ml);
+        pfail = w_io_fscan_long (pio, &pl);
+        fail_unless (mfail == pfail, "Scanning long \"%s\" differs: %i/%i",
+                     consistent_input[i], mfail, pfail);
+        if (!mfail) {
+            ck_assert_int_eq (ml, pl);
+            ck_assert_int_eq (w_io_getchar (mio), w_io_getchar (pio));
+        }
+        w_obj_unref (mio);
+        w_obj_unref (pio);
+        w_buf_clear (&b);
+    }
+}
+END_TEST
+
+START_TEST (test_wio_fscan_long_min)
+{
+    /* Read from a pipe, the value is scanned character by character. */
+    w_buf_t b = W_BUF;
+    w_buf_format (&b, "$l|", LONG_MIN);
+    w_io_t *io = pipe_with_data (w_buf_str (&b));
+
+    long lval;
+    fail_if (w_io_fscan_long (io, &lval), "Could not scan LONG_MIN");
+    fail_unless (lval == LONG_MIN, "Read value is not LONG_MIN");
+    ck_assert_int_eq ('|', w_io_getchar (io));
+
+    w_obj_unref (io);
+    w_buf_clear (&b);
+}
+END_TEST
@@ -0,0 +1,174 @@
+/*
+ * check-wiolines.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../wheel.h"
+#include <check.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+static const char *msg = "Line one\n"
+                         "\n"
+                         "Another line, number two\n"
+                         "And one more line, making it the third.";
+
+
+/* Reads all records, joining them with "|" for checking. */
+static unsigned
+read_all (w_io_lines_t *lines, w_buf_t *out)
+{
+    const char *data;
+    size_t size;
+    unsigned count = 0;
+
+    for (;;) {
+        w_io_result_t r = w_io_lines_next (lines, &data, &size);
+        fail_if (w_io_failed (r), "Reading failed");
+        if (w_io_eof (r))
+            break;
+        ck_assert_int_eq (size, w_io_result_bytes (r));
+        if (count++)
+            w_buf_append_char (out, '|');
+        w_buf_append_mem (out, data, size);
+    }
+    return count;
+}
+
+
+static w_io_t*
+pipe_with_data (const char *data)
+{
+    int fds[2];
+    fail_if (pipe (fds) != 0, "Cannot create pipe");
+    fail_if (write (fds[1], data, strlen (data)) != (ssize_t) strlen (data));
+    close (fds[1]);
+    return w_io_unix_open_fd (fds[0]);
+}
+
+
+START_TEST (test_wio_lines_next)
+{
+    /* Memory streams are split in place. */
+    w_buf_t b = W_BUF;
+    w_buf_set_str (&b, msg);
+    w_io_t *io = w_io_buf_open (&b);
+
+    w_io_lines_t lines;
+    w_io_lines_init (&lines, io, "\n", 0);
+    w_buf_t out = W_BUF;
+    ck_assert_int_eq (4, read_all (&lines, &out));
+    ck_assert_str_eq ("Line one||Another line, number two|"
+                      "And one more line, making it the third.",
+                      w_buf_str (&out));
+    w_io_lines_clear (&lines);
+    w_buf_clear (&out);
+    w_obj_unref (io);
+
+    /* Streams without peeking are read in small chunks. */
+    io = pipe_with_data (msg);
+    w_io_lines_init (&lines, io, "\n", 5);
+    ck_assert_int_eq (4, read_all (&lines, &out));
+    ck_assert_str_eq ("Line one||Another line, number two|"
+                      "And one more line, making it the third.",
+                      w_buf_str (&out));
+    w_io_lines_clear (&lines);
+    w_buf_clear (&out);
+    w_obj_unref (io);
+
+    w_buf_clear (&b);
+}
+END_TEST
+
+
+START_TEST (test_wio_lines_buffered)
+{
+    /* Records span several chunks of the buffered stream data. */
+    w_io_t *fio = pipe_with_data (msg);
+    w_io_t *io = w_io_buffered_open (fio, 7, 0);
+    w_obj_unref (fio);
+
+    w_io_lines_t lines;
+    w_io_lines_init (&lines, io, "\n", 4);
+    w_buf_t out = W_BUF;
+    ck_assert_int_eq (4, read_all (&lines, &out));
+    ck_assert_str_eq ("Line one||Another line, number two|"
+                      "And one more line, making it the third.",
+                      w_buf_str (&out));
+    w_io_lines_clear (&lines);
+    w_buf_clear (&out);
+    w_obj_unref (io);
+}
+END_TEST
+
+
+START_TEST (test_wio_lines_delimiters)
+{
+    /* Long enough to exercise the vectorized search. */
+    static const char data[] =
+        "key=value;another=thing,with\tseveral delimiters;"
+        "and a long record without any of them until the end\n";
+    uint8_t mem[sizeof (data) - 1];
+    memcpy (mem, data, sizeof (mem));
+    w_io_t *io = w_io_mem_open (mem, sizeof (mem));
+
+    w_io_lines_t lines;
+    w_io_lines_init (&lines, io, ";,\t\n", 0);
+    w_buf_t out = W_BUF;
+    ck_assert_int_eq (5, read_all (&lines, &out));
+    ck_assert_str_eq ("key=value|another=thing|with|several delimiters|"
+                      "and a long record without any of them until the end",
+                      w_buf_str (&out));
+    w_io_lines_clear (&lines);
+    w_buf_clear (&out);
+    w_obj_unref (io);
+}
+END_TEST
+
+
+START_TEST (test_wio_lines_batch)
+{
+    w_buf_t text = W_BUF;
+    for (unsigned i = 0; i < 1000; i++)
+        w_buf_format (&text, "line $I\n", i);
+
+    w_io_t *io = pipe_with_data (w_buf_cstr (&text));
+    w_io_lines_t lines;
+    w_io_lines_init (&lines, io, "\n", 100);
+
+    /* Batches contain only complete records. */
+    struct iovec iov[16];
+    unsigned count = 0;
+    unsigned batches = 0;
+    for (;;) {
+        int n = w_lengthof (iov);
+        w_io_result_t r = w_io_lines_batch (&lines, iov, &n);
+        fail_if (w_io_failed (r), "Reading failed");
+        if (w_io_eof (r)) {
+            ck_assert_int_eq (0, n);
+            break;
+        }
+        fail_unless (n > 0 && n <= (int) w_lengthof (iov));
+
+        size_t total = 0;
+        for (int i = 0; i < n; i++, count++) {
+            char expected[20];
+            int len = snprintf (expected, sizeof (expected), "line %u", count);
+            ck_assert_int_eq (len, iov[i].iov_len);
+            fail_if (memcmp (expected, iov[i].iov_base, len));
+            total += iov[i].iov_len;
+        }
+        ck_assert_int_eq (total, w_io_result_bytes (r));
+        batches++;
+    }
+    ck_assert_int_eq (1000, count);
+    fail_unless (batches < 1000, "Records were not batched");
+
+    w_io_lines_clear (&lines);
+    w_obj_unref (io);
+    w_buf_clear (&text);
+}
+END_TEST
@@ -0,0 +1,236 @@
+/*
+ * check-wiommap.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../wheel.h"
+#include <check.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+static const char *msg = "Line one\n"
+                         "Another line, number two\n"
+                         "And one more line, making it the third.";
+
+
+/* Creates an unlinked temporary file with some data, at offset zero. */
+static int
+file_with_data (const char *data)
+{
+    char path[] = "/tmp/check-wiommap-XXXXXX";
+    int fd = mkstemp (path);
+    fail_if (fd < 0, "Cannot create temporary file");
+    unlink (path);
+
+    fail_if (write (fd, data, strlen (data)) != (ssize_t) strlen (data));
+    fail_if (lseek (fd, 0, SEEK_SET) != 0);
+    return fd;
+}
+
+
+static int
+pipe_with_data (const char *data)
+{
+    int fds[2];
+    fail_if (pipe (fds) != 0, "Cannot create pipe");
+    fail_if (write (fds[1], data, strlen (data)) != (ssize_t) strlen (data));
+    close (fds[1]);
+    return fds[0];
+}
+
+
+/* Reads all lines, joining them with "|" for checking. */
+static void
+check_lines (w_io_t *io)
+{
+    w_buf_t line = W_BUF;
+    w_buf_t overflow = W_BUF;
+    w_buf_t out = W_BUF;
+
+    for (;;) {
+        w_io_result_t r = w_io_read_line (io, &line, &overflow, 0);
+        fail_if (w_io_failed (r), "Reading failed");
+        if (w_io_eof (r))
+            break;
+        w_buf_append_buf (&out, &line);
+        w_buf_append_char (&out, '|');
+        w_buf_clear (&line);
+    }
+    /* The last line has no delimiter, it is left in the overflow. */
+    w_buf_append_buf (&out, &overflow);
+    ck_assert_str_eq ("Line one|Another line, number two|"
+                      "And one more line, making it the third.",
+                      w_buf_str (&out));
+
+    w_buf_clear (&overflow);
+    w_buf_clear (&out);
+}
+
+
+START_TEST (test_wio_mmap_read)
+{
+    int fd = file_with_data (msg);
+    w_io_t *io = w_io_mmap_open_fd (fd, W_IO_MMAP_POPULATE);
+    fail_unless (w_io_mmap_mapped ((w_io_mmap_t*) io), "File not mapped");
+    ck_assert_int_eq (fd, w_io_get_fd (io));
+    check_lines (io);
+    w_obj_unref (io);
+
+    io = w_io_mmap_open_fd (file_with_data (msg), 0);
+
+    char buf[10];
+    w_io_result_t r = w_io_read (io, buf, 5);
+    ck_assert_int_eq (5, w_io_result_bytes (r));
+    fail_if (memcmp ("Line ", buf, 5));
+
+    /* Peeking gives all the remaining contents of the file. */
+    ck_assert_int_eq ('o', w_io_getchar (io));
+    w_io_putback (io, 'o');
+    const char *p;
+    r = w_io_peek (io, 1, &p);
+    ck_assert_int_eq (strlen (msg) - 5, w_io_result_bytes (r));
+    fail_if (memcmp (msg + 5, p, strlen (msg) - 5));
+
+    /* A different character pushed back cannot be seen. */
+    w_io_consume (io, 3);
+    ck_assert_int_eq ('\n', w_io_getchar (io));
+    w_io_putback (io, 'x');
+    r = w_io_peek (io, 1, &p);
+    ck_assert_int_eq (ENOTSUP, w_io_result_error (r));
+    ck_assert_int_eq ('x', w_io_getchar (io));
+
+    w_io_consume (io, strlen (msg) - 9);
+    r = w_io_peek (io, 1, &p);
+    fail_unless (w_io_eof (r), "End of file not reached");
+    r = w_io_read (io, buf, sizeof (buf));
+    fail_unless (w_io_eof (r), "End of file not reached");
+
+    /* Writing is not supported. */
+    r = w_io_write (io, "x", 1);
+    ck_assert_int_eq (EBADF, w_io_result_error (r));
+
+    w_obj_unref (io);
+}
+END_TEST
+
+
+START_TEST (test_wio_mmap_offset)
+{
+    /* Reading starts at the current offset of the descriptor. */
+    int fd = file_with_data (msg);
+    fail_if (lseek (fd, 9, SEEK_SET) != 9);
+
+    w_io_mmap_t io;
+    w_io_mmap_init_fd (&io, fd, 0);
+    fail_unless (w_io_mmap_mapped (&io), "File not mapped");
+
+    const char *p;
+    w_io_result_t r = w_io_peek ((w_io_t*) &io, 1, &p);
+    ck_assert_int_eq (strlen (msg) - 9, w_io_result_bytes (r));
+    fail_if (memcmp ("Another", p, 7));
+
+    W_IO_NORESULT (w_io_close ((w_io_t*) &io));
+}
+END_TEST
+
+
+START_TEST (test_wio_mmap_fallback)
+{
+    /* Pipes cannot be mapped, and are read using read(). */
+    int fd = pipe_with_data (msg);
+    w_io_t *io = w_io_mmap_open_fd (fd, 0);
+    fail_if (w_io_mmap_mapped ((w_io_mmap_t*) io), "Pipe mapped");
+
+    /* Peeking works, and any character pushed back can be seen. */
+    ck_assert_int_eq ('L', w_io_getchar (io));
+    w_io_putback (io, '>');
+    const char *p;
+    w_io_result_t r = w_io_peek (io, 4, &p);
+    ck_assert_int_eq (strlen (msg), w_io_result_bytes (r));
+    fail_if (memcmp (">ine one", p, 8));
+    w_io_consume (io, 1);
+    w_io_putback (io, 'L');
+
+    check_lines (io);
+    w_obj_unref (io);
+
+    /* Empty regular files are read using read(), too. */
+    fd = file_with_data ("");
+    io = w_io_mmap_open_fd (fd, 0);
+    fail_if (w_io_mmap_mapped ((w_io_mmap_t*) io), "Empty file mapped");
+    r = w_io_peek (io, 1, &p);
+    fail_unless (w_io_eof (r), "End of file not reached");
+    ck_assert_int_eq (W_IO_EOF, w_io_getchar (io));
+    w_obj_unref (io);
+
+    fail_unless (w_io_mmap_open ("/nonexistent/file", 0) == NULL);
+}
+END_TEST
+
+
+START_TEST (test_wio_mmap_tnetstr)
+{
+    static const char data[] = "5:hello,2:42#10:3:foo,1:1#]4:true!0:~";
+
+    for (unsigned i = 0; i < 2; i++) {
+        int fd = i ? pipe_with_data (data) : file_with_data (data);
+        w_io_t *io = w_io_mmap_open_fd (fd, 0);
+
+        w_variant_t *v = w_tnetstr_read (io);
+        fail_unless (v && w_variant_is_string (v));
+        ck_assert_str_eq ("hello", w_variant_string (v));
+        w_obj_unref (v);
+
+        long number;
+        fail_if (w_tnetstr_read_number (io, &number));
+        ck_assert_int_eq (42, number);
+
+        v = w_tnetstr_read (io);
+        fail_unless (v && w_variant_is_list (v));
+        ck_assert_int_eq (2, w_list_size (w_variant_list (v)));
+        w_obj_unref (v);
+
+        bool boolean;
+        fail_if (w_tnetstr_read_bool (io, &boolean));
+        fail_unless (boolean);
+
+        v = w_tnetstr_read (io);
+        fail_unless (v && w_variant_is_null (v));
+        w_obj_unref (v);
+
+        fail_unless (w_tnetstr_read (io) == NULL, "Read past the end");
+        w_obj_unref (io);
+    }
+
+    /* Truncated items are not parsed. */
+    w_io_t *io = w_io_mmap_open_fd (file_with_data ("10:hello,"), 0);
+    fail_unless (w_tnetstr_read (io) == NULL, "Truncated item parsed");
+    w_obj_unref (io);
+}
+END_TEST
+
+
+START_TEST (test_wio_mmap_cfg)
+{
+    char path[] = "/tmp/check-wiommap-XXXXXX";
+    int fd = mkstemp (path);
+    fail_if (fd < 0, "Cannot create temporary file");
+    w_io_t *io = w_io_unix_open_fd (fd);
+    W_IO_NORESULT (w_io_format (io, "# Comment\nname \"the name\"\n"
+                                    "section {\n  value 42\n}\n"));
+    w_obj_unref (io);
+
+    /* Configuration files are parsed from the mapped data. */
+    char *err = NULL;
+    w_cfg_t *cfg = w_cfg_load_file (path, &err);
+    unlink (path);
+    fail_if (cfg == NULL, "w_cfg_load_file failed: %s", err);
+    ck_assert_str_eq ("the name", w_cfg_get_string (cfg, "name", NULL));
+    ck_assert_int_eq (42, (long) w_cfg_get_number (cfg, "section.value", 0));
+    w_obj_unref (cfg);
+}
+END_TEST
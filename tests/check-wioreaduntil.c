@@ -7,12 +7,18 @@
 
 #include "../wheel.h"
 #include <check.h>
+#include <unistd.h>
 
 static const char *msg = "Line one\n"
                          "Another line, number two\n"
                          "And one more line, making it the third.";
 
 
+/*
+ * Memory streams support peeking, and w_io_read_line() finds lines in
+ * the stream data without using the overflow buffer except for the last
+ * line, which does not have a delimiter.
+ */
 START_TEST (test_wio_read_line)
 {
     w_buf_t b = W_BUF;
@@ -29,7 +35,7 @@ START_TEST (test_wio_read_line)
 
     ck_assert_int_eq (8, w_buf_size (&line));
     ck_assert_str_eq ("Line one", w_buf_str (&line));
-    fail_if (w_buf_size (&over) <= 0, "No overflow?");
+    ck_assert_int_eq (0, w_buf_size (&over));
     w_buf_clear (&line);
 
     /* Read next line */
@@ -38,7 +44,7 @@ START_TEST (test_wio_read_line)
     fail_if (w_io_eof (r), "EOF marker cannot be reached");
 
     ck_assert_str_eq ("Another line, number two", w_buf_str (&line));
-    fail_if (w_buf_size (&over) <= 0, "No overflow?");
+    ck_assert_int_eq (0, w_buf_size (&over));
     w_buf_clear (&line);
 
     /* And now for the last one */
@@ -72,7 +78,7 @@ START_TEST (test_wio_read_line_smallbuf)
 
     ck_assert_int_eq (8, w_buf_size (&line));
     ck_assert_str_eq ("Line one", w_buf_str (&line));
-    fail_if (w_buf_size (&over) <= 0, "No overflow?");
+    ck_assert_int_eq (0, w_buf_size (&over));
     w_buf_clear (&line);
 
     /* Read next line */
@@ -81,7 +87,7 @@ START_TEST (test_wio_read_line_smallbuf)
     fail_if (w_io_eof (r), "EOF marker cannot be reached");
 
     ck_assert_str_eq ("Another line, number two", w_buf_str (&line));
-    fail_if (w_buf_size (&over) <= 0, "No overflow?");
+    ck_assert_int_eq (0, w_buf_size (&over));
     w_buf_clear (&line);
 
     /* And now for the last one */
@@ -129,3 +135,73 @@ START_TEST (test_wio_read_empty_line)
 
 }
 END_TEST
+
+
+START_TEST (test_wio_read_line_nopeek)
+{
+    int fds[2];
+    fail_if (pipe (fds) != 0, "Cannot create pipe");
+    w_io_t *io = w_io_unix_open_fd (fds[0]);
+    fail_if (write (fds[1], msg, strlen (msg)) != (ssize_t) strlen (msg));
+    close (fds[1]);
+
+    w_buf_t line = W_BUF;
+    w_buf_t over = W_BUF;
+
+    /* Streams which cannot be peeked leave the excess in the overflow. */
+    w_io_result_t r = w_io_read_line (io, &line, &over, 10);
+    fail_if (w_io_failed (r), "Reading from pipe should succeed");
+    ck_assert_str_eq ("Line one", w_buf_str (&line));
+    fail_if (w_buf_size (&over) <= 0, "No overflow?");
+    w_buf_clear (&line);
+
+    r = w_io_read_line (io, &line, &over, 10);
+    fail_if (w_io_failed (r), "Reading from pipe should succeed");
+    ck_assert_str_eq ("Another line, number two", w_buf_str (&line));
+    w_buf_clear (&line);
+
+    r = w_io_read_line (io, &line, &over, 10);
+    fail_unless (w_io_eof (r), "EOF marker should be reached");
+    ck_assert_str_eq ("And one more line, making it the third.", w_buf_str (&over));
+
+    w_buf_clear (&line);
+    w_buf_clear (&over);
+    w_obj_unref (io);
+}
+END_TEST
+
+
+START_TEST (test_wio_read_line_buffered)
+{
+    int fds[2];
+    fail_if (pipe (fds) != 0, "Cannot create pipe");
+    w_io_t *fio = w_io_unix_open_fd (fds[0]);
+    w_io_t *io = w_io_buffered_open (fio, 16, 0);
+    w_obj_unref (fio);
+    fail_if (write (fds[1], msg, strlen (msg)) != (ssize_t) strlen (msg));
+    close (fds[1]);
+
+    w_buf_t line = W_BUF;
+    w_buf_t over = W_BUF;
+
+    /* Lines longer than the buffer are accumulated in the overflow. */
+    w_io_result_t r = w_io_read_line (io, &line, &over, 0);
+    fail_if (w_io_failed (r), "Reading should succeed");
+    ck_assert_str_eq ("Line one", w_buf_str (&line));
+    w_buf_clear (&line);
+
+    r = w_io_read_line (io, &line, &over, 0);
+    fail_if (w_io_failed (r), "Reading should succeed");
+    ck_assert_str_eq ("Another line, number two", w_buf_str (&line));
+    ck_assert_int_eq (0, w_buf_size (&over));
+    w_buf_clear (&line);
+
+    r = w_io_read_line (io, &line, &over, 0);
+    fail_unless (w_io_eof (r), "EOF marker should be reached");
+    ck_assert_str_eq ("And one more line, making it the third.", w_buf_str (&over));
+
+    w_buf_clear (&line);
+    w_buf_clear (&over);
+    w_obj_unref (io);
+}
+END_TEST
@@ -0,0 +1,300 @@
+/*
+ * check-wiovbuf.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../wheel.h"
+#include <check.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+
+/* Reads back what was written to a temporary file. */
+static void
+read_back (int fd, w_buf_t *out)
+{
+    char chunk[4096];
+    ssize_t r;
+
+    lseek (fd, 0, SEEK_SET);
+    while ((r = read (fd, chunk, sizeof (chunk))) > 0)
+        w_buf_append_mem (out, chunk, r);
+}
+
+
+START_TEST (test_wiovbuf_merge)
+{
+    w_iovbuf_t iovbuf = W_IOVBUF;
+
+    /* Consecutive copies are merged into the same segment. */
+    w_iovbuf_append_str (&iovbuf, "Hello");
+    w_iovbuf_append_mem (&iovbuf, ", ", 2);
+    w_iovbuf_append_str (&iovbuf, "world");
+    ck_assert_int_eq (1, w_iovbuf_count (&iovbuf));
+    ck_assert_int_eq (12, w_iovbuf_size (&iovbuf));
+
+    static const char borrowed[] = "!?";
+    w_iovbuf_append_borrowed (&iovbuf, borrowed, 1);
+    w_iovbuf_append_borrowed (&iovbuf, borrowed + 1, 1);
+    ck_assert_int_eq (2, w_iovbuf_count (&iovbuf));
+
+    w_iovbuf_format (&iovbuf, " $I", 42);
+    ck_assert_int_eq (3, w_iovbuf_count (&iovbuf));
+    ck_assert_int_eq (17, w_iovbuf_size (&iovbuf));
+
+    /* Streams without vectored output get one write per segment. */
+    w_buf_t out = W_BUF;
+    w_io_buf_t iobuf;
+    w_io_buf_init (&iobuf, &out, false);
+    w_io_result_t r = w_io_write_iovbuf ((w_io_t*) &iobuf, &iovbuf);
+    ck_assert_int_eq (17, w_io_result_bytes (r));
+    ck_assert_str_eq ("Hello, world!? 42", w_buf_cstr (&out));
+    w_buf_clear (&out);
+
+    w_iovbuf_clear (&iovbuf);
+    ck_assert_int_eq (0, w_iovbuf_count (&iovbuf));
+    ck_assert_int_eq (0, w_iovbuf_size (&iovbuf));
+}
+END_TEST
+
+
+START_TEST (test_wiovbuf_bytes)
+{
+    w_iovbuf_t iovbuf = W_IOVBUF;
+    w_bytes_t *b = w_bytes_new ("0123456789", 10);
+    w_bytes_t *s1 = w_bytes_slice (b, 0, 4);
+    w_bytes_t *s2 = w_bytes_slice (b, 4, 6);
+
+    /* Contiguous slices of the same owner are merged. */
+    w_iovbuf_append_bytes (&iovbuf, s1);
+    w_iovbuf_append_bytes (&iovbuf, s2);
+    w_iovbuf_append_str (&iovbuf, "-");
+    w_iovbuf_append_bytes (&iovbuf, s1);
+    w_obj_unref (s1);
+    w_obj_unref (s2);
+    ck_assert_int_eq (3, w_iovbuf_count (&iovbuf));
+    ck_assert_int_eq (3, ((w_obj_t*) b)->__refs & ~W__OBJ_FLAGS);
+
+    /* The buffer keeps the memory alive. */
+    w_obj_unref (b);
+
+    w_buf_t out = W_BUF;
+    w_io_buf_t iobuf;
+    w_io_buf_init (&iobuf, &out, false);
+    w_io_result_t r = w_io_write_iovbuf ((w_io_t*) &iobuf, &iovbuf);
+    ck_assert_int_eq (15, w_io_result_bytes (r));
+    ck_assert_str_eq ("0123456789-0123", w_buf_cstr (&out));
+    w_buf_clear (&out);
+
+    w_iovbuf_clear (&iovbuf);
+}
+END_TEST
+
+
+START_TEST (test_wiovbuf_writev)
+{
+    char path[] = "/tmp/check-wiovbuf-XXXXXX";
+    int fd = mkstemp (path);
+    fail_if (fd < 0, "Cannot create temporary file");
+    unlink (path);
+
+    /* More segments than a single writev() call accepts, plus big pieces. */
+    static const char a[] = "ab", b[] = "cd";
+    w_iovbuf_t iovbuf = W_IOVBUF;
+    w_buf_t expected = W_BUF;
+    for (unsigned i = 0; i < 3000; i++) {
+        const char *p = (i % 2) ? b : a;
+        w_iovbuf_append_borrowed (&iovbuf, p, 2);
+        w_buf_append_mem (&expected, p, 2);
+        if (i % 1000 == 0) {
+            char big[5000];
+            memset (big, 'a' + i / 1000, sizeof (big));
+            w_iovbuf_append_mem (&iovbuf, big, sizeof (big));
+            w_buf_append_mem (&expected, big, sizeof (big));
+        }
+    }
+    ck_assert_int_eq (w_buf_size (&expected), w_iovbuf_size (&iovbuf));
+
+    w_io_unix_t io;
+    w_io_unix_init_fd (&io, fd);
+    w_io_result_t r = w_io_write_iovbuf ((w_io_t*) &io, &iovbuf);
+    fail_if (w_io_failed (r), "Writing failed");
+    ck_assert_int_eq (w_buf_size (&expected), w_io_result_bytes (r));
+    w_iovbuf_clear (&iovbuf);
+
+    w_buf_t out = W_BUF;
+    read_back (fd, &out);
+    ck_assert_int_eq (w_buf_size (&expected), w_buf_size (&out));
+    fail_if (memcmp (w_buf_const_data (&expected), w_buf_const_data (&out),
+                     w_buf_size (&out)), "Data written does not match");
+    w_buf_clear (&expected);
+    w_buf_clear (&out);
+
+    W_IO_NORESULT (w_io_close ((w_io_t*) &io));
+}
+END_TEST
+
+
+static void
+check_vectored_io (w_io_t *io, w_io_t *reader)
+{
+    static const char a[] = "Hello", b[] = ", ", c[] = "world";
+    const struct iovec out[] = {
+        { .iov_base = (void*) a, .iov_len = 5 },
+        { .iov_base = (void*) b, .iov_len = 2 },
+        { .iov_base = (void*) c, .iov_len = 5 },
+    };
+    w_io_result_t r = w_io_writev (io, out, w_lengthof (out));
+    fail_if (w_io_failed (r), "Writing failed");
+    ck_assert_int_eq (12, w_io_result_bytes (r));
+
+    char x[4], y[4], z[8];
+    const struct iovec in[] = {
+        { .iov_base = x, .iov_len = sizeof (x) },
+        { .iov_base = y, .iov_len = sizeof (y) },
+        { .iov_base = z, .iov_len = sizeof (z) },
+    };
+    r = w_io_readv (reader, in, w_lengthof (in));
+    fail_if (w_io_failed (r), "Reading failed");
+    ck_assert_int_eq (12, w_io_result_bytes (r));
+    fail_if (memcmp ("Hell", x, 4));
+    fail_if (memcmp ("o, w", y, 4));
+    fail_if (memcmp ("orld", z, 4));
+
+    r = w_io_readv (reader, in, w_lengthof (in));
+    fail_unless (w_io_eof (r), "End of file not reached");
+}
+
+
+START_TEST (test_wio_vectored_buf)
+{
+    w_buf_t b = W_BUF;
+    w_buf_set_str (&b, "dropped");
+    w_io_buf_t io;
+    w_io_buf_init (&io, &b, false);
+    w_io_buf_t reader;
+    w_io_buf_init (&reader, &b, false);
+    check_vectored_io ((w_io_t*) &io, (w_io_t*) &reader);
+    ck_assert_int_eq (12, w_buf_size (&b));
+    w_buf_clear (&b);
+}
+END_TEST
+
+
+START_TEST (test_wio_vectored_buf_empty)
+{
+    w_buf_t b = W_BUF;
+    w_io_buf_t io;
+    w_io_buf_init (&io, &b, false);
+
+    /* Only empty segments, written to an empty buffer. */
+    const struct iovec out[] = {
+        { .iov_base = "", .iov_len = 0 },
+        { .iov_base = "", .iov_len = 0 },
+    };
+    w_io_result_t r = w_io_writev ((w_io_t*) &io, out, w_lengthof (out));
+    fail_if (w_io_failed (r), "Writing failed");
+    ck_assert_int_eq (0, w_io_result_bytes (r));
+    ck_assert_int_eq (0, w_buf_size (&b));
+    w_buf_clear (&b);
+}
+END_TEST
+
+
+START_TEST (test_wio_vectored_mem)
+{
+    uint8_t data[12];
+    w_io_mem_t io;
+    w_io_mem_init (&io, data, sizeof (data));
+    w_io_mem_t reader;
+    w_io_mem_init (&reader, data, sizeof (data));
+    check_vectored_io ((w_io_t*) &io, (w_io_t*) &reader);
+
+    /* No more space left. */
+    const struct iovec more = { .iov_base = "!", .iov_len = 1 };
+    w_io_result_t r = w_io_writev ((w_io_t*) &io, &more, 1);
+    fail_unless (w_io_failed (r), "Writing did not fail");
+}
+END_TEST
+
+
+START_TEST (test_wio_vectored_unix)
+{
+    int fds[2];
+    fail_if (pipe (fds) != 0, "Cannot create pipe");
+    w_io_unix_t io, reader;
+    w_io_unix_init_fd (&io, fds[1]);
+    w_io_unix_init_fd (&reader, fds[0]);
+
+    /* Closing the write end makes the reader get an end-of-file. */
+    static const char a[] = "Hello", b[] = ", ", c[] = "world";
+    const struct iovec out[] = {
+        { .iov_base = (void*) a, .iov_len = 5 },
+        { .iov_base = (void*) b, .iov_len = 2 },
+        { .iov_base = (void*) c, .iov_len = 5 },
+    };
+    w_io_result_t r = w_io_writev ((w_io_t*) &io, out, w_lengthof (out));
+    ck_assert_int_eq (12, w_io_result_bytes (r));
+    W_IO_NORESULT (w_io_close ((w_io_t*) &io));
+
+    /* The putback character is placed before the data read. */
+    char x[4], y[16];
+    const struct iovec in[] = {
+        { .iov_base = x, .iov_len = sizeof (x) },
+        { .iov_base = y, .iov_len = sizeof (y) },
+    };
+    w_io_putback ((w_io_t*) &reader, '>');
+    r = w_io_readv ((w_io_t*) &reader, in, w_lengthof (in));
+    fail_if (w_io_failed (r), "Reading failed");
+    ck_assert_int_eq (13, w_io_result_bytes (r));
+    fail_if (memcmp (">Hel", x, 4));
+    fail_if (memcmp ("lo, world", y, 9));
+
+    r = w_io_readv ((w_io_t*) &reader, in, w_lengthof (in));
+    fail_unless (w_io_eof (r), "End of file not reached");
+    W_IO_NORESULT (w_io_close ((w_io_t*) &reader));
+}
+END_TEST
+
+
+START_TEST (test_wio_vectored_unix_partial)
+{
+    int fds[2];
+    fail_if (pipe (fds) != 0, "Cannot create pipe");
+    fcntl (fds[1], F_SETFL, fcntl (fds[1], F_GETFL) | O_NONBLOCK);
+    w_io_unix_t io;
+    w_io_unix_init_fd (&io, fds[1]);
+
+    /* More than fits in the pipe, so writing stops in the middle. */
+    static char a[40000], b[40000], c[40000];
+    memset (a, 'a', sizeof (a));
+    memset (b, 'b', sizeof (b));
+    memset (c, 'c', sizeof (c));
+    const struct iovec out[] = {
+        { .iov_base = a, .iov_len = sizeof (a) },
+        { .iov_base = b, .iov_len = sizeof (b) },
+        { .iov_base = c, .iov_len = sizeof (c) },
+    };
+    w_io_result_t r = w_io_writev ((w_io_t*) &io, out, w_lengthof (out));
+    fail_if (w_io_failed (r), "Writing failed");
+    size_t written = w_io_result_bytes (r);
+    fail_unless (written > 0 && written < 120000,
+                 "Unexpected amount written: %zu", written);
+
+    /* The segments passed are left untouched. */
+    fail_unless (out[1].iov_base == b && out[1].iov_len == sizeof (b),
+                 "Segments were modified");
+
+    W_IO_NORESULT (w_io_close ((w_io_t*) &io));
+    w_buf_t data = W_BUF;
+    read_back (fds[0], &data);
+    ck_assert_int_eq (written, w_buf_size (&data));
+    const char *p = w_buf_const_data (&data);
+    for (size_t i = 0; i < written; i++)
+        fail_unless (p[i] == 'a' + (char) (i / 40000), "Bad data at %zu", i);
+    w_buf_clear (&data);
+    close (fds[0]);
+}
+END_TEST
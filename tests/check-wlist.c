@@ -92,3 +92,83 @@ START_TEST (test_wlist_iterate)
     w_obj_unref (l);
 }
 END_TEST
+
+
+START_TEST (test_wlist_array)
+{
+    w_list_t *l = w_list_new_with_backend (false, W_LIST_ARRAY);
+    long expected;
+
+    /* Wrap around the ring buffer while growing it. */
+    for (long i = 0; i < 100; i++) {
+        w_list_push_tail (l, (void*) (i + 1));
+        w_list_push_head (l, (void*) -(i + 1));
+    }
+    ck_assert_int_eq (200, w_list_size (l));
+    ck_assert_int_eq (-100, (long) w_list_at (l, 0));
+    ck_assert_int_eq (100, (long) w_list_at (l, -1));
+    ck_assert_int_eq (-1, (long) w_list_at (l, 99));
+    ck_assert_int_eq (1, (long) w_list_at (l, 100));
+
+    expected = 100;
+    w_list_foreach_reverse (i, l) {
+        ck_assert_int_eq (expected, (long) *i);
+        if (--expected == 0) expected = -1;
+    }
+    ck_assert_int_eq (-101, expected);
+
+    /* Insertions and deletions in the middle. */
+    w_list_insert_at (l, 100, (void*) 0);
+    ck_assert_int_eq (0, (long) w_list_at (l, 100));
+    ck_assert_int_eq (1, (long) w_list_at (l, 101));
+    w_list_insert_at (l, 10, (void*) 1000);
+    ck_assert_int_eq (1000, (long) w_list_at (l, 10));
+    ck_assert_int_eq (-90, (long) w_list_at (l, 11));
+    w_list_del_at (l, 10);
+    w_list_del_at (l, 100);
+    ck_assert_int_eq (200, w_list_size (l));
+    ck_assert_int_eq (-91, (long) w_list_at (l, 9));
+    ck_assert_int_eq (-90, (long) w_list_at (l, 10));
+    ck_assert_int_eq (1, (long) w_list_at (l, 100));
+
+    /* Deleting the current element while iterating. */
+    w_list_foreach (i, l)
+        if ((long) *i % 2)
+            w_list_del (l, i);
+    ck_assert_int_eq (100, w_list_size (l));
+    w_list_foreach (i, l)
+        fail_unless ((long) *i % 2 == 0, "Odd element %ld", (long) *i);
+
+    expected = -100;
+
+    while (w_list_size (l) > 1) {
+        ck_assert_int_eq (-expected, (long) w_list_pop_tail (l));
+        ck_assert_int_eq (expected, (long) w_list_pop_head (l));
+        expected += 2;
+    }
+    ck_assert_int_eq (0, w_list_size (l));
+    fail_if (w_list_first (l), "Empty list should not have first element");
+
+    w_obj_unref (l);
+}
+END_TEST
+
+
+START_TEST (test_wlist_array_refs)
+{
+    w_list_t *l = w_list_new_with_backend (true, W_LIST_ARRAY);
+    w_obj_t *obj = w_obj_new (w_obj_t);
+
+    for (unsigned i = 0; i < 20; i++)
+        w_list_append (l, obj);
+    ck_assert_int_eq (21, obj->__refs & ~W__OBJ_FLAGS);
+
+    w_list_del_at (l, 5);
+    w_list_del (l, w_list_first (l));
+    ck_assert_int_eq (19, obj->__refs & ~W__OBJ_FLAGS);
+
+    w_obj_unref (l);
+    ck_assert_int_eq (1, obj->__refs & ~W__OBJ_FLAGS);
+    w_obj_unref (obj);
+}
+END_TEST
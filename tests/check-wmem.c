@@ -0,0 +1,224 @@
+/*
+ * check-wmem.c
+ * Copyright (C) 2014 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include <check.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../wheel.h"
+
+
+START_TEST (test_wmem_arena_alloc)
+{
+    w_arena_t *arena = w_arena_new (1024, 0);
+
+    for (unsigned i = 1; i < 200; i++) {
+        char *p = w_arena_alloc (arena, i);
+        fail_unless (((uintptr_t) p % W_ARENA_ALIGN) == 0,
+                     "Pointer %p is not aligned", p);
+        memset (p, 0xFF, i);
+    }
+
+    char *p = w_arena_alloc_aligned (arena, 10, 256);
+    fail_unless (((uintptr_t) p % 256) == 0, "Pointer %p is not aligned", p);
+
+    /* Bigger than the chunk size. */
+    p = w_arena_alloc0 (arena, 10000);
+    for (unsigned i = 0; i < 10000; i++)
+        fail_unless (p[i] == 0, "Memory is not zero-filled");
+
+    w_obj_unref (arena);
+}
+END_TEST
+
+
+START_TEST (test_wmem_arena_odd_sizes)
+{
+    /* Chunks whose size is not a multiple of the alignment. */
+    w_arena_t *arena = w_arena_new (100, 0);
+    for (unsigned i = 0; i < 300; i++) {
+        char *p = w_arena_alloc (arena, 1);
+        fail_unless (p + 1 <= arena->limit, "Pointer %p past chunk end", p);
+        *p = 0xFF;
+    }
+    w_obj_unref (arena);
+
+    /* Oversized allocations also get a chunk of an odd size. */
+    arena = w_arena_new (0, 0);
+    char *p = w_arena_alloc (arena, 70001);
+    memset (p, 0xFF, 70001);
+    for (unsigned i = 0; i < 2; i++) {
+        p = w_arena_alloc (arena, 1);
+        fail_unless (p + 1 <= arena->limit, "Pointer %p past chunk end", p);
+        *p = 0xFF;
+    }
+    w_obj_unref (arena);
+}
+END_TEST
+
+
+START_TEST (test_wmem_arena_mark_reset)
+{
+    w_arena_t *arena = w_arena_new (512, W_ARENA_MMAP);
+    char *first = w_arena_alloc (arena, 16);
+    w_arena_mark_t mark = w_arena_mark (arena);
+
+    char *p = w_arena_alloc (arena, 16);
+    for (unsigned i = 0; i < 100; i++)
+        w_arena_alloc (arena, 100);
+
+    /* Memory allocated after the mark is handed out again. */
+    w_arena_reset (arena, mark);
+    fail_unless (w_arena_alloc (arena, 16) == p,
+                 "Memory after the mark was not reused");
+
+    w_arena_clear (arena);
+    fail_unless (arena->chunk == NULL, "Arena still has chunks");
+    fail_unless (w_arena_alloc (arena, 16) == first,
+                 "Spare chunk was not reused");
+
+    w_obj_unref (arena);
+}
+END_TEST
+
+
+START_TEST (test_wmem_arena_realloc)
+{
+    w_arena_t *arena = w_arena_new (4096, 0);
+
+    char *p = w_arena_realloc (arena, NULL, 0, 10);
+    memcpy (p, "0123456789", 10);
+    fail_unless (w_arena_realloc (arena, p, 10, 100) == p,
+                 "Last allocation was not resized in place");
+
+    char *q = w_arena_alloc (arena, 10);
+    char *r = w_arena_realloc (arena, p, 100, 200);
+    fail_unless (r != p && r != q, "Memory was not moved");
+    fail_unless (!memcmp (r, "0123456789", 10), "Contents were not kept");
+
+    w_buf_t buf = W_BUF_ARENA (arena);
+    for (unsigned i = 0; i < 1000; i++)
+        w_buf_append_str (&buf, "0123456789");
+    fail_unless (w_buf_size (&buf) == 10000, "Wrong buffer size");
+    ck_assert_str_eq ("0123456789", w_buf_str (&buf) + 9990);
+    w_buf_clear (&buf);
+
+    w_obj_unref (arena);
+}
+END_TEST
+
+
+static unsigned dtor_calls = 0;
+
+static void
+count_dtor (void *obj)
+{
+    w_unused (obj);
+    dtor_calls++;
+}
+
+START_TEST (test_wmem_arena_objects)
+{
+    w_arena_t *arena = w_arena_new (0, 0);
+
+    w_obj_t *obj = w_obj_dtor (w_arena_obj_new (arena, w_obj_t), count_dtor);
+    w_obj_ref (obj);
+    w_obj_unref (obj);
+    ck_assert_int_eq (0, dtor_calls);
+    w_obj_unref (obj);
+    ck_assert_int_eq (1, dtor_calls);
+
+    w_dict_t *d = w_dict_new_in (arena, true);
+    w_list_t *l = w_list_new_in (arena, true);
+    char key[32];
+    for (unsigned i = 0; i < 1000; i++) {
+        snprintf (key, sizeof (key), "key-%u", i);
+        w_variant_t *v = w_variant_new_in (arena, W_VARIANT_TYPE_STRING, key);
+        w_dict_set (d, key, v);
+        w_list_append (l, v);
+        w_obj_unref (v);
+    }
+    fail_unless (w_dict_size (d) == 1000, "Wrong dictionary size");
+    fail_unless (w_list_size (l) == 1000, "Wrong list size");
+    ck_assert_str_eq ("key-42", w_variant_string (w_dict_get (d, "key-42")));
+
+    /* Nothing in the arena is freed on its own. */
+    w_obj_unref (d);
+    w_obj_unref (l);
+    w_obj_unref (arena);
+}
+END_TEST
+
+
+typedef struct {
+    w_obj_t parent;
+    int     value;
+} pooled_t;
+
+START_TEST (test_wmem_obj_pool)
+{
+    static w_obj_pool_t pool = W_OBJ_POOL (pooled_t, 2);
+    w_obj_pool_stats_t stats;
+    pooled_t *objs[4];
+
+    for (unsigned i = 0; i < w_lengthof (objs); i++) {
+        objs[i] = w_obj_new_pooled (&pool, pooled_t);
+        ck_assert_int_eq (0, objs[i]->value);
+        objs[i]->value = i + 1;
+    }
+    w_obj_pool_stats (&pool, &stats);
+    ck_assert_int_eq (4, stats.misses);
+    ck_assert_int_eq (4, stats.in_use);
+
+    dtor_calls = 0;
+    for (unsigned i = 0; i < w_lengthof (objs); i++)
+        w_obj_unref (w_obj_dtor (objs[i], count_dtor));
+    ck_assert_int_eq (4, dtor_calls);
+
+    /* Reused objects are zero-filled again. */
+    pooled_t *obj = w_obj_new_pooled (&pool, pooled_t);
+    ck_assert_int_eq (0, obj->value);
+    w_obj_ref (obj);
+    w_obj_unref (obj);
+    w_obj_pool_stats (&pool, &stats);
+    ck_assert_int_eq (1, stats.hits);
+    ck_assert_int_eq (1, stats.in_use);
+    ck_assert_int_eq (4, stats.high_water);
+    w_obj_unref (obj);
+
+    w_obj_pool_stats (&pool, &stats);
+    ck_assert_int_eq (0, stats.in_use);
+}
+END_TEST
+
+
+static void*
+ref_unref_loop (void *obj)
+{
+    for (unsigned i = 0; i < 100000; i++) {
+        w_obj_ref (obj);
+        w_obj_unref (obj);
+    }
+    w_obj_unref (obj);
+    return NULL;
+}
+
+START_TEST (test_wmem_obj_atomic)
+{
+    w_obj_t *obj = w_obj_dtor (w_obj_mark_atomic (w_obj_new (w_obj_t)),
+                               count_dtor);
+    pthread_t threads[4];
+
+    dtor_calls = 0;
+    for (unsigned i = 0; i < w_lengthof (threads); i++)
+        pthread_create (&threads[i], NULL, ref_unref_loop, w_obj_ref (obj));
+    ref_unref_loop (obj);
+    for (unsigned i = 0; i < w_lengthof (threads); i++)
+        pthread_join (threads[i], NULL);
+
+    ck_assert_int_eq (1, dtor_calls);
+}
+END_TEST
@@ -51,3 +51,33 @@ START_TEST (test_wopt_set_int)
 END_TEST
 
 
+
+static int short_input_argc = -1;
+
+static w_opt_status_t
+short_input_action (const w_opt_context_t *ctx)
+{
+    short_input_argc = ctx->argc;
+    return W_OPT_OK;
+}
+
+START_TEST (test_wopt_parse_io_short_input)
+{
+    const w_opt_t options[] = {
+        { 3, 0, "three", short_input_action, NULL, "Three values" },
+        W_OPT_END
+    };
+    w_buf_t buf = W_BUF;
+    w_buf_set_str (&buf, "three a\n");
+
+    /* Input ends before all the arguments are read. */
+    w_io_buf_t io;
+    w_io_buf_init (&io, &buf, false);
+    char *msg = NULL;
+    w_opt_parse_io (options, (w_io_t*) &io, &msg);
+    ck_assert_int_eq (1, short_input_argc);
+
+    w_free (msg);
+    w_buf_clear (&buf);
+}
+END_TEST
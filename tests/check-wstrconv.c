@@ -7,6 +7,8 @@
 
 #include <check.h>
 #include <limits.h>
+#include <math.h>
+#include <stdlib.h>
 #include "../wheel.h"
 
 START_TEST (test_wstr_conv_bool_t)
@@ -412,3 +414,95 @@ START_TEST (test_wstr_conv_time_period_inval_suff)
     ck_assert_int_eq (0, val);
 }
 END_TEST
+
+START_TEST (test_wstr_conv_scan_ulong)
+{
+    unsigned long val = 0;
+
+    ck_assert_int_eq (10, w_str_scan_ulong ("1234567890xyz", 13, &val));
+    fail_unless (val == 1234567890UL, "Converted value is wrong");
+    ck_assert_int_eq (3, w_str_scan_ulong ("+42", 3, &val));
+    ck_assert_int_eq (42, val);
+
+    /* Input does not need to be null-terminated. */
+    ck_assert_int_eq (2, w_str_scan_ulong ("123", 2, &val));
+    ck_assert_int_eq (12, val);
+
+    val = 42;
+    ck_assert_int_eq (0, w_str_scan_ulong ("", 0, &val));
+    ck_assert_int_eq (0, w_str_scan_ulong ("+", 1, &val));
+    ck_assert_int_eq (0, w_str_scan_ulong ("-1", 2, &val));
+    ck_assert_int_eq (0, w_str_scan_ulong ("x1", 2, &val));
+    ck_assert_int_eq (42, val);
+
+    char buf[200];
+    int len = sprintf (buf, "%lu", ULONG_MAX);
+    ck_assert_int_eq (len, w_str_scan_ulong (buf, len, &val));
+    fail_unless (val == ULONG_MAX, "Converted value is not ULONG_MAX");
+    buf[len] = '0';
+    ck_assert_int_eq (0, w_str_scan_ulong (buf, len + 1, &val));
+}
+END_TEST
+
+START_TEST (test_wstr_conv_scan_long)
+{
+    long val = 0;
+    char buf[200];
+
+    ck_assert_int_eq (3, w_str_scan_long ("-42 ", 4, &val));
+    ck_assert_int_eq (-42, val);
+    ck_assert_int_eq (0, w_str_scan_long ("--1", 3, &val));
+    ck_assert_int_eq (0, w_str_scan_long ("-", 1, &val));
+
+    int len = sprintf (buf, "%li", LONG_MIN);
+    ck_assert_int_eq (len, w_str_scan_long (buf, len, &val));
+    fail_unless (val == LONG_MIN, "Converted value is not LONG_MIN");
+
+    len = sprintf (buf, "%li", LONG_MAX);
+    ck_assert_int_eq (len, w_str_scan_long (buf, len, &val));
+    fail_unless (val == LONG_MAX, "Converted value is not LONG_MAX");
+
+    len = sprintf (buf, "%lu", (unsigned long) LONG_MAX + 1);
+    ck_assert_int_eq (0, w_str_scan_long (buf, len, &val));
+}
+END_TEST
+
+START_TEST (test_wstr_conv_scan_double)
+{
+    static const char *values[] = {
+        "0", "-0", "1", "0.1", "3.14159", "-2.5e-3", "1e22", "1e23",
+        "123456789012345678901234", "0.000000000000000000000000123",
+        "9007199254740993", "2.2250738585072014e-308", "4.9e-324",
+        "1.7976931348623157e308", ".5", "5.",
+    };
+    double val;
+
+    /* Results are the same as those of strtod(). */
+    for (size_t i = 0; i < w_lengthof (values); i++) {
+        size_t len = strlen (values[i]);
+        ck_assert_int_eq (len, w_str_scan_double (values[i], len, &val));
+        fail_unless (val == strtod (values[i], NULL),
+                     "Converted value for '%s' is wrong", values[i]);
+    }
+    ck_assert_int_eq (2, w_str_scan_double ("-0", 2, &val));
+    fail_unless (signbit (val), "Negative zero lost its sign");
+
+    /* Exponent markers without digits are not consumed. */
+    ck_assert_int_eq (3, w_str_scan_double ("1.5e", 4, &val));
+    ck_assert_int_eq (3, w_str_scan_double ("1.5e+x", 6, &val));
+    fail_unless (val == 1.5, "Converted value is not 1.5");
+
+    ck_assert_int_eq (4, w_str_scan_double ("-inf", 4, &val));
+    fail_unless (isinf (val) && val < 0, "Converted value is not -inf");
+    ck_assert_int_eq (8, w_str_scan_double ("Infinity", 8, &val));
+    ck_assert_int_eq (3, w_str_scan_double ("NaN", 3, &val));
+    fail_unless (isnan (val), "Converted value is not NaN");
+
+    ck_assert_int_eq (0, w_str_scan_double (".", 1, &val));
+    ck_assert_int_eq (0, w_str_scan_double ("-x", 2, &val));
+    ck_assert_int_eq (0, w_str_scan_double ("1e400", 5, &val));
+
+    /* Hexadecimal notation is not supported. */
+    ck_assert_int_eq (1, w_str_scan_double ("0x10", 4, &val));
+}
+END_TEST
@@ -382,3 +382,59 @@ START_TEST (test_wtnetstr_parse_dict)
     w_buf_clear (&b);
 }
 END_TEST
+
+
+START_TEST (test_wtnetstr_parse_in_arena)
+{
+    w_arena_t *arena = w_arena_new (0, 0);
+    w_buf_t b = W_BUF;
+    w_buf_set_str (&b, "35:1:a,5:hello,1:b,15:1:1#1:2#4:true!]}");
+
+    w_variant_t *variant = w_tnetstr_parse_in (arena, &b);
+    fail_unless (variant != NULL, "Could not parse dict");
+    fail_unless (w_variant_is_dict (variant), "Result is not a dict");
+
+    w_dict_t *dict = w_variant_dict (variant);
+    ck_assert_int_eq (2, w_dict_size (dict));
+    fail_unless (dict->arena == arena, "Dict not allocated in the arena");
+    ck_assert_str_eq ("hello", w_variant_string (w_dict_get (dict, "a")));
+
+    w_variant_t *item = w_dict_get (dict, "b");
+    fail_unless (w_variant_is_list (item), "Item 'b' is not a list");
+    ck_assert_int_eq (3, w_list_size (w_variant_list (item)));
+
+    /* Everything is released at once along with the arena. */
+    w_buf_clear (&b);
+    w_obj_unref (arena);
+}
+END_TEST
+
+
+START_TEST (test_wtnetstr_write)
+{
+    w_buf_t b = W_BUF;
+    w_io_buf_t io;
+    w_io_buf_init (&io, &b, false);
+
+    w_io_result_t r = w_tnetstr_write_string ((w_io_t*) &io, "hello");
+    ck_assert_int_eq (8, w_io_result_bytes (r));
+    r = w_tnetstr_write_string ((w_io_t*) &io, "");
+    ck_assert_int_eq (3, w_io_result_bytes (r));
+    r = w_tnetstr_write_number ((w_io_t*) &io, 1234567890);
+    ck_assert_int_eq (14, w_io_result_bytes (r));
+
+    w_buf_t payload = W_BUF;
+    for (unsigned i = 0; i < 12345; i++)
+        w_buf_append_char (&payload, 'x');
+    r = w_tnetstr_write_buffer ((w_io_t*) &io, &payload);
+    ck_assert_int_eq (12345 + 7, w_io_result_bytes (r));
+    w_buf_clear (&payload);
+
+    ck_assert_int_eq (8 + 3 + 14 + 12352, w_buf_size (&b));
+    fail_if (memcmp ("5:hello,0:,10:1234567890#12345:xx",
+                     w_buf_const_data (&b), 33));
+    ck_assert_int_eq (',', w_buf_const_data (&b)[w_buf_size (&b) - 1]);
+
+    w_buf_clear (&b);
+}
+END_TEST
@@ -52,7 +52,7 @@ START_TEST (test_wvariant_store_vals)
     fail_if (list != w_variant_list (var),
              "List stored in variant is not the same");
     /* Adding the list in the variant increases the refcount */
-    ck_assert_int_eq (2, list->parent.__refs);
+    ck_assert_int_eq (2, list->parent.__refs & ~W__OBJ_FLAGS);
     w_obj_unref (list);
     w_obj_unref (var);
 
@@ -62,7 +62,7 @@ START_TEST (test_wvariant_store_vals)
     fail_if (dict != w_variant_dict (var),
              "Dict stored in variant is not the same");
     /* adding the dict in the variant increases the refcount */
-    ck_assert_int_eq (2, dict->parent.__refs);
+    ck_assert_int_eq (2, dict->parent.__refs & ~W__OBJ_FLAGS);
     w_obj_unref (dict);
     w_obj_unref (var);
 }
@@ -78,24 +78,24 @@ START_TEST (test_wvariant_mutate)
     /* mutate to a list, the list gets an extra ref */
     w_variant_set_list (var, list);
     ck_assert_int_eq (W_VARIANT_TYPE_LIST, w_variant_type (var));
-    ck_assert_int_eq (2, list->parent.__refs);
+    ck_assert_int_eq (2, list->parent.__refs & ~W__OBJ_FLAGS);
 
     /* mutate to a null, the list gets one less ref */
     w_variant_set_null (var);
     ck_assert_int_eq (W_VARIANT_TYPE_NULL, w_variant_type (var));
-    ck_assert_int_eq (1, list->parent.__refs);
+    ck_assert_int_eq (1, list->parent.__refs & ~W__OBJ_FLAGS);
 
     /* Mutate again to a list */
     w_variant_set_list (var, list);
     ck_assert_int_eq (W_VARIANT_TYPE_LIST, w_variant_type (var));
-    ck_assert_int_eq (2, list->parent.__refs);
+    ck_assert_int_eq (2, list->parent.__refs & ~W__OBJ_FLAGS);
 
     w_obj_unref (list); /* not used after this point */
 
     /* now to a dictionary */
     w_variant_set_dict (var, dict);
     ck_assert_int_eq (W_VARIANT_TYPE_DICT, w_variant_type (var));
-    ck_assert_int_eq (2, dict->parent.__refs);
+    ck_assert_int_eq (2, dict->parent.__refs & ~W__OBJ_FLAGS);
 
     /*
      * now, if we unref the dict, it should still have one ref (held
@@ -103,7 +103,7 @@ START_TEST (test_wvariant_mutate)
      * also the dict.
      */
     w_obj_unref (dict);
-    ck_assert_int_eq (1, dict->parent.__refs);
+    ck_assert_int_eq (1, dict->parent.__refs & ~W__OBJ_FLAGS);
 
     w_obj_unref (var);
 }
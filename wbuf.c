@@ -46,6 +46,20 @@
 /*~t w_buf_t
  *
  * Buffer type.
+ *
+ * .. warning::
+ *
+ *    Short contents are stored inside the ``w_buf_t`` itself, and its
+ *    ``data`` member then points into the structure. Buffers must not be
+ *    copied by value (or moved with ``memcpy()``) once they have contents:
+ *    the copy would keep pointing to the storage of the original buffer.
+ *    Pass pointers to buffers around instead, or use
+ *    :func:`w_buf_append_buf()` to copy the contents.
+ *
+ *    The amount of inline storage is given by the ``W_BUF_INLINE_SIZE``
+ *    macro, which changes the layout of the structure: programs which
+ *    define it must use the same value which was used to build the
+ *    library.
  */
 
 /**
@@ -63,6 +77,13 @@
  *      w_buf_t buffer = W_BUF;
  */
 
+/*~M W_BUF_ARENA(arena)
+ *
+ * Initializer for buffers which keep their contents in memory allocated
+ * from an `arena`. Clearing such a buffer does not release its memory,
+ * which is released along with the arena instead.
+ */
+
 /**
  * Functions
  * ---------
@@ -70,28 +91,97 @@
 
 #include "wheel.h"
 
-#ifndef W_BUF_CHUNK_SIZE
-#define W_BUF_CHUNK_SIZE 512
-#endif /* !W_BUF_CHUNK_SIZE */
+/* Minimum amount of memory allocated for the contents of a buffer. */
+#ifndef W_BUF_MIN_SIZE
+#define W_BUF_MIN_SIZE 64
+#endif /* !W_BUF_MIN_SIZE */
+
+/* Percentage of the allocated size added when a buffer needs to grow. */
+#ifndef W_BUF_GROWTH_PERCENT
+#define W_BUF_GROWTH_PERCENT 100
+#endif /* !W_BUF_GROWTH_PERCENT */
+
+/* Maximum amount of unused memory added when a buffer needs to grow. */
+#ifndef W_BUF_MAX_SLACK
+#define W_BUF_MAX_SLACK (4 * 1024 * 1024)
+#endif /* !W_BUF_MAX_SLACK */
+
+
+#if W_BUF_INLINE_SIZE > 0
+# define _BUF_IS_INLINE(_b) ((_b)->data == (_b)->inline_data)
+#else
+# define _BUF_IS_INLINE(_b) false
+#endif /* W_BUF_INLINE_SIZE > 0 */
+
+
+static inline bool
+_buf_use_inline (w_buf_t *buf, size_t size)
+{
+#if W_BUF_INLINE_SIZE > 0
+    if (!buf->data && size < W_BUF_INLINE_SIZE) {
+        buf->data  = buf->inline_data;
+        buf->alloc = W_BUF_INLINE_SIZE - 1;
+        return true;
+    }
+#else
+    w_unused (buf);
+    w_unused (size);
+#endif /* W_BUF_INLINE_SIZE > 0 */
+    return false;
+}
+
+
+static inline void
+_buf_realloc (w_buf_t *buf, size_t nsz)
+{
+    if (_BUF_IS_INLINE (buf)) {
+        char *data = buf->arena
+            ? w_arena_alloc (buf->arena, nsz + 1)
+            : w_alloc (char, nsz + 1);
+        memcpy (data, buf->data, (buf->size < nsz) ? buf->size : nsz);
+        buf->data = data;
+    }
+    else {
+        buf->data = buf->arena
+            ? w_arena_realloc (buf->arena, buf->data,
+                               buf->data ? buf->alloc + 1 : 0, nsz + 1)
+            : w_resize (buf->data, char, nsz + 1);
+    }
+    buf->alloc = nsz;
+}
+
+
+/*
+ * Growing the allocation by a fraction of its current size, instead of
+ * by a fixed amount, makes appending amortized O(1) per byte.
+ */
+static size_t
+_buf_grown_size (const w_buf_t *buf, size_t size)
+{
+    size_t grow = buf->alloc / 100 * W_BUF_GROWTH_PERCENT +
+                  buf->alloc % 100 * W_BUF_GROWTH_PERCENT / 100;
+    if (grow > W_BUF_MAX_SLACK)
+        grow = W_BUF_MAX_SLACK;
+
+    size_t nsz = buf->alloc + grow;
+    if (nsz < size)
+        nsz = size;
+    return (nsz < W_BUF_MIN_SIZE) ? W_BUF_MIN_SIZE : nsz;
+}
 
 
 static inline void
 _buf_resize (w_buf_t *buf, size_t size)
 {
     if (size) {
-        size_t nsz = W_BUF_CHUNK_SIZE * ((size / W_BUF_CHUNK_SIZE) + 1);
-        if (nsz < size) {
-            nsz = size;
-        }
-        if (nsz != buf->alloc) {
-            buf->data  = w_resize (buf->data, char, nsz + 1);
-            buf->alloc = nsz;
-        }
+        if (size > buf->alloc && !_buf_use_inline (buf, size))
+            _buf_realloc (buf, _buf_grown_size (buf, size));
     }
     else {
-        if (buf->data) {
+        if (buf->data && !buf->arena && !_BUF_IS_INLINE (buf)) {
             w_free (buf->data);
         }
+        buf->data  = NULL;
         buf->alloc = 0;
     }
 }
@@ -110,6 +200,8 @@ _buf_xresize (w_buf_t *buf, size_t size)
  * Adjust the size of a buffer keeping contents.
  * This is mostly useful for trimming contents, when shrinking the buffer.
  * When a buffer grows, random data is liklely to appear at the end.
+ * Shrinking a buffer does not release memory, use
+ * :func:`w_buf_shrink_to_fit()` for that.
  *
  * :param buffer: A w_buf_t buffer
  * :param size: size New size of the buffer
@@ -122,6 +214,56 @@ w_buf_resize (w_buf_t *buf, size_t size)
 }
 
 
+/*~f void w_buf_reserve (w_buf_t *buffer, size_t size)
+ *
+ * Ensures that a `buffer` can hold at least `size` bytes without needing
+ * to allocate more memory. The size of the contents is not changed.
+ *
+ * This is useful to avoid repeated reallocations when the final size of
+ * the contents of a buffer is known in advance.
+ */
+void
+w_buf_reserve (w_buf_t *buf, size_t size)
+{
+    w_assert (buf);
+
+    if (size > buf->alloc && !_buf_use_inline (buf, size))
+        _buf_realloc (buf, size);
+}
+
+
+/*~f void w_buf_shrink_to_fit (w_buf_t *buffer)
+ *
+ * Releases the memory of a `buffer` which is not used by its contents.
+ * Buffers initialized with :macro:`W_BUF_ARENA` are left untouched.
+ */
+void
+w_buf_shrink_to_fit (w_buf_t *buf)
+{
+    w_assert (buf);
+
+    if (buf->arena || buf->alloc == buf->size || _BUF_IS_INLINE (buf))
+        return;
+
+    if (!buf->size) {
+        _buf_resize (buf, 0);
+        return;
+    }
+
+#if W_BUF_INLINE_SIZE > 0
+    if (buf->size < W_BUF_INLINE_SIZE) {
+        memcpy (buf->inline_data, buf->data, buf->size);
+        w_free (buf->data);
+        buf->data  = buf->inline_data;
+        buf->alloc = W_BUF_INLINE_SIZE - 1;
+        return;
+    }
+#endif /* W_BUF_INLINE_SIZE > 0 */
+
+    _buf_realloc (buf, buf->size);
+}
+
+
 /*~f void w_buf_set_str (w_buf_t *buffer, const char *string)
  *
  * Set the contents of a buffer to a C string.
@@ -137,7 +279,8 @@ w_buf_set_str (w_buf_t *buf, const char *str)
 
     size_t slen = strlen (str);
     _buf_xresize (buf, slen);
-    memcpy (buf->data, str, slen);
+    if (slen)
+        memcpy (buf->data, str, slen);
 }
 
 
@@ -156,6 +299,10 @@ w_buf_append_mem (w_buf_t *buf, const void *ptr, size_t len)
     w_assert (buf);
     w_assert (ptr);
 
+    /* Nothing to copy, and the buffer may not be allocated yet. */
+    if (w_unlikely (len == 0))
+        return;
+
     size_t bsize = buf->size;
     _buf_xresize (buf, bsize + len);
     memcpy (buf->data + bsize, ptr, len);
@@ -175,8 +322,11 @@ w_buf_append_str (w_buf_t *buf, const char *str)
     w_assert (buf);
     w_assert (str);
 
+    /* Same as in w_buf_append_mem(). */
+    if (w_unlikely (!(slen = strlen (str))))
+        return;
+
     bsize = buf->size;
-    slen = strlen (str);
     _buf_xresize (buf, bsize + slen);
     memcpy (buf->data + bsize, str, slen);
 }
@@ -205,6 +355,9 @@ w_buf_append_buf (w_buf_t *buf, const w_buf_t *src)
     w_assert (buf);
     w_assert (src);
 
+    if (w_unlikely (src->size == 0))
+        return;
+
     size_t bsize = buf->size;
     _buf_xresize (buf, bsize + src->size);
     memcpy (buf->data + bsize, src->data, src->size);
@@ -225,7 +378,13 @@ w_buf_append_buf (w_buf_t *buf, const w_buf_t *src)
  *   pointer will be invalid afterwards.
  *
  * - Calling :func:`w_free()` on the returned pointer. The `buffer`
- *   will be invalid and must not be used afterwards.
+ *   will be invalid and must not be used afterwards. This cannot be
+ *   done for buffers initialized with :macro:`W_BUF_ARENA`.
+ *
+ * Short contents are stored inside the buffer itself, and this function
+ * moves them to the heap to allow the second way. If the returned pointer
+ * is only used while the `buffer` is valid, :func:`w_buf_cstr()` avoids
+ * the allocation.
  *
  * The second way is useful to assemble a string which is returned from a
  * function, for example:
@@ -251,10 +410,31 @@ w_buf_str (w_buf_t *buf)
 {
     w_assert (buf);
 
-    if (!buf->size) {
-        _buf_xresize (buf, 1);
-        buf->size = 0;
-    }
+    if (!buf->arena && (!buf->data || _BUF_IS_INLINE (buf)))
+        _buf_realloc (buf, buf->size);
+    else if (!buf->data)
+        _buf_resize (buf, 1);
+
+    buf->data[buf->size] = '\0';
+    return buf->data;
+}
+
+
+/*~f char* w_buf_cstr (w_buf_t *buffer)
+ *
+ * Obtains the contents of a `buffer` as a ``NULL``-terminated C string.
+ *
+ * Contrary to :func:`w_buf_str()`, the returned pointer must not be freed,
+ * and it is only valid until the `buffer` is modified or cleared.
+ */
+char*
+w_buf_cstr (w_buf_t *buf)
+{
+    w_assert (buf);
+
+    if (!buf->data)
+        _buf_resize (buf, 1);
+
     buf->data[buf->size] = '\0';
     return buf->data;
 }
@@ -318,6 +498,29 @@ w_buf_formatv (w_buf_t *buf, const char *fmt, va_list args)
 }
 
 
+/*~f w_io_result_t w_buf_format_compiled (w_buf_t *buffer, w_format_t *format, ...)
+ *
+ * Appends text with a compiled `format` into a `buffer`, consuming
+ * additional arguments as needed by the `format`. See
+ * :func:`w_format_compile()`.
+ */
+w_io_result_t
+w_buf_format_compiled (w_buf_t *buf, w_format_t *fmt, ...)
+{
+    w_assert (buf);
+    w_assert (fmt);
+
+    w_io_buf_t io;
+    w_io_buf_init (&io, buf, true);
+
+    va_list al;
+    va_start (al, fmt);
+    w_io_result_t r = w_io_format_compiledv ((w_io_t*) &io, fmt, al);
+    va_end (al);
+    return r;
+}
+
+
 /*~f bool w_buf_is_empty (const w_buf_t *buffer)
  *
  * Checks whether a `buffer` is empty.
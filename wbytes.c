@@ -0,0 +1,148 @@
+/*
+ * wbytes.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+/**
+ * .. _wbytes:
+ *
+ * Byte Slices
+ * ===========
+ *
+ * A chunk of bytes (:type:`w_bytes_t`) is an immutable, reference counted
+ * object which holds an area of memory. Slices of a chunk of bytes can be
+ * created with :func:`w_bytes_slice()`: they reference a range of the
+ * memory of their parent without copying it, and keep the parent alive
+ * until the last slice is released.
+ *
+ * Slices always reference the object which owns the memory, so slicing a
+ * slice does not create chains of objects, and releasing intermediate
+ * slices does not keep memory around for longer than needed.
+ *
+ * Chunks of bytes can be written using :func:`w_io_write_bytes()`, used
+ * as dictionary keys with :func:`w_dict_getb()`, :func:`w_dict_setb()`
+ * and :func:`w_dict_delb()`, and stored in variants without copying using
+ * :func:`w_variant_set_bytes()`. The tnetstring parser can also produce
+ * string values which share the memory of the input, see
+ * :func:`w_tnetstr_parse_bytes()`.
+ *
+ * Usage
+ * -----
+ *
+ * .. code-block:: c
+ *
+ *      w_buf_t b = W_BUF;
+ *      w_buf_set_str (&b, "Hello, world");
+ *
+ *      // Takes over the contents of the buffer, which is left empty.
+ *      w_bytes_t *hello = w_bytes_new_from_buf (&b);
+ *
+ *      // The slice shares the memory of "hello".
+ *      w_bytes_t *world = w_bytes_slice (hello, 7, 5);
+ *      w_obj_unref (hello);
+ *
+ *      w_io_result_t r = w_io_write_bytes (w_stdout, world);
+ *      w_obj_unref (world);
+ */
+
+/**
+ * Types
+ * -----
+ */
+
+/*~t w_bytes_t
+ *
+ * Object type of an immutable chunk of bytes.
+ */
+
+/**
+ * Functions
+ * ---------
+ */
+
+#include "wheel.h"
+
+
+static void
+w_bytes_free (void *obj)
+{
+    w_bytes_t *bytes = obj;
+
+    if (bytes->owner)
+        w_obj_unref (bytes->owner);
+    else if (bytes->data != w_obj_priv (bytes, w_bytes_t)) {
+        char *data = (char*) bytes->data;
+        w_free (data);
+    }
+}
+
+
+/*~f w_bytes_t* w_bytes_new (const void *data, size_t size)
+ *
+ * Creates a new chunk of bytes holding a copy of `size` bytes of `data`.
+ * The copy is stored in the same allocation as the object itself.
+ */
+w_bytes_t*
+w_bytes_new (const void *data, size_t size)
+{
+    w_assert (data || !size);
+
+    w_bytes_t *bytes = w_obj_new_with_priv_sized (w_bytes_t, size);
+    bytes->data = w_obj_priv (bytes, w_bytes_t);
+    bytes->size = size;
+    if (size)
+        memcpy (w_obj_priv (bytes, w_bytes_t), data, size);
+    return w_obj_dtor (bytes, w_bytes_free);
+}
+
+
+/*~f w_bytes_t* w_bytes_new_from_buf (w_buf_t *buffer)
+ *
+ * Creates a new chunk of bytes taking over the contents of a `buffer`,
+ * which is left empty. Whenever possible the memory of the buffer is
+ * used directly, without copying it.
+ */
+w_bytes_t*
+w_bytes_new_from_buf (w_buf_t *buf)
+{
+    w_assert (buf);
+
+    /* Memory from arenas cannot outlive them: make a copy. */
+    if (buf->arena) {
+        w_bytes_t *bytes = w_bytes_new (w_buf_const_data (buf), w_buf_size (buf));
+        w_buf_clear (buf);
+        return bytes;
+    }
+
+    w_bytes_t *bytes = w_obj_new (w_bytes_t);
+    bytes->size = w_buf_size (buf);
+    bytes->data = w_buf_str (buf);
+    *buf = (w_buf_t) W_BUF;
+    return w_obj_dtor (bytes, w_bytes_free);
+}
+
+
+static w_obj_pool_t w_bytes_slice_pool = W_OBJ_POOL (w_bytes_t, 256);
+
+
+/*~f w_bytes_t* w_bytes_slice (w_bytes_t *bytes, size_t offset, size_t size)
+ *
+ * Creates a slice which references `size` bytes of a chunk of `bytes`,
+ * starting at `offset`. The memory is shared, and the object which owns
+ * it is kept alive until the slice is released.
+ */
+w_bytes_t*
+w_bytes_slice (w_bytes_t *bytes, size_t offset, size_t size)
+{
+    w_assert (bytes);
+    w_assert (offset <= bytes->size);
+    w_assert (size <= bytes->size - offset);
+
+    w_bytes_t *slice = w_obj_new_pooled (&w_bytes_slice_pool, w_bytes_t);
+    slice->owner = w_obj_ref (w_bytes_owner (bytes));
+    slice->data  = bytes->data + offset;
+    slice->size  = size;
+    return w_obj_dtor (slice, w_bytes_free);
+}
@@ -406,16 +406,50 @@ w_cfg_dump_file (const w_cfg_t *cf, const char *path)
     w_assert (cf);
     w_assert (path);
 
-    w_io_t *io = w_io_unix_open (path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
-    if (!io) return W_IO_RESULT_ERROR (errno ? errno : -1);
+    w_io_t *fio = w_io_unix_open (path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (!fio) return W_IO_RESULT_ERROR (errno ? errno : -1);
+
+    w_io_t *io = w_io_buffered_open (fio, 0, 0);
+    w_obj_unref (fio);
 
     w_io_result_t r = w_cfg_dump (cf, io);
+    if (!w_io_failed (r)) {
+        w_io_result_t fr = w_io_flush (io);
+        if (w_io_failed (fr)) r = fr;
+    }
     w_obj_unref (io);
 
     return r;
 }
 
 
+w_cfg_t*
+w_cfg_freeze (const w_cfg_t *cf)
+{
+    w_assert (cf);
+
+    /* Sub-nodes are frozen first, and placed in new variants. */
+    w_cfg_t *copy = w_dict_new (true);
+    w_dict_foreach (i, cf) {
+        w_variant_t *node = *i;
+        if (w_variant_is_dict (node)) {
+            w_dict_t *d = w_cfg_freeze (w_variant_dict (node));
+            node = w_variant_new (W_VARIANT_TYPE_DICT, d);
+            w_obj_unref (d);
+        } else {
+            w_obj_ref (node);
+        }
+        w_dict_setn (copy, w_dict_iterator_get_key (i),
+                     w_dict_iterator_get_keylen (i), node);
+        w_obj_unref (node);
+    }
+
+    w_cfg_t *r = w_dict_freeze (copy);
+    w_obj_unref (copy);
+    return r;
+}
+
+
 static char* parse_identifier (w_parse_t *p)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1));
@@ -541,7 +575,8 @@ w_cfg_load_file (const char *path, char **msg)
 
     w_assert (path);
 
-    if (!(io = w_io_unix_open (path, O_RDONLY, 0))) {
+    /* The parser works on the mapped file contents, without copying. */
+    if (!(io = w_io_mmap_open (path, 0))) {
         if (msg) *msg = w_cstr_format ("Could not open file '$s' for reading", path);
         return NULL;
     }
@@ -0,0 +1,271 @@
+/*
+ * wdeque.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+/**
+ * .. _wdeque:
+ *
+ * Double-Ended Queues
+ * ===================
+ *
+ * Deques store pointers in a ring buffer whose size is a power of two.
+ * Elements can be added and removed at both ends in *O(1)* time, and
+ * accessing elements by their numeric index (using :func:`w_deque_at()`)
+ * is also done in *O(1)* time. Negative indexes can be used, with the same
+ * meaning as for lists (see :ref:`wlist`).
+ *
+ * The buffer is grown as needed, but never shrunk, so a deque used as a
+ * queue does not allocate memory once it has reached its usual size.
+ *
+ * As with lists, passing ``true`` when creating a deque with
+ * :func:`w_deque_new()` makes it increase the reference counter of the
+ * elements added to it, and decrease it when they are removed.
+ *
+ * Usage
+ * -----
+ *
+ * .. code-block:: c
+ *
+ *      w_deque_t *queue = w_deque_new (false);
+ *
+ *      w_deque_push_tail (queue, "first");
+ *      w_deque_push_tail (queue, "second");
+ *
+ *      while (!w_deque_is_empty (queue))  // Prints "first second "
+ *          w_print ("$s ", (const char*) w_deque_pop_head (queue));
+ *
+ *      w_obj_unref (queue);
+ */
+
+/**
+ * Types
+ * -----
+ */
+
+/*~t w_deque_t
+ *
+ * Object type of a double-ended queue.
+ */
+
+/**
+ * Functions
+ * ---------
+ */
+
+#include "wheel.h"
+
+
+#ifndef W_DEQUE_MIN_SIZE
+#define W_DEQUE_MIN_SIZE 8
+#endif /* !W_DEQUE_MIN_SIZE */
+
+
+#define W_DEQUE_SLOT(_d, _pos) \
+    ((_d)->items[((_d)->start + (_pos)) & ((_d)->capacity - 1)])
+
+
+static void
+w_deque_free (void *obj)
+{
+    w_deque_t *deque = obj;
+    w_deque_clear (deque);
+    w_free (deque->items);
+}
+
+
+static inline void
+w_deque_grow (w_deque_t *deque)
+{
+    if (w_unlikely (deque->size == deque->capacity))
+        w_deque_reserve (deque, deque->size + 1);
+}
+
+
+/*~f w_deque_t* w_deque_new (bool reference_counted)
+ *
+ * Creates a new deque, in which elements are optionally `reference_counted`.
+ */
+w_deque_t*
+w_deque_new (bool refs)
+{
+    w_deque_t *deque = w_obj_new (w_deque_t);
+    deque->refs = refs;
+    return w_obj_dtor (deque, w_deque_free);
+}
+
+
+/*~f void w_deque_clear (w_deque_t *deque)
+ *
+ * Removes all the elements of a `deque`. The memory used to store the
+ * elements is kept, to be reused.
+ */
+void
+w_deque_clear (w_deque_t *deque)
+{
+    w_assert (deque);
+
+    if (deque->refs)
+        for (size_t pos = 0; pos < deque->size; pos++)
+            w_obj_unref (W_DEQUE_SLOT (deque, pos));
+
+    deque->size = 0;
+    deque->start = 0;
+}
+
+
+/*~f void w_deque_reserve (w_deque_t *deque, size_t size)
+ *
+ * Ensures that a `deque` can hold at least `size` elements without
+ * allocating more memory.
+ */
+void
+w_deque_reserve (w_deque_t *deque, size_t size)
+{
+    w_assert (deque);
+
+    if (size <= deque->capacity)
+        return;
+
+    size_t capacity = deque->capacity ? deque->capacity : W_DEQUE_MIN_SIZE;
+    while (capacity < size)
+        capacity *= 2;
+
+    void **items = w_alloc (void*, capacity);
+    for (size_t pos = 0; pos < deque->size; pos++)
+        items[pos] = W_DEQUE_SLOT (deque, pos);
+
+    w_free (deque->items);
+    deque->items = items;
+    deque->capacity = capacity;
+    deque->start = 0;
+}
+
+
+/*~f void w_deque_push_head (w_deque_t *deque, void *element)
+ *
+ * Inserts an `element` at the beginning of a `deque`.
+ */
+void
+w_deque_push_head (w_deque_t *deque, void *item)
+{
+    w_assert (deque);
+
+    w_deque_grow (deque);
+    deque->start = (deque->start - 1) & (deque->capacity - 1);
+    deque->items[deque->start] = deque->refs ? w_obj_ref (item) : item;
+    deque->size++;
+}
+
+
+/*~f void w_deque_push_tail (w_deque_t *deque, void *element)
+ *
+ * Appends an `element` to the end of a `deque`.
+ */
+void
+w_deque_push_tail (w_deque_t *deque, void *item)
+{
+    w_assert (deque);
+
+    w_deque_grow (deque);
+    W_DEQUE_SLOT (deque, deque->size) = deque->refs ? w_obj_ref (item) : item;
+    deque->size++;
+}
+
+
+/*~f void* w_deque_pop_head (w_deque_t *deque)
+ *
+ * Removes the element at the beginning of a `deque` and returns it.
+ *
+ * Note that this **will not** decrease the reference counter when reference
+ * counting is enabled: it is assumed that the caller will use the returned
+ * item.
+ */
+void*
+w_deque_pop_head (w_deque_t *deque)
+{
+    w_assert (deque);
+    w_assert (deque->size > 0);
+
+    void *item = deque->items[deque->start];
+    deque->start = (deque->start + 1) & (deque->capacity - 1);
+    deque->size--;
+    return item;
+}
+
+
+/*~f void* w_deque_pop_tail (w_deque_t *deque)
+ *
+ * Removes the element at the end of a `deque` and returns it.
+ *
+ * Note that this **will not** decrease the reference counter when reference
+ * counting is enabled: it is assumed that the caller will use the returned
+ * item.
+ */
+void*
+w_deque_pop_tail (w_deque_t *deque)
+{
+    w_assert (deque);
+    w_assert (deque->size > 0);
+
+    return W_DEQUE_SLOT (deque, --deque->size);
+}
+
+
+/*~f void w_deque_del_at (w_deque_t *deque, long index)
+ *
+ * Deletes the element at a given `index` in a `deque`. The elements on the
+ * shorter side of the deleted one are moved, so in general this function
+ * runs in *O(n)* time, but deleting the first or last elements is done in
+ * constant time.
+ */
+void
+w_deque_del_at (w_deque_t *deque, long index)
+{
+    w_assert (deque);
+
+    size_t pos = (index < 0) ? deque->size + index : (size_t) index;
+    w_assert (pos < deque->size);
+
+    if (deque->refs)
+        w_obj_unref (W_DEQUE_SLOT (deque, pos));
+
+    if (pos < deque->size - pos - 1) {
+        for (size_t k = pos; k > 0; k--)
+            W_DEQUE_SLOT (deque, k) = W_DEQUE_SLOT (deque, k - 1);
+        deque->start = (deque->start + 1) & (deque->capacity - 1);
+    }
+    else {
+        for (size_t k = pos + 1; k < deque->size; k++)
+            W_DEQUE_SLOT (deque, k - 1) = W_DEQUE_SLOT (deque, k);
+    }
+    deque->size--;
+}
+
+/*~f size_t w_deque_size (const w_deque_t *deque)
+ *
+ * Obtains the number of elements in a `deque`.
+ */
+
+/*~f bool w_deque_is_empty (const w_deque_t *deque)
+ *
+ * Checks whether a `deque` is empty.
+ */
+
+/*~f void* w_deque_at (const w_deque_t *deque, long index)
+ *
+ * Obtains the element stored in a `deque` at a given `index`. Negative
+ * indexes count from the end of the deque.
+ */
+
+/*~f void* w_deque_head (const w_deque_t *deque)
+ *
+ * Obtains the element at the beginning of a `deque`.
+ */
+
+/*~f void* w_deque_tail (const w_deque_t *deque)
+ *
+ * Obtains the element at the end of a `deque`.
+ */
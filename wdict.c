@@ -8,6 +8,19 @@
 
 #include "wheel.h"
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif /* __SSE2__ */
+
+#ifndef W_DICT_DEFAULT_BACKEND
+#define W_DICT_DEFAULT_BACKEND W_DICT_CHAINED
+#endif /* !W_DICT_DEFAULT_BACKEND */
 
 #ifndef W_DICT_DEFAULT_SIZE
 #define W_DICT_DEFAULT_SIZE 128
@@ -17,26 +30,98 @@
 #define W_DICT_RESIZE_FACTOR 10
 #endif /* !W_DICT_RESIZE_FACTOR */
 
+/* Must be a power of two. */
+#ifndef W_DICT_OPEN_RESIZE_FACTOR
+#define W_DICT_OPEN_RESIZE_FACTOR 2
+#endif /* !W_DICT_OPEN_RESIZE_FACTOR */
+
 #ifndef W_DICT_COUNT_TO_SIZE_RATIO
 #define W_DICT_COUNT_TO_SIZE_RATIO 1.2
 #endif /* !W_DICT_COUNT_TO_SIZE_RATIO */
 
-#ifndef W_DICT_HASH
-#define W_DICT_HASH(_k, _s) (w_str_hash (_k) % ((_s) - 1))
-#endif /* !W_DICT_HASH */
+#ifndef W_DICT_INCREMENTAL_REHASH
+#define W_DICT_INCREMENTAL_REHASH false
+#endif /* !W_DICT_INCREMENTAL_REHASH */
+
+#ifndef W_DICT_SLAB_DEFAULT
+#define W_DICT_SLAB_DEFAULT false
+#endif /* !W_DICT_SLAB_DEFAULT */
+
+#ifndef W_DICT_SLAB_CHUNK_MIN
+#define W_DICT_SLAB_CHUNK_MIN (16 * 1024)
+#endif /* !W_DICT_SLAB_CHUNK_MIN */
+
+#ifndef W_DICT_SLAB_CHUNK_MAX
+#define W_DICT_SLAB_CHUNK_MAX (2 * 1024 * 1024)
+#endif /* !W_DICT_SLAB_CHUNK_MAX */
+
+/* Nodes bigger than this (including the key) are allocated with w_malloc(). */
+#ifndef W_DICT_SLAB_MAX_ITEM
+#define W_DICT_SLAB_MAX_ITEM 512
+#endif /* !W_DICT_SLAB_MAX_ITEM */
 
+#define W_DICT_SLAB_ALIGN   8
+#define W_DICT_SLAB_CLASSES (W_DICT_SLAB_MAX_ITEM / W_DICT_SLAB_ALIGN)
+
+/* Average number of keys per bucket of frozen dictionaries. */
+#ifndef W_DICT_FROZEN_BUCKET_SIZE
+#define W_DICT_FROZEN_BUCKET_SIZE 4
+#endif /* !W_DICT_FROZEN_BUCKET_SIZE */
+
+/* Displacements tried for a bucket before trying with a different seed. */
+#define W_DICT_FROZEN_MAX_DISP (1 << 20)
+
+/* Number of buckets (or slots) migrated on each operation. */
+#ifndef W_DICT_REHASH_STEP
+#define W_DICT_REHASH_STEP 16
+#endif /* !W_DICT_REHASH_STEP */
+
+/*
+ * Keys are always hashed and compared along with their length. Both macros
+ * can be overridden, e.g. for case-insensitive keys; keys which compare
+ * equal must have the same length and hash.
+ */
 #ifndef W_DICT_HASHN
-#define W_DICT_HASHN(_k, _s, _n) (w_str_hashl (_k, _n) % ((_s) - 1))
+#define W_DICT_HASHN(_k, _n) (w_str_hashl ((_k), (_n)))
 #endif /* !W_DICT_HASHN */
 
-#ifndef W_DICT_KEY_EQ
-#define W_DICT_KEY_EQ(_a, _b) (!strcmp((_a), (_b)))
-#endif /* !W_DICT_KEY_EQ */
-
 #ifndef W_DICT_KEY_EQN
-#define W_DICT_KEY_EQN(_a, _b, _blen) (!strncmp((_a), (_b), (_blen)))
+#define W_DICT_KEY_EQN(_a, _b, _blen) (!memcmp ((_a), (_b), (_blen)))
 #endif /* !W_DICT_KEY_EQN */
 
+#if defined(W_DICT_HASH) || defined(W_DICT_KEY_EQ)
+#error W_DICT_HASH and W_DICT_KEY_EQ are unused, define W_DICT_HASHN and W_DICT_KEY_EQN instead
+#endif /* W_DICT_HASH || W_DICT_KEY_EQ */
+
+#define W_DICT_BUCKET(_h, _s) ((_h) % ((_s) - 1))
+
+#define W_DICT_CHECK_MUTABLE(_d) \
+	do { if ((_d)->backend == W_DICT_FROZEN) \
+		W_BUG ("Frozen dictionaries cannot be modified.\n"); } while (0)
+
+
+
+/*
+ * Open addressing layout: "d->nodes" is a power-of-two table of node
+ * pointers and "d->ctrl" has one control byte per slot. A control byte
+ * is either EMPTY, DELETED (a tombstone), or the lower 7 bits of the hash
+ * of the key stored in the slot. Lookups compare a whole group of control
+ * bytes at once (using SSE2 when available) and only compare keys for the
+ * slots whose control byte matches. The first group of control bytes is
+ * mirrored after the end of the table, so groups never need to wrap around.
+ */
+#define W_DICT_GROUP_WIDTH 16
+#define W_DICT_CTRL_EMPTY   ((uint8_t) 0x80)
+#define W_DICT_CTRL_DELETED ((uint8_t) 0xFE)
+#define W_DICT_CTRL_IS_FULL(_c) (((_c) & 0x80) == 0)
+#define W_DICT_NO_SLOT      ((size_t) -1)
+
+#define W_DICT_H1(_h) ((_h) >> 7)
+#define W_DICT_H2(_h) ((uint8_t) ((_h) & 0x7F))
+
+/* Maximum load factor of 7/8 for the open addressing layout. */
+#define W_DICT_CAPACITY_TO_GROWTH(_c) ((_c) - (_c) / 8)
+
 
 /*
  * XXX  Never, NEVER, change the layout of this struct. If  XXX
@@ -50,30 +135,148 @@ struct w_dict_node
 	w_dict_node_t *next;
 	w_dict_node_t *nextNode;
 	w_dict_node_t *prevNode;
+	uint64_t hash;
+	size_t keylen;
 };
 
 
+/* Keys are stored right after the node, in the same allocation. */
+#define W_DICT_NODE_SIZE(_keylen) (sizeof (w_dict_node_t) + (_keylen) + 1)
+
+
+/*
+ * Slabs hand out memory for nodes from large chunks, using a free list for
+ * each size class (multiples of W_DICT_SLAB_ALIGN) to reuse the memory of
+ * deleted nodes. Memory is returned to the system only when the dictionary
+ * is cleared or destroyed, all chunks at once.
+ */
+struct w_dict_slab_chunk
+{
+	struct w_dict_slab_chunk *next;
+	size_t                    size;
+};
+
+struct w_dict_slab
+{
+	struct w_dict_slab_chunk *chunks;
+	char                     *bump;
+	size_t                    left;
+	size_t                    chunk_size;
+	size_t                    n_large;
+	w_dict_node_t            *free[W_DICT_SLAB_CLASSES];
+};
+
+
+static inline void
+w_dict_slab_release (struct w_dict_slab *slab)
+{
+	struct w_dict_slab_chunk *chunk = slab->chunks;
+	while (chunk) {
+		struct w_dict_slab_chunk *next = chunk->next;
+		w_free (chunk);
+		chunk = next;
+	}
+	memset (slab, 0x00, sizeof (struct w_dict_slab));
+	slab->chunk_size = W_DICT_SLAB_CHUNK_MIN;
+}
+
+
+static void*
+w_dict_slab_alloc (struct w_dict_slab *slab, size_t size)
+{
+	w_dict_node_t *node;
+	unsigned sclass = (size - 1) / W_DICT_SLAB_ALIGN;
+
+	if ((node = slab->free[sclass])) {
+		slab->free[sclass] = node->next;
+		return node;
+	}
+
+	size = (sclass + 1) * W_DICT_SLAB_ALIGN;
+	if (slab->left < size) {
+		/* Whatever is left in the current chunk is wasted. */
+		struct w_dict_slab_chunk *chunk =
+			w_malloc (sizeof (struct w_dict_slab_chunk) + slab->chunk_size);
+		chunk->size = slab->chunk_size;
+		chunk->next = slab->chunks;
+		slab->chunks = chunk;
+		slab->bump = (char*) (chunk + 1);
+		slab->left = slab->chunk_size;
+		if (slab->chunk_size < W_DICT_SLAB_CHUNK_MAX)
+			slab->chunk_size *= 2;
+	}
+
+	node = (w_dict_node_t*) slab->bump;
+	slab->bump += size;
+	slab->left -= size;
+	return node;
+}
+
+
 static inline w_dict_node_t*
-w_dict_node_newn (const char *key, size_t len, void *val)
+w_dict_node_newn (w_dict_t *d, const char *key, size_t len, uint64_t hash, void *val)
 {
 	w_dict_node_t *node;
+	size_t size = W_DICT_NODE_SIZE (len);
 	w_assert (key != NULL);
 	w_assert (len > 0);
 
-	node = w_new(w_dict_node_t);
-	node->key = w_str_dupl (key, len);
+	if (d->arena) {
+		node = w_arena_alloc (d->arena, size);
+	}
+	else if (d->slab && size <= W_DICT_SLAB_MAX_ITEM) {
+		node = w_dict_slab_alloc (d->slab, size);
+	}
+	else {
+		node = (w_dict_node_t*) w_malloc (size);
+		if (d->slab)
+			d->slab->n_large++;
+	}
+
+	node->key = (char*) (node + 1);
+	memcpy (node->key, key, len);
+	node->key[len] = '\0';
+	node->keylen = len;
+	node->hash = hash;
 	node->val = val;
+	node->next = node->nextNode = node->prevNode = NULL;
 	return node;
 }
 
 
+/*
+ * Full hashes are compared first, so key contents are only compared for
+ * actual matches. Comparing lengths makes keys with embedded NULs work.
+ */
+static inline bool
+w_dict_node_matches (const w_dict_node_t *node, const char *key, size_t len, uint64_t hash)
+{
+	return node->hash == hash && node->keylen == len && W_DICT_KEY_EQN (node->key, key, len);
+}
+
+
 static inline void
-w_dict_node_free (w_dict_node_t *node)
+w_dict_node_free (w_dict_t *d, w_dict_node_t *node)
 {
+	size_t size;
 	w_assert (node != NULL);
 	w_assert (node->key != NULL);
-	w_free (node->key);
-	w_free (node);
+
+	/* Memory from arenas is released along with the arena. */
+	if (d->arena)
+		return;
+
+	size = W_DICT_NODE_SIZE (node->keylen);
+	if (d->slab && size <= W_DICT_SLAB_MAX_ITEM) {
+		unsigned sclass = (size - 1) / W_DICT_SLAB_ALIGN;
+		node->next = d->slab->free[sclass];
+		d->slab->free[sclass] = node;
+	}
+	else {
+		if (d->slab)
+			d->slab->n_large--;
+		w_free (node);
+	}
 }
 
 
@@ -83,13 +286,374 @@ w_dict_free_nodes(w_dict_t *d)
 	w_dict_node_t *node = d->first;
 	w_dict_node_t *next;
 
+	/*
+	 * When all the nodes come from the slab, there is no need to walk
+	 * over them, and the chunks can be released right away.
+	 */
+	if (!d->refs && (d->arena || (d->slab && !d->slab->n_large)))
+		node = NULL;
+
 	while (node) {
 		next = node->nextNode;
 		if (d->refs)
 		    w_obj_unref (node->val);
-		w_dict_node_free (node);
+		if (!d->arena &&
+		    (!d->slab || W_DICT_NODE_SIZE (node->keylen) > W_DICT_SLAB_MAX_ITEM))
+			w_free (node);
 		node = next;
 	}
+
+	if (d->slab)
+		w_dict_slab_release (d->slab);
+}
+
+
+static inline void
+w_dict_node_set_val (const w_dict_t *d, w_dict_node_t *node, void *val)
+{
+	if (d->refs) {
+		w_obj_unref (node->val);
+		node->val = w_obj_ref (val);
+	}
+	else {
+		node->val = val;
+	}
+}
+
+
+static inline void
+w_dict_link_first (w_dict_t *d, w_dict_node_t *node)
+{
+	node->nextNode = d->first;
+	if (d->first) d->first->prevNode = node;
+	d->first = node;
+}
+
+
+static inline void
+w_dict_unlink (w_dict_t *d, w_dict_node_t *node)
+{
+	w_dict_node_t *prevNode = node->prevNode;
+	w_dict_node_t *nextNode = node->nextNode;
+
+	if (prevNode) prevNode->nextNode = nextNode;
+	else d->first = nextNode;
+	if (nextNode) nextNode->prevNode = prevNode;
+}
+
+
+static inline uint64_t
+w_dict_mix (uint64_t h)
+{
+	h ^= h >> 33;
+	h *= UINT64_C (0xFF51AFD7ED558CCD);
+	h ^= h >> 33;
+	h *= UINT64_C (0xC4CEB9FE1A85EC53);
+	h ^= h >> 33;
+	return h;
+}
+
+
+static inline uint64_t
+w_dict_hash (const char *key, size_t len)
+{
+	/*
+	 * Mix the bits of the hash: open addressing takes slot positions from
+	 * the higher bits, and the non-SipHash w_str_hashl() leaves most of them
+	 * unset. Chained buckets also benefit from a better distribution.
+	 */
+	return w_dict_mix (W_DICT_HASHN (key, len));
+}
+
+
+static inline uint32_t
+w_dict_group_match (const uint8_t *ctrl, uint8_t tag)
+{
+#ifdef __SSE2__
+	__m128i group = _mm_loadu_si128 ((const __m128i*) ctrl);
+	return (uint32_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (group,
+	                                                     _mm_set1_epi8 ((char) tag)));
+#else
+	uint32_t mask = 0;
+	for (unsigned i = 0; i < W_DICT_GROUP_WIDTH; i++)
+		if (ctrl[i] == tag)
+			mask |= 1U << i;
+	return mask;
+#endif /* __SSE2__ */
+}
+
+
+static inline uint32_t
+w_dict_group_match_empty (const uint8_t *ctrl)
+{
+	return w_dict_group_match (ctrl, W_DICT_CTRL_EMPTY);
+}
+
+
+/* Matches both EMPTY and DELETED slots, which have the high bit set. */
+static inline uint32_t
+w_dict_group_match_free (const uint8_t *ctrl)
+{
+#ifdef __SSE2__
+	return (uint32_t) _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i*) ctrl));
+#else
+	uint32_t mask = 0;
+	for (unsigned i = 0; i < W_DICT_GROUP_WIDTH; i++)
+		if (ctrl[i] & 0x80)
+			mask |= 1U << i;
+	return mask;
+#endif /* __SSE2__ */
+}
+
+
+static inline void
+w_dict_open_set_ctrl (uint8_t *ctrl, size_t size, size_t i, uint8_t c)
+{
+	ctrl[i] = c;
+	ctrl[((i - W_DICT_GROUP_WIDTH) & (size - 1)) + W_DICT_GROUP_WIDTH] = c;
+}
+
+
+static size_t
+w_dict_open_find (w_dict_node_t **nodes, const uint8_t *ctrl, size_t size,
+                  const char *key, size_t len, uint64_t hash)
+{
+	const size_t mask = size - 1;
+	const uint8_t tag = W_DICT_H2 (hash);
+	size_t pos = W_DICT_H1 (hash) & mask;
+	size_t stride = 0;
+
+	for (;;) {
+		const uint8_t *group = ctrl + pos;
+		/* Fetch slots in parallel with the control bytes. */
+		__builtin_prefetch (nodes + pos);
+		for (uint32_t m = w_dict_group_match (group, tag); m; m &= m - 1) {
+			size_t i = (pos + __builtin_ctz (m)) & mask;
+			if (w_dict_node_matches (nodes[i], key, len, hash))
+				return i;
+		}
+		if (w_dict_group_match_empty (group))
+			return W_DICT_NO_SLOT;
+
+		/* Triangular probing visits every group of a power-of-two table. */
+		stride += W_DICT_GROUP_WIDTH;
+		pos = (pos + stride) & mask;
+	}
+}
+
+
+static size_t
+w_dict_open_find_free (const uint8_t *ctrl, size_t size, uint64_t hash)
+{
+	const size_t mask = size - 1;
+	size_t pos = W_DICT_H1 (hash) & mask;
+	size_t stride = 0;
+
+	for (;;) {
+		uint32_t m = w_dict_group_match_free (ctrl + pos);
+		if (m)
+			return (pos + __builtin_ctz (m)) & mask;
+
+		stride += W_DICT_GROUP_WIDTH;
+		pos = (pos + stride) & mask;
+	}
+}
+
+
+/*
+ * Frozen dictionaries use a minimal perfect hash built with the "hash,
+ * displace" method: keys are first split into buckets, and then for each
+ * bucket (biggest first) a displacement value is searched which makes all
+ * of its keys land on free slots. Buckets with a single key directly store
+ * the (negated) slot. A lookup hashes the key once, reads the displacement
+ * of its bucket, and verifies the item at the resulting slot.
+ *
+ * The frozen dictionary uses its own seeded hash function, so a different
+ * seed can be tried if two keys happen to have the same hash value.
+ */
+struct w_dict_frozen
+{
+	uint64_t       seed;
+	size_t         n_buckets;
+	int32_t       *disp;
+	w_dict_node_t *items;
+};
+
+
+static uint64_t
+w_dict_frozen_hash (const char *key, size_t len, uint64_t seed)
+{
+	/* MurmurHash64A */
+	const uint64_t m = UINT64_C (0xC6A4A7935BD1E995);
+	const uint8_t *p = (const uint8_t*) key;
+	const uint8_t *end = p + (len & ~(size_t) 7);
+	uint64_t h = seed ^ (len * m);
+
+	for (; p != end; p += 8) {
+		uint64_t k;
+		memcpy (&k, p, sizeof (uint64_t));
+		k *= m;
+		k ^= k >> 47;
+		k *= m;
+		h ^= k;
+		h *= m;
+	}
+
+	switch (len & 7) {
+		case 7: h ^= (uint64_t) p[6] << 48; /* fall-through */
+		case 6: h ^= (uint64_t) p[5] << 40; /* fall-through */
+		case 5: h ^= (uint64_t) p[4] << 32; /* fall-through */
+		case 4: h ^= (uint64_t) p[3] << 24; /* fall-through */
+		case 3: h ^= (uint64_t) p[2] << 16; /* fall-through */
+		case 2: h ^= (uint64_t) p[1] << 8;  /* fall-through */
+		case 1: h ^= (uint64_t) p[0];
+		        h *= m;
+	}
+
+	h ^= h >> 47;
+	h *= m;
+	h ^= h >> 47;
+	return h;
+}
+
+
+static inline size_t
+w_dict_frozen_slot (uint64_t hash, int32_t disp, size_t n)
+{
+	/* Same as -disp - 1, which overflows for INT32_MIN in corrupt images. */
+	if (disp < 0)
+		return (size_t) ~(uint32_t) disp;
+	return w_dict_mix (hash + (uint64_t) disp * UINT64_C (0x9E3779B97F4A7C15)) % n;
+}
+
+
+static inline w_dict_node_t*
+w_dict_frozen_lookup (const w_dict_t *d, const char *key, size_t len)
+{
+	const struct w_dict_frozen *f = d->frozen;
+	if (!d->count)
+		return NULL;
+
+	uint64_t hash = w_dict_frozen_hash (key, len, f->seed);
+	size_t slot = w_dict_frozen_slot (hash, f->disp[hash % f->n_buckets], d->count);
+	w_dict_node_t *node = f->items + slot;
+	return w_dict_node_matches (node, key, len, hash) ? node : NULL;
+}
+
+
+static void
+w_dict_alloc_table (w_dict_t *d, size_t size)
+{
+	d->size  = size;
+	d->nodes = d->arena
+		? w_arena_alloc0 (d->arena, sizeof (w_dict_node_t*) * size)
+		: w_alloc0 (w_dict_node_t*, size);
+
+	if (d->backend == W_DICT_OPEN_ADDRESSING) {
+		w_assert (size >= W_DICT_GROUP_WIDTH);
+		w_assert ((size & (size - 1)) == 0);
+
+		d->ctrl = d->arena
+			? w_arena_alloc (d->arena, size + W_DICT_GROUP_WIDTH)
+			: w_alloc (uint8_t, size + W_DICT_GROUP_WIDTH);
+		memset (d->ctrl, W_DICT_CTRL_EMPTY, size + W_DICT_GROUP_WIDTH);
+
+		/*
+		 * Items still in the old table during an incremental rehash are
+		 * accounted for here, so moving them never needs to grow the table.
+		 */
+		d->growth_left = W_DICT_CAPACITY_TO_GROWTH (size) - d->count;
+	}
+}
+
+
+static void
+w_dict_free_old_table (w_dict_t *d)
+{
+	if (d->arena) {
+		d->old_nodes = NULL;
+		d->old_ctrl = NULL;
+	}
+	else {
+		w_free (d->old_nodes);
+		w_free (d->old_ctrl);
+	}
+	d->old_size = 0;
+	d->rehash_pos = 0;
+}
+
+
+/*
+ * Moves up to "steps" buckets (or slots) from the old table into the new
+ * one, and releases the old table once it has been completely migrated.
+ */
+static void
+w_dict_rehash_step (w_dict_t *d, size_t steps)
+{
+	w_assert (d->old_nodes != NULL);
+
+	for (; steps && d->rehash_pos < d->old_size; steps--, d->rehash_pos++) {
+		w_dict_node_t *node = d->old_nodes[d->rehash_pos];
+		if (!node)
+			continue;
+		d->old_nodes[d->rehash_pos] = NULL;
+
+		if (d->backend == W_DICT_OPEN_ADDRESSING) {
+			size_t i = w_dict_open_find_free (d->ctrl, d->size, node->hash);
+			w_dict_open_set_ctrl (d->ctrl, d->size, i, W_DICT_H2 (node->hash));
+			d->nodes[i] = node;
+
+			/* Keep probe sequences in the old table intact. */
+			w_dict_open_set_ctrl (d->old_ctrl, d->old_size, d->rehash_pos,
+			                      W_DICT_CTRL_DELETED);
+		}
+		else {
+			/* Chain order does not matter, prepending avoids walking it. */
+			while (node) {
+				w_dict_node_t *next = node->next;
+				size_t b = W_DICT_BUCKET (node->hash, d->size);
+				node->next = d->nodes[b];
+				d->nodes[b] = node;
+				node = next;
+			}
+		}
+	}
+
+	if (d->rehash_pos == d->old_size)
+		w_dict_free_old_table (d);
+}
+
+
+static void
+w_dict_rehash (w_dict_t *d)
+{
+	size_t size = d->size;
+
+	/* A new resize may be needed before the previous one finishes. */
+	if (d->old_nodes)
+		w_dict_rehash_step (d, d->old_size);
+
+	if (d->backend == W_DICT_OPEN_ADDRESSING) {
+		/*
+		 * Grow only when the table is actually full of items; otherwise it
+		 * is full of tombstones, and rebuilding it at the same size is
+		 * enough to reclaim them.
+		 */
+		if (d->count >= W_DICT_CAPACITY_TO_GROWTH (size) / 2)
+			size *= d->growth_factor;
+	}
+	else {
+		size = size * d->growth_factor + 1;
+	}
+
+	d->old_nodes = d->nodes;
+	d->old_ctrl  = d->ctrl;
+	d->old_size  = d->size;
+	d->rehash_pos = 0;
+	w_dict_alloc_table (d, size);
+
+	if (!d->incremental)
+		w_dict_rehash_step (d, d->old_size);
 }
 
 
@@ -98,32 +662,176 @@ _w_dict_dtor (void *obj)
 {
 	w_dict_t *d = (w_dict_t*) obj;
 	w_assert (d != NULL);
+
+	if (d->backend == W_DICT_FROZEN) {
+		/* Items are part of the same memory block. */
+		if (d->refs)
+			for (w_dict_node_t *node = d->first; node; node = node->nextNode)
+				w_obj_unref (node->val);
+		w_free (d->frozen);
+		return;
+	}
+
 	w_dict_free_nodes (d);
-	w_free (d->nodes);
+	w_dict_free_old_table (d);
+	if (!d->arena) {
+		w_free (d->nodes);
+		w_free (d->ctrl);
+	}
+	w_free (d->slab);
 }
 
 
 w_dict_t*
 w_dict_new (bool refs)
 {
-	w_dict_t *d = w_obj_new (w_dict_t);
-	d->size  = W_DICT_DEFAULT_SIZE;
-	d->nodes = w_alloc (w_dict_node_t*, d->size);
-	d->refs  = refs;
-	d->count = 0;
+	return w_dict_new_with_backend (refs, W_DICT_DEFAULT_BACKEND);
+}
+
+
+static w_dict_t*
+w_dict_init (w_dict_t *d, bool refs, w_dict_backend_t backend)
+{
+	d->refs    = refs;
+	d->count   = 0;
+	d->backend = backend;
+	d->incremental = W_DICT_INCREMENTAL_REHASH;
+
+	switch (backend) {
+		case W_DICT_CHAINED:
+			d->growth_factor = W_DICT_RESIZE_FACTOR;
+			break;
+		case W_DICT_OPEN_ADDRESSING:
+			d->growth_factor = W_DICT_OPEN_RESIZE_FACTOR;
+			break;
+		default:
+			W_BUG ("Use w_dict_freeze() to create frozen dictionaries.\n");
+	}
+
+	w_dict_alloc_table (d, W_DICT_DEFAULT_SIZE);
+	w_dict_set_slab (d, W_DICT_SLAB_DEFAULT);
 	return w_obj_dtor (d, _w_dict_dtor);
 }
 
 
+w_dict_t*
+w_dict_new_with_backend (bool refs, w_dict_backend_t backend)
+{
+	return w_dict_init (w_obj_new (w_dict_t), refs, backend);
+}
+
+
+w_dict_t*
+w_dict_new_in (w_arena_t *arena, bool refs)
+{
+	w_assert (arena != NULL);
+
+	w_dict_t *d = w_arena_obj_new (arena, w_dict_t);
+	d->arena = arena;
+	return w_dict_init (d, refs, W_DICT_DEFAULT_BACKEND);
+}
+
+
+void
+w_dict_set_slab (w_dict_t *d, bool enable)
+{
+	w_assert (d != NULL);
+	w_assert (d->count == 0);
+	W_DICT_CHECK_MUTABLE (d);
+
+	/* Dictionaries in arenas already allocate from big chunks. */
+	if (d->arena)
+		return;
+
+	if (enable && !d->slab) {
+		d->slab = w_new0 (struct w_dict_slab);
+		d->slab->chunk_size = W_DICT_SLAB_CHUNK_MIN;
+	}
+	else if (!enable && d->slab) {
+		w_dict_slab_release (d->slab);
+		w_free (d->slab);
+	}
+}
+
+
+void
+w_dict_set_growth (w_dict_t *d, unsigned factor, bool incremental)
+{
+	w_assert (d != NULL);
+	W_DICT_CHECK_MUTABLE (d);
+
+	if (factor) {
+		w_assert (factor > 1);
+		w_assert (d->backend != W_DICT_OPEN_ADDRESSING ||
+		          (factor & (factor - 1)) == 0);
+		d->growth_factor = factor;
+	}
+
+	d->incremental = incremental;
+	if (!incremental && d->old_nodes)
+		w_dict_rehash_step (d, d->old_size);
+}
+
+
+size_t
+w_dict_rehash_pending (const w_dict_t *d)
+{
+	w_assert (d != NULL);
+	return d->old_nodes
+		? (d->old_size - d->rehash_pos + W_DICT_REHASH_STEP - 1) / W_DICT_REHASH_STEP
+		: 0;
+}
+
+
 void
 w_dict_clear (w_dict_t *d)
 {
 	w_assert (d != NULL);
+	W_DICT_CHECK_MUTABLE (d);
 	w_dict_free_nodes (d);
+	w_dict_free_old_table (d);
 	memset (d->nodes, 0x00, d->size * sizeof (w_dict_node_t*));
 
 	d->first = NULL;
 	d->count = 0;
+
+	if (d->backend == W_DICT_OPEN_ADDRESSING) {
+		memset (d->ctrl, W_DICT_CTRL_EMPTY, d->size + W_DICT_GROUP_WIDTH);
+		d->growth_left = W_DICT_CAPACITY_TO_GROWTH (d->size);
+	}
+}
+
+
+/*
+ * Returns the chain where a key is to be found: during an incremental
+ * rehash, buckets below "rehash_pos" have already been moved to the new
+ * table, and the rest are still in the old one.
+ */
+static inline w_dict_node_t**
+w_dict_chained_bucket (const w_dict_t *d, uint64_t hash)
+{
+	if (d->old_nodes) {
+		size_t b = W_DICT_BUCKET (hash, d->old_size);
+		if (b >= d->rehash_pos)
+			return d->old_nodes + b;
+	}
+	return d->nodes + W_DICT_BUCKET (hash, d->size);
+}
+
+
+static inline w_dict_node_t*
+w_dict_open_lookup (const w_dict_t *d, const char *key, size_t len, uint64_t hash)
+{
+	size_t i = w_dict_open_find (d->nodes, d->ctrl, d->size, key, len, hash);
+	if (i != W_DICT_NO_SLOT)
+		return d->nodes[i];
+
+	if (d->old_nodes) {
+		i = w_dict_open_find (d->old_nodes, d->old_ctrl, d->old_size, key, len, hash);
+		if (i != W_DICT_NO_SLOT)
+			return d->old_nodes[i];
+	}
+	return NULL;
 }
 
 
@@ -137,27 +845,44 @@ w_dict_get (const w_dict_t *d, const char *key)
 void*
 w_dict_getn (const w_dict_t *d, const char *key, size_t len)
 {
+	w_dict_node_t **bucket;
 	w_dict_node_t *node;
-	unsigned hval;
+	uint64_t hash;
 
 	w_assert (d != NULL);
 	w_assert (key != NULL);
 
-	hval = W_DICT_HASHN (key, d->size, len);
-	node = d->nodes[hval];
+	if (d->backend == W_DICT_FROZEN) {
+		node = w_dict_frozen_lookup (d, key, len);
+		return node ? node->val : NULL;
+	}
+
+	/* Lookups also help moving an ongoing incremental rehash forward. */
+	if (d->old_nodes)
+		w_dict_rehash_step ((w_dict_t*) d, W_DICT_REHASH_STEP);
+
+	hash = w_dict_hash (key, len);
+
+	if (d->backend == W_DICT_OPEN_ADDRESSING) {
+		node = w_dict_open_lookup (d, key, len, hash);
+		return node ? node->val : NULL;
+	}
+
+	bucket = w_dict_chained_bucket (d, hash);
+	node = *bucket;
 
 	if (node) {
-		if (W_DICT_KEY_EQN (node->key, key, len)) {
+		if (w_dict_node_matches (node, key, len, hash)) {
 			return node->val;
 		}
 		else {
 			w_dict_node_t *lastNode = node;
 			node = node->next;
 			while (node) {
-				if (W_DICT_KEY_EQN (node->key, key, len)) {
+				if (w_dict_node_matches (node, key, len, hash)) {
 					lastNode->next = node->next;
-					node->next = d->nodes[hval];
-					d->nodes[hval] = node;
+					node->next = *bucket;
+					*bucket = node;
 					return node->val;
 				}
 				lastNode = node;
@@ -169,76 +894,126 @@ w_dict_getn (const w_dict_t *d, const char *key, size_t len)
 }
 
 
-static inline void
-w_dict_rehash (w_dict_t *d)
+void
+w_dict_set(w_dict_t *d, const char *key, void *val)
 {
-	w_dict_node_t *node = d->first;
+	w_dict_setn (d, key, strlen (key), val);
+}
 
-	while (node) {
-		node->next = NULL;
-		node = node->nextNode;
+
+static void
+w_dict_open_setn (w_dict_t *d, const char *key, size_t len, uint64_t hash, void *val)
+{
+	w_dict_node_t *node = w_dict_open_lookup (d, key, len, hash);
+
+	if (node) {
+		w_dict_node_set_val (d, node, val);
+		return;
 	}
 
-	d->size *= W_DICT_RESIZE_FACTOR;
-	d->nodes = w_resize (d->nodes, w_dict_node_t*, ++d->size);
-	memset (d->nodes, 0x00, d->size * sizeof (w_dict_node_t*));
+	if (d->growth_left == 0)
+		w_dict_rehash (d);
+
+	size_t i = w_dict_open_find_free (d->ctrl, d->size, hash);
+	if (d->ctrl[i] == W_DICT_CTRL_EMPTY)
+		d->growth_left--;
+
+	node = w_dict_node_newn (d, key, len, hash, d->refs ? w_obj_ref (val) : val);
+	w_dict_open_set_ctrl (d->ctrl, d->size, i, W_DICT_H2 (hash));
+	d->nodes[i] = node;
+
+	w_dict_link_first (d, node);
+	d->count++;
+}
 
-	for (node = d->first; node; node = node->nextNode) {
-		unsigned hval  = W_DICT_HASH (node->key, d->size);
-		w_dict_node_t *n = d->nodes[hval];
-		if (!n) d->nodes[hval] = node;
+
+static void
+w_dict_open_deln (w_dict_t *d, const char *key, size_t len, uint64_t hash)
+{
+	w_dict_node_t *node;
+	size_t i = w_dict_open_find (d->nodes, d->ctrl, d->size, key, len, hash);
+
+	if (i != W_DICT_NO_SLOT) {
+		/*
+		 * The slot can be marked as EMPTY again only if no probe sequence
+		 * could have skipped over it while looking for a free slot: that is
+		 * the case if there is no window of GROUP_WIDTH consecutive full
+		 * slots around it.
+		 */
+		const size_t mask = d->size - 1;
+		uint32_t empty_before = w_dict_group_match_empty (d->ctrl + ((i - W_DICT_GROUP_WIDTH) & mask));
+		uint32_t empty_after  = w_dict_group_match_empty (d->ctrl + i);
+		node = d->nodes[i];
+		d->nodes[i] = NULL;
+
+		if (empty_before && empty_after &&
+		    (__builtin_ctz (empty_after) + __builtin_clz (empty_before << (32 - W_DICT_GROUP_WIDTH))) < W_DICT_GROUP_WIDTH)
+		{
+			w_dict_open_set_ctrl (d->ctrl, d->size, i, W_DICT_CTRL_EMPTY);
+			d->growth_left++;
+		}
 		else {
-			for (;; n = n->next) {
-				if (!n->next) {
-					n->next = node;
-					break;
-				}
-			}
+			w_dict_open_set_ctrl (d->ctrl, d->size, i, W_DICT_CTRL_DELETED);
 		}
 	}
-}
+	else if (d->old_nodes &&
+	         (i = w_dict_open_find (d->old_nodes, d->old_ctrl, d->old_size,
+	                                key, len, hash)) != W_DICT_NO_SLOT)
+	{
+		/* Release the slot reserved in the new table for the item. */
+		node = d->old_nodes[i];
+		d->old_nodes[i] = NULL;
+		w_dict_open_set_ctrl (d->old_ctrl, d->old_size, i, W_DICT_CTRL_DELETED);
+		d->growth_left++;
+	}
+	else {
+		return;
+	}
 
+	w_dict_unlink (d, node);
 
-void
-w_dict_set(w_dict_t *d, const char *key, void *val)
-{
-	w_dict_setn (d, key, strlen (key), val);
+	if (d->refs)
+		w_obj_unref (node->val);
+
+	w_dict_node_free (d, node);
+	d->count--;
 }
 
 
 void
 w_dict_setn (w_dict_t *d, const char *key, size_t len, void *val)
 {
-	unsigned hval;
+	w_dict_node_t **bucket;
 	w_dict_node_t *node;
+	uint64_t hash;
 	w_assert (d != NULL);
 	w_assert (key != NULL);
+	W_DICT_CHECK_MUTABLE (d);
 
-	hval = W_DICT_HASHN (key, d->size, len);
-	node = d->nodes[hval];
+	if (d->old_nodes)
+		w_dict_rehash_step (d, W_DICT_REHASH_STEP);
 
-	while (node) {
-		if (W_DICT_KEY_EQN (node->key, key, len)) {
-		    if (d->refs) {
-		        w_obj_unref (node->val);
-		        node->val = w_obj_ref (val);
-            }
-            else {
-                node->val = val;
-            }
+	hash = w_dict_hash (key, len);
+
+	if (d->backend == W_DICT_OPEN_ADDRESSING) {
+		w_dict_open_setn (d, key, len, hash, val);
+		return;
+	}
+
+	bucket = w_dict_chained_bucket (d, hash);
+
+	for (node = *bucket; node; node = node->next) {
+		if (w_dict_node_matches (node, key, len, hash)) {
+			w_dict_node_set_val (d, node, val);
 			return;
 		}
-		node = node->next;
 	}
 
-	node = w_dict_node_newn(key, len, d->refs ? w_obj_ref (val) : val);
+	node = w_dict_node_newn (d, key, len, hash, d->refs ? w_obj_ref (val) : val);
+	node->next = *bucket;
+	*bucket = node;
 
-	if (d->nodes[hval]) node->next = d->nodes[hval];
-	d->nodes[hval] = node;
-
-	node->nextNode = d->first;
-	if (d->first) d->first->prevNode = node;
-	d->first = node;
+	w_dict_link_first (d, node);
 
 	d->count++;
 	if (d->count > (d->size * W_DICT_COUNT_TO_SIZE_RATIO))
@@ -256,30 +1031,37 @@ w_dict_del (w_dict_t *d, const char *key)
 void
 w_dict_deln (w_dict_t *d, const char *key, size_t keylen)
 {
-	unsigned hval;
+	w_dict_node_t **bucket;
 	w_dict_node_t *node;
 	w_dict_node_t *lastNode = NULL;
+	uint64_t hash;
 	w_assert (d != NULL);
 	w_assert (key != NULL);
+	W_DICT_CHECK_MUTABLE (d);
 
-	hval = W_DICT_HASHN (key, d->size, keylen);
+	if (d->old_nodes)
+		w_dict_rehash_step (d, W_DICT_REHASH_STEP);
 
-	for (node = d->nodes[hval]; node; node = node->next) {
-		if (W_DICT_KEY_EQN (node->key, key, keylen)) {
-			w_dict_node_t *prevNode = node->prevNode;
-			w_dict_node_t *nextNode = node->nextNode;
+	hash = w_dict_hash (key, keylen);
+
+	if (d->backend == W_DICT_OPEN_ADDRESSING) {
+		w_dict_open_deln (d, key, keylen, hash);
+		return;
+	}
 
-			if (prevNode) prevNode->nextNode = nextNode;
-			else d->first = nextNode;
-			if (nextNode) nextNode->prevNode = prevNode;
+	bucket = w_dict_chained_bucket (d, hash);
+
+	for (node = *bucket; node; lastNode = node, node = node->next) {
+		if (w_dict_node_matches (node, key, keylen, hash)) {
+			w_dict_unlink (d, node);
 
 			if (lastNode) lastNode->next = node->next;
-			else d->nodes[hval] = node->next;
+			else *bucket = node->next;
 
 			if (d->refs)
 				w_obj_unref (node->val);
 
-			w_dict_node_free (node);
+			w_dict_node_free (d, node);
 			d->count--;
 			return;
 		}
@@ -315,6 +1097,15 @@ w_dict_iterator_get_key (w_iterator_t i)
 }
 
 
+size_t
+w_dict_iterator_get_keylen (w_iterator_t i)
+{
+	w_dict_node_t *node = (w_dict_node_t*) i;
+	w_assert (i != NULL);
+	return node->keylen;
+}
+
+
 void
 w_dict_traverse (w_dict_t *d, w_traverse_fun_t f, void *ctx)
 {
@@ -355,6 +1146,431 @@ w_dict_update (w_dict_t *dst, const w_dict_t *src)
     w_assert (src != NULL);
 
     w_dict_foreach (i, src)
-        w_dict_set (dst, w_dict_iterator_get_key (i), *i);
+        w_dict_setn (dst, w_dict_iterator_get_key (i),
+                     w_dict_iterator_get_keylen (i), *i);
+}
+
+
+
+/*
+ * Tries to find displacements for all buckets using the given seed. On
+ * success the "disp" array is filled and "slot_of" contains the slot
+ * assigned to each item (in iteration order of the source dictionary).
+ */
+static bool
+w_dict_frozen_build (const uint64_t *hashes, size_t n, size_t n_buckets,
+                     int32_t *disp, size_t *slot_of)
+{
+	size_t *bucket_size  = w_alloc0 (size_t, n_buckets + 1);
+	size_t *bucket_first = w_alloc (size_t, n_buckets + 1);
+	size_t *order        = w_alloc (size_t, n_buckets);
+	size_t *items        = w_alloc (size_t, n);
+	bool   *taken        = w_alloc0 (bool, n);
+	size_t *tried        = w_alloc (size_t, n);
+	bool    failed       = false;
+
+	/* Group item indexes by bucket (counting sort). */
+	for (size_t i = 0; i < n; i++)
+		bucket_size[hashes[i] % n_buckets]++;
+	bucket_first[0] = 0;
+	for (size_t b = 0; b < n_buckets; b++)
+		bucket_first[b + 1] = bucket_first[b] + bucket_size[b];
+	for (size_t i = 0; i < n; i++) {
+		size_t b = hashes[i] % n_buckets;
+		items[bucket_first[b + 1] - bucket_size[b]--] = i;
+	}
+	for (size_t b = 0; b < n_buckets; b++)
+		bucket_size[b] = bucket_first[b + 1] - bucket_first[b];
+
+	/* Sort buckets by decreasing size (counting sort, again). */
+	size_t max_size = 0;
+	for (size_t b = 0; b < n_buckets; b++)
+		if (bucket_size[b] > max_size)
+			max_size = bucket_size[b];
+	size_t pos = 0;
+	for (size_t s = max_size; s > 0; s--)
+		for (size_t b = 0; b < n_buckets; b++)
+			if (bucket_size[b] == s)
+				order[pos++] = b;
+	for (size_t b = 0; b < n_buckets; b++)
+		disp[b] = 0;
+
+	size_t next_free = 0;
+	for (size_t o = 0; o < pos && !failed; o++) {
+		const size_t b = order[o];
+		const size_t *bitems = items + bucket_first[b];
+		const size_t bsize = bucket_size[b];
+
+		/* Single-item buckets store the slot directly. */
+		if (bsize == 1) {
+			while (taken[next_free])
+				next_free++;
+			taken[next_free] = true;
+			slot_of[bitems[0]] = next_free;
+			disp[b] = -(int32_t) next_free - 1;
+			continue;
+		}
+
+		int32_t dv;
+		for (dv = 0; dv < W_DICT_FROZEN_MAX_DISP; dv++) {
+			size_t k;
+			for (k = 0; k < bsize; k++) {
+				size_t slot = w_dict_frozen_slot (hashes[bitems[k]], dv, n);
+				if (taken[slot])
+					break;
+				/* Check for collisions inside the bucket itself. */
+				size_t j;
+				for (j = 0; j < k && tried[j] != slot; j++);
+				if (j < k)
+					break;
+				tried[k] = slot;
+			}
+			if (k == bsize)
+				break;
+		}
+
+		if (dv == W_DICT_FROZEN_MAX_DISP) {
+			failed = true;
+		} else {
+			disp[b] = dv;
+			for (size_t k = 0; k < bsize; k++) {
+				taken[tried[k]] = true;
+				slot_of[bitems[k]] = tried[k];
+			}
+		}
+	}
+
+	w_free (bucket_size);
+	w_free (bucket_first);
+	w_free (order);
+	w_free (items);
+	w_free (taken);
+	w_free (tried);
+	return failed;
+}
+
+
+/*
+ * Finds a seed for which a perfect hash can be built for the items of the
+ * dictionary, and returns it. Hashes and slots are stored in the arrays
+ * passed, indexed by position in the iteration order of the dictionary.
+ */
+static uint64_t
+w_dict_frozen_place (const w_dict_t *d, size_t n_buckets, int32_t *disp,
+                     uint64_t *hashes, size_t *slot_of)
+{
+	uint64_t seed = UINT64_C (0x5851F42D4C957F2D);
+
+	if (d->count > INT32_MAX)
+		W_FATAL ("Dictionary too big ($L items) to be frozen.\n",
+		         (unsigned long) d->count);
+
+	/* Leave a valid table in place for empty dictionaries. */
+	disp[0] = 0;
+
+	while (d->count > 0) {
+		size_t k = 0;
+		w_dict_foreach (i, d)
+			hashes[k++] = w_dict_frozen_hash (w_dict_iterator_get_key (i),
+			                                  w_dict_iterator_get_keylen (i),
+			                                  seed);
+		if (!w_dict_frozen_build (hashes, d->count, n_buckets, disp, slot_of))
+			break;
+		seed = w_dict_mix (seed + 1);
+	}
+	return seed;
+}
+
+
+w_dict_t*
+w_dict_freeze (const w_dict_t *d)
+{
+	w_assert (d != NULL);
+
+	const size_t n = d->count;
+	const size_t n_buckets = n / W_DICT_FROZEN_BUCKET_SIZE + 1;
+
+	/* Layout: header, displacements, items, key bytes. */
+	size_t key_bytes = 0;
+	w_dict_foreach (i, d)
+		key_bytes += w_dict_iterator_get_keylen (i) + 1;
+
+	const size_t disp_offset  = sizeof (struct w_dict_frozen);
+	const size_t items_offset = (disp_offset + sizeof (int32_t) * n_buckets +
+	                             sizeof (uint64_t) - 1) & ~(sizeof (uint64_t) - 1);
+	const size_t keys_offset  = items_offset + sizeof (w_dict_node_t) * n;
+
+	struct w_dict_frozen *f = (struct w_dict_frozen*) w_malloc (keys_offset + key_bytes);
+	f->n_buckets = n_buckets;
+	f->disp  = (int32_t*) ((char*) f + disp_offset);
+	f->items = (w_dict_node_t*) ((char*) f + items_offset);
+
+	uint64_t *hashes  = w_alloc (uint64_t, n + 1);
+	size_t   *slot_of = w_alloc (size_t, n + 1);
+	f->seed = w_dict_frozen_place (d, n_buckets, f->disp, hashes, slot_of);
+
+	w_dict_t *r = w_obj_new (w_dict_t);
+	r->refs    = d->refs;
+	r->count   = n;
+	r->backend = W_DICT_FROZEN;
+	r->frozen  = f;
+
+	/* Items keep the iteration order of the source dictionary. */
+	char *keys = (char*) f + keys_offset;
+	w_dict_node_t *prev = NULL;
+	size_t k = 0;
+	w_dict_foreach (i, d) {
+		w_dict_node_t *node = f->items + slot_of[k];
+		node->keylen = w_dict_iterator_get_keylen (i);
+		node->key = keys;
+		memcpy (keys, w_dict_iterator_get_key (i), node->keylen + 1);
+		keys += node->keylen + 1;
+		node->hash = hashes[k];
+		node->val = d->refs ? w_obj_ref (*i) : *i;
+		node->next = NULL;
+		node->prevNode = prev;
+		node->nextNode = NULL;
+		if (prev)
+			prev->nextNode = node;
+		else
+			r->first = node;
+		prev = node;
+		k++;
+	}
+
+	w_free (hashes);
+	w_free (slot_of);
+	return w_obj_dtor (r, _w_dict_dtor);
+}
+
+
+/*
+ * Dictionary images contain the same perfect hash used by frozen
+ * dictionaries, using offsets from the start of the image instead of
+ * pointers. All the numbers are stored in the byte order of the machine
+ * which wrote the image (hash values depend on it, too), and the image
+ * records the byte order so it can be checked when mapping it back.
+ *
+ *   header | displacements (int32_t) | slots | keys and values
+ */
+#define W_DICT_IMAGE_MAGIC      "wdictimg"
+#define W_DICT_IMAGE_BYTE_ORDER UINT32_C (0x01020304)
+#define W_DICT_IMAGE_VERSION    1
+
+struct w_dict_image_header
+{
+	char     magic[8];
+	uint32_t byte_order;
+	uint32_t version;
+	uint64_t seed;
+	uint64_t count;
+	uint64_t n_buckets;
+	uint64_t size;
+};
+
+struct w_dict_image_slot
+{
+	uint64_t hash;
+	uint64_t key;
+	uint64_t keylen;
+	uint64_t val;
+	uint64_t vallen;
+};
+
+#define W_DICT_IMAGE_SLOTS_OFFSET(_n_buckets)                    \
+	((sizeof (struct w_dict_image_header) +                      \
+	  sizeof (int32_t) * (_n_buckets) + 7) & ~(size_t) 7)
+
+
+static w_io_result_t
+w_dict_image_write (w_io_t *output,
+                    const struct w_dict_image_header *header,
+                    const int32_t *disp,
+                    const struct w_dict_image_slot *slots,
+                    const w_buf_t *data)
+{
+	static const char padding[8] = { 0 };
+	const size_t disp_size = sizeof (int32_t) * header->n_buckets;
+	const size_t slots_offset = W_DICT_IMAGE_SLOTS_OFFSET (header->n_buckets);
+	w_io_result_t r = W_IO_RESULT (0);
+
+	W_IO_CHAIN (r, w_io_write (output, header, sizeof (*header)));
+	W_IO_CHAIN (r, w_io_write (output, disp, disp_size));
+	W_IO_CHAIN (r, w_io_write (output, padding,
+	                           slots_offset - sizeof (*header) - disp_size));
+	W_IO_CHAIN (r, w_io_write (output, slots,
+	                           sizeof (struct w_dict_image_slot) * header->count));
+	W_IO_CHAIN (r, w_io_write (output, w_buf_const_data (data), w_buf_size (data)));
+	return r;
+}
+
+
+w_io_result_t
+w_dict_save_image (const w_dict_t *d, w_io_t *output)
+{
+	w_assert (d != NULL);
+	w_assert (output != NULL);
+
+	const size_t n = d->count;
+	const size_t n_buckets = n / W_DICT_FROZEN_BUCKET_SIZE + 1;
+	const size_t data_offset = W_DICT_IMAGE_SLOTS_OFFSET (n_buckets) +
+		sizeof (struct w_dict_image_slot) * n;
+
+	int32_t  *disp    = w_alloc (int32_t, n_buckets);
+	uint64_t *hashes  = w_alloc (uint64_t, n + 1);
+	size_t   *slot_of = w_alloc (size_t, n + 1);
+	struct w_dict_image_slot *slots = w_alloc (struct w_dict_image_slot, n + 1);
+	w_buf_t data = W_BUF;
+	w_io_result_t r;
+
+	struct w_dict_image_header header = {
+		.magic      = W_DICT_IMAGE_MAGIC,
+		.byte_order = W_DICT_IMAGE_BYTE_ORDER,
+		.version    = W_DICT_IMAGE_VERSION,
+		.seed       = w_dict_frozen_place (d, n_buckets, disp, hashes, slot_of),
+		.count      = n,
+		.n_buckets  = n_buckets,
+	};
+
+	size_t k = 0;
+	w_dict_foreach (i, d) {
+		struct w_dict_image_slot *slot = slots + slot_of[k];
+		slot->hash   = hashes[k++];
+		slot->keylen = w_dict_iterator_get_keylen (i);
+		slot->key    = data_offset + w_buf_size (&data);
+		w_buf_append_mem (&data, w_dict_iterator_get_key (i), slot->keylen + 1);
+		slot->val    = data_offset + w_buf_size (&data);
+
+		r = w_tnetstr_dump (&data, (const w_variant_t*) *i);
+		if (w_io_failed (r))
+			goto cleanup;
+		slot->vallen = data_offset + w_buf_size (&data) - slot->val;
+	}
+
+	header.size = data_offset + w_buf_size (&data);
+	r = w_dict_image_write (output, &header, disp, slots, &data);
+
+cleanup:
+	w_buf_clear (&data);
+	w_free (slots);
+	w_free (slot_of);
+	w_free (hashes);
+	w_free (disp);
+	return r;
+}
+
+
+static void
+_w_dict_image_dtor (void *obj)
+{
+	w_dict_image_t *image = (w_dict_image_t*) obj;
+	munmap (image->base, image->size);
 }
 
+
+w_dict_image_t*
+w_dict_map_image (const char *path)
+{
+	w_assert (path != NULL);
+
+	int fd = open (path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	void *base = MAP_FAILED;
+	int err = EINVAL;
+
+	if (fstat (fd, &st) < 0) {
+		err = errno;
+		goto error;
+	}
+	if ((size_t) st.st_size < sizeof (struct w_dict_image_header))
+		goto error;
+	if ((base = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+		err = errno;
+		goto error;
+	}
+
+	const struct w_dict_image_header *header = base;
+	if (memcmp (header->magic, W_DICT_IMAGE_MAGIC, sizeof (header->magic)))
+		goto error;
+	if (header->byte_order != W_DICT_IMAGE_BYTE_ORDER) {
+		err = ENOEXEC;
+		goto error;
+	}
+	if (header->version != W_DICT_IMAGE_VERSION ||
+	    header->size != (uint64_t) st.st_size ||
+	    header->count > INT32_MAX ||
+	    header->n_buckets == 0 ||
+	    header->n_buckets > header->size / sizeof (int32_t) ||
+	    W_DICT_IMAGE_SLOTS_OFFSET (header->n_buckets) +
+	        sizeof (struct w_dict_image_slot) * header->count > header->size)
+		goto error;
+
+	close (fd);
+
+	w_dict_image_t *image = w_obj_new (w_dict_image_t);
+	image->base  = base;
+	image->size  = st.st_size;
+	image->count = header->count;
+	image->disp  = (const int32_t*) (header + 1);
+	image->slots = (const struct w_dict_image_slot*)
+		((const char*) base + W_DICT_IMAGE_SLOTS_OFFSET (header->n_buckets));
+	return w_obj_dtor (image, _w_dict_image_dtor);
+
+error:
+	if (base != MAP_FAILED)
+		munmap (base, st.st_size);
+	close (fd);
+	errno = err;
+	return NULL;
+}
+
+
+bool
+w_dict_image_getn (const w_dict_image_t *image, const char *key, size_t len,
+                   w_buf_t *value)
+{
+	w_assert (image != NULL);
+	w_assert (key != NULL);
+	w_assert (value != NULL);
+
+	if (!image->count)
+		return true;
+
+	const struct w_dict_image_header *header = image->base;
+	uint64_t hash = w_dict_frozen_hash (key, len, header->seed);
+	size_t index = w_dict_frozen_slot (hash, image->disp[hash % header->n_buckets],
+	                                   image->count);
+	if (index >= image->count)
+		return true;
+
+	const struct w_dict_image_slot *slot = image->slots + index;
+	if (slot->hash != hash || slot->keylen != len || len > image->size ||
+	    slot->key > image->size - len ||
+	    slot->val > image->size ||
+	    slot->vallen > image->size - slot->val ||
+	    !W_DICT_KEY_EQN ((const char*) image->base + slot->key, key, len))
+		return true;
+
+	/* The buffer points into the mapped image, it must not be modified. */
+	*value = (w_buf_t) {
+		.data = (char*) image->base + slot->val,
+		.size = slot->vallen,
+	};
+	return false;
+}
+
+
+w_variant_t*
+w_dict_image_get_variant (const w_dict_image_t *image, const char *key)
+{
+	w_buf_t value;
+	w_assert (image != NULL);
+	w_assert (key != NULL);
+
+	if (w_dict_image_getn (image, key, strlen (key), &value))
+		return NULL;
+	return w_tnetstr_parse (&value);
+}
@@ -107,6 +107,9 @@ _w_event_destroy (void *obj)
 }
 
 
+static w_obj_pool_t w_event_pool = W_OBJ_POOL (w_event_t, 256);
+
+
 w_event_t*
 w_event_new (w_event_type_t type, w_event_callback_t callback, ...)
 {
@@ -116,7 +119,7 @@ w_event_new (w_event_type_t type, w_event_callback_t callback, ...)
     w_assert (callback);
     va_start (args, callback);
 
-    event = w_obj_new (w_event_t);
+    event = w_obj_new_pooled (&w_event_pool, w_event_t);
     event->callback = callback;
     event->flags    = 0;
 
@@ -152,6 +155,7 @@ _w_event_loop_destroy (void *obj)
     w_event_loop_t *loop = (w_event_loop_t*) obj;
     w_event_loop_backend_free (loop);
     w_obj_unref (loop->events);
+    w_obj_unref (loop->idle_events);
 }
 
 
@@ -168,6 +172,7 @@ w_event_loop_new (void)
 
     loop->running = false;
     loop->events  = w_list_new (true);
+    loop->idle_events = w_deque_new (true);
     loop->now     = w_timestamp_now ();
     return w_obj_dtor (loop, _w_event_loop_destroy);
 }
@@ -190,15 +195,26 @@ w_event_loop_run (w_event_loop_t *loop)
             loop->running = false;
         }
         else {
-            w_list_foreach (i, loop->idle_events) {
-                w_event_t *event = *i;
+            for (size_t i = 0; i < w_deque_size (loop->idle_events);) {
+                w_event_t *event = w_deque_at (loop->idle_events, i);
                 w_assert (event->type == W_EVENT_IDLE);
 
+                /*
+                 * The callback may remove the event from the loop, which
+                 * drops the reference held by the deque and shifts the
+                 * following entries into its position.
+                 */
+                w_obj_ref (event);
                 (*event->callback) (loop, event);
 
-                if (event->flags & W_EVENT_ONESHOT) {
-                    w_list_del (loop->idle_events, i);
+                if (i < w_deque_size (loop->idle_events) &&
+                    w_deque_at (loop->idle_events, i) == event) {
+                    if (event->flags & W_EVENT_ONESHOT)
+                        w_deque_del_at (loop->idle_events, i);
+                    else
+                        i++;
                 }
+                w_obj_unref (event);
             }
         }
     }
@@ -225,7 +241,7 @@ w_event_loop_add (w_event_loop_t *loop, w_event_t *event)
 
     /* Adding the element to the list will w_obj_ref() it, too */
     if (event->type == W_EVENT_IDLE)
-        w_list_push_tail (loop->idle_events, event);
+        w_deque_push_tail (loop->idle_events, event);
     else if (!(ret = w_event_loop_backend_add (loop, event)))
         w_list_push_head (loop->events, event);
 
@@ -241,25 +257,29 @@ w_event_loop_del (w_event_loop_t *loop, w_event_t *event)
     w_assert (loop);
     w_assert (event);
 
-    w_list_t* list = event->type == W_EVENT_IDLE
-        ? loop->idle_events
-        : loop->events;
+    /* Removing from the deque or list will also w_obj_unref() the event */
+    if (event->type == W_EVENT_IDLE) {
+        for (size_t pos = 0; pos < w_deque_size (loop->idle_events); pos++) {
+            if (w_deque_at (loop->idle_events, pos) == event) {
+                w_deque_del_at (loop->idle_events, pos);
+                return false;
+            }
+        }
+        return true;
+    }
 
-    bool ret = false;
-    for (i = w_list_first (list); i; i = w_list_next (list, i))
+    for (i = w_list_first (loop->events); i; i = w_list_next (loop->events, i))
         if (*i == event)
             goto found;
 
     return true;
 
 found:
-    /* Removing from the list will also w_obj_unref() the event */
-    if (event->type == W_EVENT_IDLE)
-        w_list_del (list, i);
-    else if (!(ret = w_event_loop_backend_del (loop, event)))
-        w_list_del (list, i);
+    if (w_event_loop_backend_del (loop, event))
+        return true;
 
-    return ret;
+    w_list_del (loop->events, i);
+    return false;
 }
 
 
@@ -273,10 +293,10 @@ found:
 
 struct w_epoll
 {
-    int       fd;
-    int       signal_fd;
-    sigset_t  signal_mask;
-    w_list_t *signal_events;
+    int        fd;
+    int        signal_fd;
+    sigset_t   signal_mask;
+    w_deque_t *signal_events;
 };
 typedef struct w_epoll w_epoll_t;
 
@@ -302,7 +322,7 @@ w_event_loop_backend_init (w_event_loop_t *loop)
      */
     ep->fd = ep->signal_fd = -1;
     sigemptyset (&ep->signal_mask);
-    ep->signal_events = w_list_new (false);
+    ep->signal_events = w_deque_new (false);
     return false;
 }
 
@@ -354,8 +374,8 @@ w_event_loop_backend_poll (w_event_loop_t *loop, w_timestamp_t timeout)
                 /* XXX This may be too drastic... */
                 abort ();
 
-            w_list_foreach (i, ep->signal_events) {
-                event = *i;
+            for (size_t j = 0; j < w_deque_size (ep->signal_events); j++) {
+                event = w_deque_at (ep->signal_events, j);
                 if (si.ssi_signo == (uint32_t) event->signum)
                     if ((*event->callback) (loop, event))
                         stop_loop = true;
@@ -425,7 +445,7 @@ w_event_loop_backend_add (w_event_loop_t *loop, w_event_t *event)
             if (sigismember (&ep->signal_mask, event->signum)) {
                 /* This kind of signal is already being handled */
                 w_assert (ep->signal_fd >= 0);
-                w_list_push_tail (ep->signal_events, event);
+                w_deque_push_tail (ep->signal_events, event);
                 return false;
             }
 
@@ -466,7 +486,7 @@ w_event_loop_backend_add (w_event_loop_t *loop, w_event_t *event)
     ret = epoll_ctl (ep->fd, EPOLL_CTL_ADD, fd, &ep_ev) != 0 && errno != EEXIST;
 
     if (!ret && event->type == W_EVENT_SIGNAL)
-        w_list_push_tail (ep->signal_events, event);
+        w_deque_push_tail (ep->signal_events, event);
 
     return ret;
 }
@@ -479,7 +499,7 @@ w_event_loop_backend_del (w_event_loop_t *loop, w_event_t *event)
 
     w_epoll_t *ep = w_obj_priv (loop, w_event_loop_t);
     struct epoll_event ep_ev;
-    w_iterator_t delpos = 0;
+    size_t delpos = SIZE_MAX;
     sigset_t sigmask;
     int fd = -1;
 
@@ -497,11 +517,16 @@ w_event_loop_backend_del (w_event_loop_t *loop, w_event_t *event)
                 return true;
 
             fd = 0;
-            w_list_foreach (i, ep->signal_events) {
-                if (((w_event_t *) *i)->signum == event->signum) fd++;
-                if (event == *i) delpos = i;
+            for (size_t i = 0; i < w_deque_size (ep->signal_events); i++) {
+                w_event_t *e = w_deque_at (ep->signal_events, i);
+                if (e->signum == event->signum) fd++;
+                if (e == event) delpos = i;
             }
 
+            /* The event was not added to the loop. */
+            if (delpos == SIZE_MAX)
+                return true;
+
             /* Last event for this signal, modify signalfd */
             if (fd == 1) {
                 sigemptyset (&sigmask);
@@ -512,7 +537,7 @@ w_event_loop_backend_del (w_event_loop_t *loop, w_event_t *event)
                 if (signalfd (ep->signal_fd, &ep->signal_mask, O_CLOEXEC) == -1)
                     return true;
             }
-            w_list_del (ep->signal_events, delpos);
+            w_deque_del_at (ep->signal_events, delpos);
             return false;
 
         case W_EVENT_FD:
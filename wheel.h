@@ -137,6 +137,7 @@ typedef void  (*w_action_fun_t)(void *object, void *context);
 #include <stdarg.h>
 #include <string.h>
 #include <setjmp.h>
+#include <sys/uio.h>
 
 #ifdef W_CONF_STDIO
 #include <stdio.h>
@@ -150,6 +151,11 @@ W_EXPORT void* w_malloc (size_t sz)
     W_FUNCTION_ATTR_NOT_NULL_RETURN
     W_FUNCTION_ATTR_MALLOC;
 
+W_EXPORT void* w_calloc (size_t n, size_t sz)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_MALLOC;
+
 W_EXPORT void* w_realloc (void *ptr, size_t sz)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT;
 
@@ -160,13 +166,13 @@ W_EXPORT void* w_realloc (void *ptr, size_t sz)
 	((_t *) w_malloc (sizeof(_t)))
 
 #define w_new0(_t) \
-    ((_t *) memset (w_new (_t), 0x00, sizeof (_t)))
+	((_t *) w_calloc (1, sizeof (_t)))
 
 #define w_alloc(_t, _n) \
 	((_t *) w_malloc (sizeof (_t) * (_n)))
 
 #define w_alloc0(_t, _n) \
-    ((_t *) memset (w_alloc ((_t), (_n)), 0x00, sizeof (_t) * (_n)))
+	((_t *) w_calloc ((_n), sizeof (_t)))
 
 #define w_resize(_p, _t, _n) \
 	((_t *) w_realloc (_p, sizeof (_t) * (_n)))
@@ -205,6 +211,34 @@ W_OBJ (w_obj_t)
 };
 
 
+/*
+ * Objects allocated from an arena have this bit set in their reference
+ * counter: their destructor is run when the counter drops to zero, but
+ * their memory is only released along with the arena.
+ */
+#define W__OBJ_ARENA (((size_t) -1 >> 1) + 1)
+
+/*
+ * Objects obtained from a w_obj_pool_t have this bit set in their reference
+ * counter, and are returned to the pool when destroyed.
+ */
+#define W__OBJ_POOLED (W__OBJ_ARENA >> 1)
+
+/*
+ * Objects with this bit set in their reference counter use atomic
+ * operations to update it, and can be shared among threads. All objects
+ * are created with the bit set when building with W_CONF_ATOMIC_REFS.
+ */
+#define W__OBJ_ATOMIC (W__OBJ_ARENA >> 2)
+
+#ifdef W_CONF_ATOMIC_REFS
+# define W__OBJ_REFS_INIT (W__OBJ_ATOMIC | 1)
+#else
+# define W__OBJ_REFS_INIT 1
+#endif /* W_CONF_ATOMIC_REFS */
+
+#define W__OBJ_FLAGS (W__OBJ_ARENA | W__OBJ_POOLED | W__OBJ_ATOMIC)
+
 static inline void* w__obj_init (w_obj_t *obj)
     W_FUNCTION_ATTR_NOT_NULL_RETURN
     W_FUNCTION_ATTR_NOT_NULL ((1));
@@ -213,19 +247,19 @@ static inline void*
 w__obj_init (w_obj_t *obj)
 {
     w_assert (obj);
-    obj->__refs = 1;
+    obj->__refs = W__OBJ_REFS_INIT;
     return obj;
 }
 
 
 #define w_obj_new_with_priv_sized(_t, _s) \
-    ((_t *) w__obj_init (w_malloc (sizeof (_t) + (_s))))
+    ((_t *) w__obj_init (w_calloc (1, sizeof (_t) + (_s))))
 
 #define w_obj_new_with_priv(_t) \
     w_obj_new_with_priv_sized (_t, sizeof (_t ## _p))
 
 #define w_obj_new(_t) \
-    ((_t *) w__obj_init (w_malloc (sizeof (_t))))
+    ((_t *) w__obj_init (w_calloc (1, sizeof (_t))))
 
 #define w_obj_priv(_p, _t) \
     ((void*) (((char*) (_p)) + sizeof (_t)))
@@ -239,6 +273,248 @@ void* w_obj_dtor (void *obj, void (*dtor)(void*))
     W_FUNCTION_ATTR_NOT_NULL ((1));
 void w_obj_mark_static (void *obj)
     W_FUNCTION_ATTR_NOT_NULL ((1));
+void* w_obj_mark_atomic (void *obj)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+
+/*!
+ * Pool of memory for objects of the same type. Destroyed objects are kept
+ * in the pool to be reused by \ref w_obj_new_pooled instead of releasing
+ * their memory. When built with \c W_CONF_PTHREAD, each thread keeps a
+ * small cache of objects, and only refilling or flushing it needs locking.
+ *
+ * Pools are statically initialized using \ref W_OBJ_POOL, and live as
+ * long as the program does.
+ */
+typedef struct w_obj_pool w_obj_pool_t;
+
+struct w_obj_pool
+{
+    size_t                   size;
+    size_t                   max_free;
+    struct w_obj_pool_state *state;
+};
+
+/*!
+ * Initializer for an object pool.
+ * \param _t Type of the objects in the pool.
+ * \param _max_free Maximum number of unused objects kept in the pool.
+ */
+#define W_OBJ_POOL(_t, _max_free) \
+    { sizeof (_t), (_max_free), NULL }
+
+/*!
+ * Statistics of an object pool. Objects taken from the pool are \e hits,
+ * and objects which had to be allocated because the pool was empty are
+ * \e misses. When threads are used, counters are updated each time the
+ * per-thread caches are refilled or flushed.
+ */
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long in_use;
+    unsigned long high_water;  /*!< Maximum value of \c in_use. */
+    unsigned long free;        /*!< Unused objects kept in the pool. */
+} w_obj_pool_stats_t;
+
+W_EXPORT void* w__obj_pool_get (w_obj_pool_t *pool)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Obtain the statistics of an object pool.
+ */
+W_EXPORT void w_obj_pool_stats (w_obj_pool_t *pool, w_obj_pool_stats_t *stats)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+/*!
+ * Create a new object of a given type using memory from a pool, which
+ * must have been initialized for the same type.
+ */
+#define w_obj_new_pooled(_pool, _t) \
+    ((_t *) w__obj_init_pooled (w__obj_pool_get (_pool)))
+
+static inline void*
+w__obj_init_pooled (void *obj)
+{
+    ((w_obj_t*) obj)->__refs = W__OBJ_POOLED | W__OBJ_REFS_INIT;
+    return obj;
+}
+
+
+/*-------------------------------------------------[ memory arenas ]------*/
+
+/*!
+ * \defgroup warena Memory arenas
+ * \addtogroup warena
+ * \{
+ *
+ * Arenas hand out memory from big chunks by moving a pointer forward, and
+ * release all of it at once. This is useful for allocating many short-lived
+ * objects, e.g. the results of parsing a request, which can then be freed
+ * in constant time by resetting the arena instead of one by one.
+ *
+ * Objects created in an arena (using \ref w_arena_obj_new or one of the
+ * constructors which take an arena) are reference counted as usual, but
+ * their memory is reused only after resetting the arena. Resetting an arena
+ * does not run destructors, so objects in an arena must not hold resources
+ * other than memory from the same arena.
+ */
+
+#ifndef W_ARENA_CHUNK_SIZE
+#define W_ARENA_CHUNK_SIZE (64 * 1024)
+#endif /* !W_ARENA_CHUNK_SIZE */
+
+/*! Default alignment for memory allocated from arenas. */
+#define W_ARENA_ALIGN (2 * sizeof (void*))
+
+/*!
+ * Flags for \ref w_arena_new.
+ */
+enum w_arena_flags
+{
+    W_ARENA_MMAP       = 1 << 0, /*!< Allocate chunks using mmap().       */
+    W_ARENA_HUGE_PAGES = 1 << 1, /*!< Use huge pages, implies mmap().     */
+};
+
+W_OBJ (w_arena_t)
+{
+    w_obj_t               parent;
+    struct w_arena_chunk *chunk;
+    struct w_arena_chunk *spare;
+    char                 *bump;
+    char                 *limit;
+    size_t                chunk_size;
+    unsigned              flags;
+};
+
+/*!
+ * Position in an arena, which can be used to release all the memory
+ * allocated after it was obtained. See \ref w_arena_mark.
+ */
+typedef struct {
+    struct w_arena_chunk *chunk;
+    char                 *bump;
+} w_arena_mark_t;
+
+/*!
+ * Create a new arena.
+ * \param chunk_size Size of the chunks obtained from the system. Passing
+ *        zero uses \ref W_ARENA_CHUNK_SIZE.
+ * \param flags Flags from \ref w_arena_flags.
+ */
+W_EXPORT w_arena_t* w_arena_new (size_t chunk_size, unsigned flags)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN;
+
+W_EXPORT void* w__arena_grow (w_arena_t *arena, size_t size, size_t align)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Allocate memory from an arena, with a given alignment (which must be
+ * a power of two). The contents of the memory are undefined.
+ */
+static inline void* w_arena_alloc_aligned (w_arena_t *arena, size_t size, size_t align)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline void*
+w_arena_alloc_aligned (w_arena_t *arena, size_t size, size_t align)
+{
+    w_assert (arena);
+    w_assert (align && !(align & (align - 1)));
+
+    uintptr_t p = ((uintptr_t) arena->bump + align - 1) & ~(uintptr_t) (align - 1);
+    if (w_unlikely (!arena->bump || p > (uintptr_t) arena->limit ||
+                    size > (size_t) ((uintptr_t) arena->limit - p)))
+        return w__arena_grow (arena, size, align);
+    arena->bump = (char*) (p + size);
+    return (void*) p;
+}
+
+/*!
+ * Allocate memory from an arena, suitably aligned for any type.
+ */
+static inline void* w_arena_alloc (w_arena_t *arena, size_t size)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline void*
+w_arena_alloc (w_arena_t *arena, size_t size)
+{
+    return w_arena_alloc_aligned (arena, size, W_ARENA_ALIGN);
+}
+
+/*!
+ * Allocate zero-filled memory from an arena.
+ */
+static inline void* w_arena_alloc0 (w_arena_t *arena, size_t size)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline void*
+w_arena_alloc0 (w_arena_t *arena, size_t size)
+{
+    return memset (w_arena_alloc (arena, size), 0x00, size);
+}
+
+/*!
+ * Resize a chunk of memory allocated from an arena. If it is the last
+ * allocation done from the arena, it is extended in place when possible.
+ * Passing \c NULL allocates a new chunk of memory.
+ */
+W_EXPORT void* w_arena_realloc (w_arena_t *arena, void *ptr, size_t old_size, size_t size)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Obtain the current position of an arena, to be passed later to
+ * \ref w_arena_reset.
+ */
+static inline w_arena_mark_t w_arena_mark (const w_arena_t *arena)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline w_arena_mark_t
+w_arena_mark (const w_arena_t *arena)
+{
+    w_assert (arena);
+    return (w_arena_mark_t) { arena->chunk, arena->bump };
+}
+
+/*!
+ * Release all the memory allocated from an arena after a mark was taken.
+ */
+W_EXPORT void w_arena_reset (w_arena_t *arena, w_arena_mark_t mark)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Release all the memory allocated from an arena. One chunk is kept
+ * around to be reused by later allocations.
+ */
+static inline void w_arena_clear (w_arena_t *arena)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline void
+w_arena_clear (w_arena_t *arena)
+{
+    w_arena_reset (arena, (w_arena_mark_t) { NULL, NULL });
+}
+
+/*!
+ * Create a new object of a given type in an arena.
+ */
+#define w_arena_obj_new(_a, _t) \
+    ((_t *) w__arena_obj_init (w_arena_alloc0 ((_a), sizeof (_t))))
+
+static inline void*
+w__arena_obj_init (w_obj_t *obj)
+{
+    obj->__refs = W__OBJ_ARENA | W__OBJ_REFS_INIT;
+    return obj;
+}
+
+/*\}*/
 
 
 /*------------------------------------------[ forward declarations ]------*/
@@ -392,6 +668,37 @@ W_EXPORT bool w_str_float (const char *str, float *val)
 W_EXPORT bool w_str_double (const char *str, double *val)
     W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
+/*!
+ * Scans an unsigned integer, optionally preceded by a plus sign, from
+ * the beginning of a span of memory which does not need to be
+ * null-terminated.
+ * \param str Input data.
+ * \param len Length of the input data.
+ * \param val Pointer to where to store the parsed value.
+ * \return Amount of bytes consumed, or zero if the input does not start
+ *         with a number, or the value does not fit in the result type.
+ */
+W_EXPORT size_t w_str_scan_ulong (const char *str, size_t len, unsigned long *val)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((3));
+
+/*!
+ * Scans a signed integer from the beginning of a span of memory. See
+ * \ref w_str_scan_ulong for details.
+ */
+W_EXPORT size_t w_str_scan_long (const char *str, size_t len, long *val)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((3));
+
+/*!
+ * Scans a double-precision float number (including \c nan, \c inf and
+ * \c infinity) from the beginning of a span of memory. See
+ * \ref w_str_scan_ulong for details.
+ */
+W_EXPORT size_t w_str_scan_double (const char *str, size_t len, double *val)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((3));
+
 /*!
  * Converts a string into a data size value in bytes.
  * The input string is expected to contain a number, optionally terminated
@@ -523,6 +830,8 @@ W_EXPORT w_task_t* w_task_prepare (w_task_func_t func, void *data, size_t stack_
 W_EXPORT w_task_t* w_task_current (void)
     W_FUNCTION_ATTR_NOT_NULL_RETURN;
 
+W_EXPORT bool w__task_running (void);
+
 W_EXPORT void w_task_set_name (w_task_t* task, const char *name)
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
@@ -551,6 +860,14 @@ W_EXPORT w_io_result_t w_task_yield_io_write (w_io_t *io, const void *buf, size_
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
+W_EXPORT w_io_result_t w_task_yield_io_writev (w_io_t *io, const struct iovec *iov, int iovcnt)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT w_io_result_t w_task_yield_io_readv (w_io_t *io, const struct iovec *iov, int iovcnt)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
 
 W_OBJ_DECL (w_task_listener_t);
 typedef void (*w_task_listener_func_t) (w_task_listener_t *listener,
@@ -612,11 +929,24 @@ w_task_system (void)
 
 /*----------------------------------------------------------[ lists ]-----*/
 
+/*!
+ * Storage layouts available for lists.
+ */
+enum w_list_backend
+{
+    W_LIST_LINKED = 0,  /*!< Doubly-linked list.                       */
+    W_LIST_ARRAY,       /*!< Growable ring buffer, with O(1) indexing. */
+};
+
+typedef enum w_list_backend w_list_backend_t;
+
 W_OBJ (w_list_t)
 {
-    w_obj_t parent;
-    size_t  size;
-    bool    refs;
+    w_obj_t          parent;
+    size_t           size;
+    bool             refs;
+    w_list_backend_t backend;
+    w_arena_t       *arena;
     /* actual data is stored in the private area of the list */
 };
 
@@ -646,6 +976,15 @@ W_EXPORT w_list_t* w_list_new (bool refs)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL_RETURN;
 
+W_EXPORT w_list_t* w_list_new_with_backend (bool refs, w_list_backend_t backend)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN;
+
+W_EXPORT w_list_t* w_list_new_in (w_arena_t *arena, bool refs)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
 W_EXPORT void w_list_clear (w_list_t *list)
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
@@ -771,6 +1110,100 @@ w_list_pop (w_list_t *list)
          _v = w_list_prev ((_l), _v))
 
 
+/*---------------------------------------------------------[ deques ]-----*/
+
+W_OBJ (w_deque_t)
+{
+    w_obj_t parent;
+    void  **items;
+    size_t  capacity;
+    size_t  start;
+    size_t  size;
+    bool    refs;
+};
+
+static inline size_t w_deque_size (const w_deque_t *deque)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline size_t
+w_deque_size (const w_deque_t *deque)
+{
+    w_assert (deque);
+    return deque->size;
+}
+
+static inline bool w_deque_is_empty (const w_deque_t *deque)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline bool
+w_deque_is_empty (const w_deque_t *deque)
+{
+    w_assert (deque);
+    return deque->size == 0;
+}
+
+static inline void* w_deque_at (const w_deque_t *deque, long index)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline void*
+w_deque_at (const w_deque_t *deque, long index)
+{
+    w_assert (deque);
+    size_t pos = (index < 0) ? deque->size + index : (size_t) index;
+    w_assert (pos < deque->size);
+    return deque->items[(deque->start + pos) & (deque->capacity - 1)];
+}
+
+W_EXPORT w_deque_t* w_deque_new (bool refs)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN;
+
+W_EXPORT void w_deque_clear (w_deque_t *deque)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void w_deque_reserve (w_deque_t *deque, size_t size)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void w_deque_push_head (w_deque_t *deque, void *item)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void w_deque_push_tail (w_deque_t *deque, void *item)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void* w_deque_pop_head (w_deque_t *deque)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void* w_deque_pop_tail (w_deque_t *deque)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void w_deque_del_at (w_deque_t *deque, long index)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline void* w_deque_head (const w_deque_t *deque)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline void*
+w_deque_head (const w_deque_t *deque)
+{
+    return w_deque_at (deque, 0);
+}
+
+static inline void* w_deque_tail (const w_deque_t *deque)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline void*
+w_deque_tail (const w_deque_t *deque)
+{
+    return w_deque_at (deque, -1);
+}
+
 
 /*---------------------------------------------------[ dictionaries ]-----*/
 
@@ -782,14 +1215,38 @@ w_list_pop (w_list_t *list)
 
 typedef struct w_dict_node w_dict_node_t;
 
+/*!
+ * Storage layouts available for dictionaries.
+ */
+enum w_dict_backend
+{
+    W_DICT_CHAINED = 0,      /*!< Buckets with chained nodes.               */
+    W_DICT_OPEN_ADDRESSING,  /*!< Power-of-two table with control bytes.    */
+    W_DICT_FROZEN,           /*!< Read-only, see \ref w_dict_freeze.        */
+};
+
+typedef enum w_dict_backend w_dict_backend_t;
+
 W_OBJ (w_dict_t)
 {
-    w_obj_t         parent;
-    w_dict_node_t **nodes;
-    w_dict_node_t  *first;
-    size_t          count;
-    size_t          size;
-    bool            refs;
+    w_obj_t               parent;
+    w_dict_node_t       **nodes;
+    w_dict_node_t        *first;
+    size_t                count;
+    size_t                size;
+    bool                  refs;
+    w_dict_backend_t      backend;
+    uint8_t              *ctrl;
+    size_t                growth_left;
+    w_dict_node_t       **old_nodes;
+    uint8_t              *old_ctrl;
+    size_t                old_size;
+    size_t                rehash_pos;
+    unsigned              growth_factor;
+    bool                  incremental;
+    struct w_dict_slab   *slab;
+    struct w_dict_frozen *frozen;
+    w_arena_t            *arena;
 };
 
 /*!
@@ -801,6 +1258,73 @@ W_OBJ (w_dict_t)
 W_EXPORT w_dict_t* w_dict_new (bool refs)
     W_FUNCTION_ATTR_NOT_NULL_RETURN;
 
+/*!
+ * Create a new dictionary using a particular storage layout. Both layouts
+ * support the same operations and iterate over items in the same order;
+ * \ref W_DICT_OPEN_ADDRESSING is usually faster for lookup-heavy loads.
+ * \param refs Same as for \ref w_dict_new.
+ * \param backend Storage layout used for the dictionary.
+ */
+W_EXPORT w_dict_t* w_dict_new_with_backend (bool refs, w_dict_backend_t backend)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN;
+
+/*!
+ * Create a new dictionary in an arena. The dictionary, its tables and its
+ * items are all allocated from the arena.
+ * \param arena Arena used for allocating memory.
+ * \param refs Same as for \ref w_dict_new.
+ */
+W_EXPORT w_dict_t* w_dict_new_in (w_arena_t *arena, bool refs)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Configure how a dictionary grows when it needs more space.
+ * \param factor Factor by which the table is enlarged on each resize. For
+ *        \ref W_DICT_OPEN_ADDRESSING it must be a power of two. Passing
+ *        zero keeps the current value.
+ * \param incremental When \c true, instead of moving all the items to the
+ *        new table at once, items are moved to it a few at a time on each
+ *        subsequent operation on the dictionary. This avoids latency spikes
+ *        when adding items to large dictionaries.
+ */
+W_EXPORT void w_dict_set_growth (w_dict_t *d, unsigned factor, bool incremental)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Make a dictionary allocate its items from large memory blocks owned by the
+ * dictionary, instead of doing one allocation per item. Memory of deleted
+ * items is reused for new items, and it is released all at once when the
+ * dictionary is cleared or destroyed. This can only be changed while the
+ * dictionary is empty.
+ */
+W_EXPORT void w_dict_set_slab (w_dict_t *d, bool enable)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Create a read-only copy of a dictionary. Frozen dictionaries use a
+ * minimal perfect hash stored in a single memory block, which makes
+ * lookups take constant time in the worst case, and they can be used
+ * with the same functions to get values and iterate over items, in the
+ * same order as the original dictionary. Trying to add or remove items
+ * from a frozen dictionary is a bug.
+ *
+ * The original dictionary is not modified. If it was created with
+ * reference counting enabled, the frozen copy takes references to the
+ * values.
+ */
+W_EXPORT w_dict_t* w_dict_freeze (const w_dict_t *d)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Get the number of steps pending to finish an incremental rehash. One step
+ * is done each time an item is looked up, added or removed.
+ */
+W_EXPORT size_t w_dict_rehash_pending (const w_dict_t *d)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
 /*!
  * Clears the contents of a dictionary.
  */
@@ -896,6 +1420,15 @@ W_EXPORT const char* w_dict_iterator_get_key (w_iterator_t i)
     W_FUNCTION_ATTR_NOT_NULL_RETURN
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
+/*!
+ * Get the length of the key of the item pointed to by an iterator. Keys
+ * added using \ref w_dict_setn may contain \c NUL characters, so this
+ * should be used instead of \c strlen() when that is the case.
+ */
+W_EXPORT size_t w_dict_iterator_get_keylen (w_iterator_t i)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
 #define w_dict_foreach(_i, _d)                \
     for (w_iterator_t _i = w_dict_first (_d); \
          _i != NULL;                          \
@@ -1036,7 +1569,9 @@ W_EXPORT unsigned w_opt_parse(const w_opt_t  *options,
 /*!
  * Uses long option information to parse simple config-like files.
  * \param opt   Array of options.
- * \param input Input file stream.
+ * \param input Input file stream. Streams backed by a file descriptor
+ *              are read in blocks, so if parsing fails some input past
+ *              the error may have been consumed.
  * \param msg   Pointer to a place where to store an error message,
  *              if needed. You need to call \ref w_free on it if
  *              it is non-NULL upon return.
@@ -1279,16 +1814,42 @@ w_parse_match (w_parse_t *p, int c)
 
 /*--------------------------------------------------[ data buffers ]------*/
 
+/*
+ * Buffers store contents shorter than this amount of bytes (including the
+ * terminating null character added by w_buf_str) inside the w_buf_t itself,
+ * without allocating memory. Defining it to zero disables the feature.
+ *
+ * This changes the layout of w_buf_t: it must have the same value when
+ * building the library and the programs which use it. Also, buffers with
+ * contents must not be copied by value, as "data" may point to the storage
+ * inside the original structure.
+ */
+#ifndef W_BUF_INLINE_SIZE
+#define W_BUF_INLINE_SIZE 32
+#endif /* !W_BUF_INLINE_SIZE */
+
 typedef struct w_buf w_buf_t;
 struct w_buf
 {
-    char  *data;
-    size_t size;
-    size_t alloc;
+    char      *data;
+    size_t     size;
+    size_t     alloc;
+    w_arena_t *arena;
+#if W_BUF_INLINE_SIZE > 0
+    char       inline_data[W_BUF_INLINE_SIZE];
+#endif /* W_BUF_INLINE_SIZE > 0 */
 };
 
 
-#define W_BUF { NULL, 0, 0 }
+#if W_BUF_INLINE_SIZE > 0
+# define W__BUF_INLINE_INIT , { 0 }
+#else
+# define W__BUF_INLINE_INIT
+#endif /* W_BUF_INLINE_SIZE > 0 */
+
+#define W_BUF { NULL, 0, 0, NULL W__BUF_INLINE_INIT }
+
+#define W_BUF_ARENA(_a) { NULL, 0, 0, (_a) W__BUF_INLINE_INIT }
 
 
 static inline size_t w_buf_size (const w_buf_t *buf)
@@ -1298,78 +1859,295 @@ static inline size_t w_buf_size (const w_buf_t *buf)
 static inline
 size_t w_buf_size (const w_buf_t *buf)
 {
-    w_assert (buf);
-    return buf->size;
+    w_assert (buf);
+    return buf->size;
+}
+
+
+static inline char* w_buf_data (w_buf_t *buf)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline char*
+w_buf_data (w_buf_t *buf)
+{
+    w_assert (buf);
+    return buf->data;
+}
+
+
+static inline const char* w_buf_const_data (const w_buf_t *buf)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline const char*
+w_buf_const_data (const w_buf_t *buf)
+{
+    w_assert (buf);
+    return buf->data;
+}
+
+
+static inline bool w_buf_is_empty (const w_buf_t *buf)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline bool
+w_buf_is_empty (const w_buf_t *buf)
+{
+    w_assert (buf);
+    return buf->size == 0;
+}
+
+W_EXPORT void w_buf_resize (w_buf_t *buf, size_t size)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void w_buf_reserve (w_buf_t *buf, size_t size)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void w_buf_shrink_to_fit (w_buf_t *buf)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void w_buf_set_str (w_buf_t *buf, const char *str)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT void w_buf_append_mem (w_buf_t *buf, const void *ptr, size_t size)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT void w_buf_append_char (w_buf_t *buf, int chr)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void w_buf_append_str (w_buf_t *buf, const char *str)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT void w_buf_append_buf (w_buf_t *buf, const w_buf_t *src)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT w_io_result_t w_buf_format (w_buf_t *buf, const char *fmt, ...)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT w_io_result_t w_buf_formatv (w_buf_t *buf, const char *fmt, va_list args)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT void w_buf_clear (w_buf_t *buf)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT char* w_buf_str (w_buf_t *buf)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT char* w_buf_cstr (w_buf_t *buf)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+
+/*---------------------------------------------------[ byte slices ]------*/
+
+/*!
+ * Immutable, reference-counted chunk of bytes. Slices of a \ref w_bytes_t
+ * share its memory instead of copying it, and keep it alive for as long
+ * as they are referenced.
+ */
+W_OBJ (w_bytes_t)
+{
+    w_obj_t     parent;
+    w_bytes_t  *owner;
+    const char *data;
+    size_t      size;
+};
+
+/*! Creates a new chunk of bytes holding a copy of some memory. */
+W_EXPORT w_bytes_t* w_bytes_new (const void *data, size_t size)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN;
+
+/*!
+ * Creates a new chunk of bytes taking over the contents of a buffer,
+ * which is left empty.
+ */
+W_EXPORT w_bytes_t* w_bytes_new_from_buf (w_buf_t *buf)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Creates a slice which references a range of a chunk of bytes without
+ * copying it.
+ */
+W_EXPORT w_bytes_t* w_bytes_slice (w_bytes_t *bytes, size_t offset, size_t size)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*! Obtains a pointer to the contents of a chunk of bytes. */
+static inline const char* w_bytes_data (const w_bytes_t *bytes)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline const char*
+w_bytes_data (const w_bytes_t *bytes)
+{
+    w_assert (bytes);
+    return bytes->data;
+}
+
+/*! Obtains the size of a chunk of bytes. */
+static inline size_t w_bytes_size (const w_bytes_t *bytes)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline size_t
+w_bytes_size (const w_bytes_t *bytes)
+{
+    w_assert (bytes);
+    return bytes->size;
+}
+
+/*!
+ * Obtains the object which owns the memory of a chunk of bytes. For slices
+ * this is the chunk of bytes they were created from, otherwise it is the
+ * chunk of bytes itself.
+ */
+static inline w_bytes_t* w_bytes_owner (w_bytes_t *bytes)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline w_bytes_t*
+w_bytes_owner (w_bytes_t *bytes)
+{
+    w_assert (bytes);
+    return bytes->owner ? bytes->owner : bytes;
 }
 
-
-static inline char* w_buf_data (w_buf_t *buf)
+/*! Gets an item from a dictionary, using a chunk of bytes as key. */
+static inline void* w_dict_getb (const w_dict_t *d, const w_bytes_t *key)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
-    W_FUNCTION_ATTR_NOT_NULL ((1));
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
-static inline char*
-w_buf_data (w_buf_t *buf)
+static inline void*
+w_dict_getb (const w_dict_t *d, const w_bytes_t *key)
 {
-    w_assert (buf);
-    return buf->data;
+    return w_dict_getn (d, w_bytes_data (key), w_bytes_size (key));
 }
 
+/*! Sets an item in a dictionary, using a chunk of bytes as key. */
+static inline void w_dict_setb (w_dict_t *d, const w_bytes_t *key, void *data)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
-static inline const char* w_buf_const_data (const w_buf_t *buf)
-    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
-    W_FUNCTION_ATTR_NOT_NULL ((1));
+static inline void
+w_dict_setb (w_dict_t *d, const w_bytes_t *key, void *data)
+{
+    w_dict_setn (d, w_bytes_data (key), w_bytes_size (key), data);
+}
 
-static inline const char*
-w_buf_const_data (const w_buf_t *buf)
+/*! Deletes an item from a dictionary, using a chunk of bytes as key. */
+static inline void w_dict_delb (w_dict_t *d, const w_bytes_t *key)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+static inline void
+w_dict_delb (w_dict_t *d, const w_bytes_t *key)
 {
-    w_assert (buf);
-    return buf->data;
+    w_dict_deln (d, w_bytes_data (key), w_bytes_size (key));
 }
 
 
-static inline bool w_buf_is_empty (const w_buf_t *buf)
-    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
-    W_FUNCTION_ATTR_NOT_NULL ((1));
+/*------------------------------------------[ scatter/gather buffers ]----*/
 
-static inline bool
-w_buf_is_empty (const w_buf_t *buf)
+/*!
+ * Chain of memory segments which can be written to a stream in one go
+ * using \ref w_io_write_iovbuf. Pieces of data can be copied into the
+ * chain (small pieces appended one after another are merged into a
+ * single segment), borrowed, or referenced using a \ref w_bytes_t.
+ */
+typedef struct w_iovbuf w_iovbuf_t;
+struct w_iovbuf
 {
-    w_assert (buf);
-    return buf->size == 0;
-}
+    struct iovec            *iov;
+    w_bytes_t              **refs;
+    unsigned                 count;
+    unsigned                 alloc;
+    size_t                   size;
+    struct w_iovbuf_chunk   *chunks;
+};
 
-W_EXPORT void w_buf_resize (w_buf_t *buf, size_t size)
+/*! Initializer for scatter/gather buffers. */
+#define W_IOVBUF { NULL, NULL, 0, 0, 0, NULL }
+
+/*! Appends a copy of a piece of memory to a scatter/gather buffer. */
+W_EXPORT void w_iovbuf_append_mem (w_iovbuf_t *iovbuf, const void *ptr, size_t size)
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
-W_EXPORT void w_buf_set_str (w_buf_t *buf, const char *str)
+/*!
+ * Appends a piece of memory to a scatter/gather buffer without copying it.
+ * The memory must remain valid until the buffer is cleared.
+ */
+W_EXPORT void w_iovbuf_append_borrowed (w_iovbuf_t *iovbuf, const void *ptr, size_t size)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Appends a chunk of bytes to a scatter/gather buffer without copying it.
+ * The buffer keeps a reference to the chunk of bytes until it is cleared.
+ */
+W_EXPORT void w_iovbuf_append_bytes (w_iovbuf_t *iovbuf, w_bytes_t *bytes)
     W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
-W_EXPORT void w_buf_append_mem (w_buf_t *buf, const void *ptr, size_t size)
+W_EXPORT w_io_result_t w_iovbuf_format (w_iovbuf_t *iovbuf, const char *fmt, ...)
     W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
-W_EXPORT void w_buf_append_char (w_buf_t *buf, int chr)
+W_EXPORT w_io_result_t w_iovbuf_formatv (w_iovbuf_t *iovbuf, const char *fmt, va_list args)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+/*! Clears a scatter/gather buffer, releasing all its segments. */
+W_EXPORT void w_iovbuf_clear (w_iovbuf_t *iovbuf)
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
-W_EXPORT void w_buf_append_str (w_buf_t *buf, const char *str)
+/*! Appends a copy of a string to a scatter/gather buffer. */
+static inline void w_iovbuf_append_str (w_iovbuf_t *iovbuf, const char *str)
     W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
-W_EXPORT void w_buf_append_buf (w_buf_t *buf, const w_buf_t *src)
-    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+static inline void
+w_iovbuf_append_str (w_iovbuf_t *iovbuf, const char *str)
+{
+    w_iovbuf_append_mem (iovbuf, str, strlen (str));
+}
 
-W_EXPORT w_io_result_t w_buf_format (w_buf_t *buf, const char *fmt, ...)
+/*! Appends a copy of the contents of a buffer to a scatter/gather buffer. */
+static inline void w_iovbuf_append_buf (w_iovbuf_t *iovbuf, const w_buf_t *buf)
     W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
-W_EXPORT w_io_result_t w_buf_formatv (w_buf_t *buf, const char *fmt, va_list args)
-    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+static inline void
+w_iovbuf_append_buf (w_iovbuf_t *iovbuf, const w_buf_t *buf)
+{
+    w_iovbuf_append_mem (iovbuf, buf->data, buf->size);
+}
 
-W_EXPORT void w_buf_clear (w_buf_t *buf)
+/*! Obtains the total amount of bytes in a scatter/gather buffer. */
+static inline size_t w_iovbuf_size (const w_iovbuf_t *iovbuf)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
-W_EXPORT char* w_buf_str (w_buf_t *buf)
+static inline size_t
+w_iovbuf_size (const w_iovbuf_t *iovbuf)
+{
+    w_assert (iovbuf);
+    return iovbuf->size;
+}
+
+/*! Obtains the number of segments in a scatter/gather buffer. */
+static inline unsigned w_iovbuf_count (const w_iovbuf_t *iovbuf)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
-    W_FUNCTION_ATTR_NOT_NULL_RETURN
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
+static inline unsigned
+w_iovbuf_count (const w_iovbuf_t *iovbuf)
+{
+    w_assert (iovbuf);
+    return iovbuf->count;
+}
+
 
 /*--------------------------------------------------[ input/output ]------*/
 
@@ -1487,6 +2265,12 @@ W_OBJ_DEF (w_io_t)
     w_io_result_t (*read ) (w_io_t *io, void       *buf, size_t size);
     w_io_result_t (*flush) (w_io_t *io);
     int           (*getfd) (w_io_t *io);
+
+    w_io_result_t (*writev) (w_io_t *io, const struct iovec *iov, int iovcnt);
+    w_io_result_t (*readv ) (w_io_t *io, const struct iovec *iov, int iovcnt);
+
+    w_io_result_t (*peek   ) (w_io_t *io, size_t count, const char **data);
+    void          (*consume) (w_io_t *io, size_t count);
 };
 
 
@@ -1501,6 +2285,41 @@ W_EXPORT w_io_result_t w_io_write (w_io_t *io, const void *buf, size_t size)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
+W_EXPORT w_io_result_t w_io_writev (w_io_t *io, const struct iovec *iov, int iovcnt)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT w_io_result_t w_io_readv (w_io_t *io, const struct iovec *iov, int iovcnt)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT w_io_result_t w_io_peek (w_io_t *io, size_t count, const char **data)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 3));
+
+W_EXPORT void w_io_consume (w_io_t *io, size_t count)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline w_io_result_t w_io_write_iovbuf (w_io_t *io, const w_iovbuf_t *iovbuf)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+static inline w_io_result_t
+w_io_write_iovbuf (w_io_t *io, const w_iovbuf_t *iovbuf)
+{
+    return w_io_writev (io, iovbuf->iov, (int) iovbuf->count);
+}
+
+static inline w_io_result_t w_io_write_bytes (w_io_t *io, const w_bytes_t *bytes)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+static inline w_io_result_t
+w_io_write_bytes (w_io_t *io, const w_bytes_t *bytes)
+{
+    return w_io_write (io, w_bytes_data (bytes), w_bytes_size (bytes));
+}
+
 W_EXPORT w_io_result_t w_io_read (w_io_t *io, void *buf, size_t size)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1));
@@ -1543,6 +2362,56 @@ W_EXPORT w_io_result_t w_io_formatv (w_io_t     *io,
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
+/*!
+ * Piece of a compiled format string: either a span of literal text, or
+ * a format directive.
+ */
+typedef struct {
+    const char *text;  /*!< Literal text, only for literal spans. */
+    unsigned    len;   /*!< Length of the literal text. */
+    char        code;  /*!< Directive character, or zero for literals. */
+} w_format_op_t;
+
+/*!
+ * Format string parsed into a list of operations. The list of operations
+ * always ends with an operation having no text and a zero code.
+ */
+W_OBJ (w_format_t)
+{
+    w_obj_t        parent;
+    const char    *source;
+    w_format_op_t *ops;
+};
+
+/*!
+ * Initializer for statically allocated formats. The format string is
+ * compiled the first time it is used.
+ */
+#define W_FORMAT_STATIC(_fmt) \
+    { .parent = W_OBJ_STATIC (NULL), .source = (_fmt), .ops = NULL }
+
+W_EXPORT w_format_t* w_format_compile (const char *fmt)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT w_io_result_t w_io_format_compiled (w_io_t     *io,
+                                             w_format_t *fmt,
+                                             ...)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT w_io_result_t w_io_format_compiledv (w_io_t     *io,
+                                              w_format_t *fmt,
+                                              va_list     args)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT w_io_result_t w_buf_format_compiled (w_buf_t    *buf,
+                                              w_format_t *fmt,
+                                              ...)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
 W_EXPORT w_io_result_t w_io_format_long (w_io_t *io, long value)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1));
@@ -1872,6 +2741,115 @@ W_EXPORT bool w_io_task_init (w_io_task_t *io, w_io_t *wrapped)
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
 
+W_OBJ (w_io_buffered_t)
+{
+    w_io_t  parent;
+    w_io_t *wrapped;
+    char   *rbuf;
+    size_t  ralloc;
+    size_t  rsize;
+    size_t  rpos;
+    size_t  rend;
+    char   *wbuf;
+    size_t  wsize;
+    size_t  wlen;
+};
+
+
+W_EXPORT w_io_t* w_io_buffered_open (w_io_t *wrapped, size_t read_size, size_t write_size)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT void w_io_buffered_init (w_io_buffered_t *io, w_io_t *wrapped,
+                                  size_t read_size, size_t write_size)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT void w_io_buffered_unread (w_io_buffered_t *io, const void *data, size_t size)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+
+/*! Maximum amount of delimiters supported by \ref w_io_lines_t. */
+#define W_IO_LINES_MAX_DELIMITERS 4
+
+/*!
+ * Splits the input of a stream in records separated by delimiter
+ * characters, e.g. lines of text.
+ */
+typedef struct w_io_lines w_io_lines_t;
+struct w_io_lines
+{
+    w_io_t     *input;
+    const char *base;    /*!< Data being split: own buffer or stream data. */
+    char       *buf;
+    size_t      alloc;
+    size_t      readsize;
+    size_t      pos;     /*!< Start of the next record.                    */
+    size_t      scanned; /*!< Data before this offset has no delimiters.   */
+    size_t      end;
+    char        delims[W_IO_LINES_MAX_DELIMITERS];
+    unsigned    ndelims;
+    bool        peeking;
+    bool        eof;
+};
+
+W_EXPORT void w_io_lines_init (w_io_lines_t *lines, w_io_t *input,
+                               const char *delimiters, size_t read_bytes)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2, 3));
+
+W_EXPORT void w_io_lines_clear (w_io_lines_t *lines)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT w_io_result_t w_io_lines_next (w_io_lines_t *lines, const char **data, size_t *size)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2, 3));
+
+W_EXPORT w_io_result_t w_io_lines_batch (w_io_lines_t *lines, struct iovec *slices, int *count)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2, 3));
+
+
+/*! Flags for \ref w_io_mmap_t streams. */
+enum w_io_mmap_flags
+{
+    /*! Read the whole file in advance, if supported by the system. */
+    W_IO_MMAP_POPULATE = 1 << 0,
+};
+
+W_OBJ (w_io_mmap_t)
+{
+    w_io_t  parent;
+    int     fd;
+    char   *data;   /*!< The mapping, or a read buffer if not mapped. */
+    size_t  size;
+    size_t  pos;
+    size_t  alloc;
+    bool    mapped;
+};
+
+W_EXPORT w_io_t* w_io_mmap_open (const char *path, unsigned flags)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+W_EXPORT w_io_t* w_io_mmap_open_fd (int fd, unsigned flags)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN;
+
+W_EXPORT void w_io_mmap_init_fd (w_io_mmap_t *io, int fd, unsigned flags)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline bool w_io_mmap_mapped (w_io_mmap_t *io)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline bool
+w_io_mmap_mapped (w_io_mmap_t *io)
+{
+    w_assert (io);
+    return io->mapped;
+}
+
+
 /*\}*/
 
 
@@ -1922,6 +2900,13 @@ enum w_variant_type
      * be always W_VARIANT_TYPE_STRING.
      */
     W_VARIANT_TYPE_BUFFER,
+
+    /*
+     * Also a convenience to instantiate W_VARIANT_TYPE_STRING
+     * values from a w_bytes_t. The string shares the memory of
+     * the chunk of bytes instead of copying it.
+     */
+    W_VARIANT_TYPE_BYTES,
 };
 
 typedef enum w_variant_type w_variant_type_t;
@@ -1947,6 +2932,7 @@ W_OBJ (w_variant_t)
     w_obj_t           parent;
     w_variant_type_t  type;
     w_variant_value_t value;
+    w_bytes_t        *shared;
 };
 
 /*!
@@ -2076,11 +3062,23 @@ W_EXPORT w_variant_t* w_variant_new (w_variant_type_t type, ...)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL_RETURN;
 
+/*!
+ * Create a new variant in an arena. This works like \ref w_variant_new,
+ * and string values are stored in memory from the arena, too.
+ */
+W_EXPORT w_variant_t* w_variant_new_in (w_arena_t *arena, w_variant_type_t type, ...)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
 /*! Clears a variant, setting it to invalid. */
 W_EXPORT w_variant_t* w_variant_clear (w_variant_t *variant)
     W_FUNCTION_ATTR_NOT_NULL_RETURN
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
+W_EXPORT void w__variant_unshare (w_variant_t *variant)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
 
 #define W__VARIANTS_SIMPLE(F)                  \
     F (number, NUMBER, long,   value.number  ) \
@@ -2182,7 +3180,9 @@ static inline char*
 w_variant_string (w_variant_t *v)
 {
     w_assert (v);
-    return w_buf_str (&v->value.stringbuf);
+    if (w_unlikely (v->shared != NULL))
+        w__variant_unshare (v);
+    return w_buf_cstr (&v->value.stringbuf);
 }
 
 /*! Obtains the string value stored in a variant, as a buffer. */
@@ -2213,6 +3213,27 @@ w_variant_set_buffer (w_variant_t *v, const w_buf_t *b)
     w_buf_append_buf (&v->value.stringbuf, b);
 }
 
+/*!
+ * Assigns the contents of a chunk of bytes as string value to a variant,
+ * mutating it if needed. The memory of the chunk of bytes is shared.
+ */
+static inline void w_variant_set_bytes (w_variant_t *v, w_bytes_t *b)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+static inline void
+w_variant_set_bytes (w_variant_t *v, w_bytes_t *b)
+{
+    w_assert (v);
+    w_assert (b);
+    w_variant_clear (v);
+    v->type = W_VARIANT_TYPE_STRING;
+    v->shared = w_obj_ref (w_bytes_owner (b));
+    v->value.stringbuf.data  = (char*) w_bytes_data (b);
+    v->value.stringbuf.size  = w_bytes_size (b);
+    v->value.stringbuf.alloc = 0;
+    v->value.stringbuf.arena = NULL;
+}
+
 /*! Assigns a string value to a variant, mutating it if needed. */
 static inline void w_variant_set_string (w_variant_t *v, const char *s)
     W_FUNCTION_ATTR_NOT_NULL ((1, 2));
@@ -2338,9 +3359,11 @@ W__TNS_PARSER_TYPES (W__TNS_DECLARE_PARSER)
     D w_io_result_t w_tnetstr_write_ ## N (w_io_t *io, T value) { \
         w_assert (io);                                            \
         w_buf_t buf = W_BUF;                                      \
-        W_IO_CHECK_BYTES (w_tnetstr_dump_ ## N (&buf, value),     \
-                          return,                                 \
-                          w_io_write (io, buf.data, buf.size)); }
+        w_io_result_t r = w_tnetstr_dump_ ## N (&buf, value);     \
+        if (!w_io_failed (r))                                     \
+            r = w_io_write (io, buf.data, buf.size);              \
+        w_buf_clear (&buf);                                       \
+        return r; }
 
 W__TNS_INLINE_WRITER_TYPES (W__TNS_DEFINE_INLINE_WRITER)
 
@@ -2357,6 +3380,14 @@ W_EXPORT w_variant_t* w_tnetstr_parse (const w_buf_t *buffer)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
+W_EXPORT w_variant_t* w_tnetstr_parse_in (w_arena_t *arena, const w_buf_t *buffer)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+W_EXPORT w_variant_t* w_tnetstr_parse_bytes (w_bytes_t *bytes)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
 W_EXPORT bool w_tnetstr_parse_null (const w_buf_t *buffer)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1));
@@ -2365,24 +3396,16 @@ W_EXPORT bool w_tnetstr_read_to_buffer (w_io_t *io, w_buf_t *buffer)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1, 2));
 
-static inline w_variant_t* w_tnetstr_read (w_io_t *io)
+/*!
+ * Reads a value from a stream. For streams which support \ref w_io_peek,
+ * like \ref w_io_mmap_t, the value is parsed directly from the data of
+ * the stream when the whole item is available.
+ */
+W_EXPORT w_variant_t* w_tnetstr_read (w_io_t *io)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
 
-static inline w_variant_t*
-w_tnetstr_read (w_io_t *io)
-{
-    w_buf_t buf = W_BUF;
-    w_variant_t *variant = NULL;
-    w_assert (io);
-    if (w_tnetstr_read_to_buffer (io, &buf)) goto E;
-    variant = w_tnetstr_parse (&buf);
-E:  w_buf_clear (&buf);
-    return variant;
-}
-
-
 #define W__TNS_DEFINE_INLINE_READER(D, N, T, WT)         \
     static inline bool                                   \
     w_tnetstr_read_ ## N (w_io_t *io, WT *value)         \
@@ -2403,6 +3426,85 @@ W__TNS_READ_TYPES (W__TNS_DEFINE_INLINE_READER)
 
 /*\}*/
 
+/*----------------------------------------------[ dictionary images ]-----*/
+
+/*!
+ * \defgroup wdictimg Memory-mapped dictionary images
+ * \addtogroup wdictimg
+ * \{
+ *
+ * Dictionary images are files containing a perfect hash table for the
+ * items of a dictionary (see \ref w_dict_freeze), with values encoded as
+ * tnetstrings. Images are mapped into memory as-is: opening an image takes
+ * the same time regardless of its size, and looking up a value does not
+ * copy its data. Images can only be used in machines with the same byte
+ * order as the one which created them.
+ */
+
+W_OBJ (w_dict_image_t)
+{
+    w_obj_t                          parent;
+    void                            *base;
+    size_t                           size;
+    size_t                           count;
+    const int32_t                   *disp;
+    const struct w_dict_image_slot  *slots;
+};
+
+/*!
+ * Writes an image of a dictionary. All the values in the dictionary must
+ * be variants which can be serialized as tnetstrings.
+ */
+W_EXPORT w_io_result_t w_dict_save_image (const w_dict_t *d, w_io_t *output)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+/*!
+ * Maps a dictionary image from a file into memory. On error, \c NULL is
+ * returned and \c errno is set; \c EINVAL indicates that the file is not
+ * a valid image, and \c ENOEXEC that it was created in a machine with a
+ * different byte order.
+ */
+W_EXPORT w_dict_image_t* w_dict_map_image (const char *path)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+/*!
+ * Looks up the value for a key in a dictionary image. The buffer is set
+ * to point to the tnetstring-encoded value inside the image: it must not
+ * be modified or cleared, and it is valid as long as the image is alive.
+ * \return Whether the key was not found.
+ */
+W_EXPORT bool w_dict_image_getn (const w_dict_image_t *image,
+                                 const char           *key,
+                                 size_t                keylen,
+                                 w_buf_t              *value)
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2, 4));
+
+/*!
+ * Looks up and parses the value for a key in a dictionary image.
+ * \return A new variant, or \c NULL if the key was not found.
+ */
+W_EXPORT w_variant_t* w_dict_image_get_variant (const w_dict_image_t *image,
+                                                const char           *key)
+    W_FUNCTION_ATTR_WARN_UNUSED_RESULT
+    W_FUNCTION_ATTR_NOT_NULL ((1, 2));
+
+/*!
+ * Obtains the number of items in a dictionary image.
+ */
+static inline size_t w_dict_image_size (const w_dict_image_t *image)
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
+static inline size_t
+w_dict_image_size (const w_dict_image_t *image)
+{
+    w_assert (image);
+    return image->count;
+}
+
+/*\}*/
+
 /*------------------------------------------------------[ metatypes ]-----*/
 
 
@@ -2603,6 +3705,16 @@ W_EXPORT w_cfg_t* w_cfg_load_file (const char *path, char **msg)
     W_FUNCTION_ATTR_WARN_UNUSED_RESULT
     W_FUNCTION_ATTR_NOT_NULL ((1));
 
+/*!
+ * Create a read-only copy of a configuration object. All the nodes are
+ * converted to frozen dictionaries (see \ref w_dict_freeze), which can be
+ * used with \ref w_cfg_get and the rest of the functions which do not
+ * modify configuration objects.
+ */
+W_EXPORT w_cfg_t* w_cfg_freeze (const w_cfg_t *cf)
+    W_FUNCTION_ATTR_NOT_NULL_RETURN
+    W_FUNCTION_ATTR_NOT_NULL ((1));
+
 #define w_cfg_set_string(cf, key, val) \
 	w_cfg_set ((cf), W_CFG_STRING, key, val, W_CFG_END)
 
@@ -2728,7 +3840,7 @@ W_OBJ_DEF (w_event_loop_t)
     w_obj_t       parent;
     bool          running;
     w_list_t     *events;
-    w_list_t     *idle_events;
+    w_deque_t    *idle_events;
     w_timestamp_t now;
 };
 
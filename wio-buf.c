@@ -30,6 +30,7 @@
 
 #include "wheel.h"
 #include <string.h>
+#include <errno.h>
 
 
 static w_io_result_t
@@ -73,6 +74,85 @@ w_io_buf_read (w_io_t *iobase, void *buf, size_t len)
 }
 
 
+static w_io_result_t
+w_io_buf_writev (w_io_t *iobase, const struct iovec *iov, int iovcnt)
+{
+    w_io_buf_t *io = (w_io_buf_t*) iobase;
+    size_t n = 0;
+
+    for (int i = 0; i < iovcnt; i++)
+        n += iov[i].iov_len;
+
+    /* The buffer may be freed by resizing it to zero, and not be usable. */
+    if (n == 0)
+        return W_IO_RESULT (0);
+
+    /* Make room for all the segments at once. */
+    w_buf_resize (io->bufp, io->pos + n);
+
+    char *dest = w_buf_data (io->bufp) + io->pos;
+    for (int i = 0; i < iovcnt; i++) {
+        memcpy (dest, iov[i].iov_base, iov[i].iov_len);
+        dest += iov[i].iov_len;
+    }
+    io->pos += n;
+
+    return W_IO_RESULT (n);
+}
+
+
+static w_io_result_t
+w_io_buf_readv (w_io_t *iobase, const struct iovec *iov, int iovcnt)
+{
+    w_io_buf_t *io = (w_io_buf_t*) iobase;
+
+    if (io->pos >= w_buf_size (io->bufp))
+        return W_IO_RESULT_EOF;
+
+    size_t n = 0;
+    for (int i = 0; i < iovcnt && io->pos < w_buf_size (io->bufp); i++) {
+        size_t len = w_min (iov[i].iov_len, w_buf_size (io->bufp) - io->pos);
+        memcpy (iov[i].iov_base, w_buf_data (io->bufp) + io->pos, len);
+        io->pos += len;
+        n += len;
+    }
+
+    return W_IO_RESULT (n);
+}
+
+
+static w_io_result_t
+w_io_buf_peek (w_io_t *iobase, size_t count, const char **data)
+{
+    w_io_buf_t *io = (w_io_buf_t*) iobase;
+    (void) count;
+
+    /* A pushed back character can be seen if it was the last one read. */
+    if (w_unlikely (io->parent.backch != W_IO_EOF)) {
+        if (!io->pos || io->pos > w_buf_size (io->bufp) ||
+            w_buf_const_data (io->bufp)[io->pos - 1] != (char) io->parent.backch)
+            return W_IO_RESULT_ERROR (ENOTSUP);
+        io->parent.backch = W_IO_EOF;
+        io->pos--;
+    }
+
+    if (io->pos >= w_buf_size (io->bufp))
+        return W_IO_RESULT_EOF;
+
+    *data = w_buf_const_data (io->bufp) + io->pos;
+    return W_IO_RESULT (w_buf_size (io->bufp) - io->pos);
+}
+
+
+static void
+w_io_buf_consume (w_io_t *iobase, size_t count)
+{
+    w_io_buf_t *io = (w_io_buf_t*) iobase;
+    w_assert (count <= w_buf_size (io->bufp) - io->pos);
+    io->pos += count;
+}
+
+
 /*~f void w_io_buf_init (w_io_buf_t *stream, w_buf_t *buffer, bool append)
  *
  * Initialize a `stream` object (possibly allocated in the stack) to be
@@ -104,6 +184,10 @@ w_io_buf_init (w_io_buf_t *io, w_buf_t *buf, bool append)
     io->parent.close = w_io_buf_close;
     io->parent.write = w_io_buf_write;
     io->parent.read  = w_io_buf_read;
+    io->parent.writev = w_io_buf_writev;
+    io->parent.readv  = w_io_buf_readv;
+    io->parent.peek   = w_io_buf_peek;
+    io->parent.consume = w_io_buf_consume;
     io->bufp = buf ? buf : &io->buf;
     io->pos = append ? w_buf_size (io->bufp) : 0;
 }
@@ -0,0 +1,317 @@
+/*
+ * wio-buffered.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+/**
+ * .. _wio-buffered:
+ *
+ * Buffered Input/Output
+ * =====================
+ *
+ * Buffered streams wrap another stream, reading data from it in big
+ * blocks and accumulating written data until enough of it is available.
+ * This greatly reduces the amount of calls to the wrapped stream (which
+ * usually means system calls) when data is consumed or produced in small
+ * pieces, e.g. character by character using :func:`w_io_getchar()`, or in
+ * the many small writes done by :func:`w_io_format()`.
+ *
+ * Data written to a buffered stream is sent to the wrapped stream when the
+ * write buffer is full, when :func:`w_io_flush()` is called, when reading
+ * needs to fetch more data from the wrapped stream, and when the buffered
+ * stream is closed. Note that :func:`w_io_flush()` does not flush the
+ * wrapped stream itself.
+ *
+ * Buffered data can be inspected without consuming it using
+ * :func:`w_io_peek()`, and any amount of data can be pushed back to be read
+ * again using :func:`w_io_buffered_unread()`.
+ *
+ * Types
+ * -----
+ */
+
+/*~t w_io_buffered_t
+ *
+ * Performs buffered input/output on another stream.
+ */
+
+/**
+ * Functions
+ * ---------
+ */
+
+#include "wheel.h"
+#include <errno.h>
+
+
+/* Default size of the read and write buffers. */
+#ifndef W_IO_BUFFERED_SIZE
+#define W_IO_BUFFERED_SIZE 8192
+#endif /* !W_IO_BUFFERED_SIZE */
+
+
+static w_io_result_t
+w_io_buffered_flush_output (w_io_buffered_t *io)
+{
+    size_t done = 0;
+
+    while (done < io->wlen) {
+        w_io_result_t r = w_io_write (io->wrapped, io->wbuf + done,
+                                      io->wlen - done);
+        if (w_io_failed (r)) {
+            /* Keep the data which could not be written. */
+            memmove (io->wbuf, io->wbuf + done, io->wlen - done);
+            io->wlen -= done;
+            return r;
+        }
+        done += w_io_result_bytes (r);
+    }
+
+    io->wlen = 0;
+    return W_IO_RESULT (done);
+}
+
+
+/*
+ * Makes room for at least "size" bytes of buffered input, moving the
+ * pending data to the beginning of the read buffer.
+ */
+static void
+w_io_buffered_reserve (w_io_buffered_t *io, size_t size)
+{
+    size_t avail = io->rend - io->rpos;
+
+    if (io->ralloc < size) {
+        size_t ralloc = w_max (io->rsize, io->ralloc * 2);
+        io->ralloc = w_max (ralloc, size);
+        if (io->rpos) {
+            char *rbuf = w_malloc (io->ralloc);
+            memcpy (rbuf, io->rbuf + io->rpos, avail);
+            w_free (io->rbuf);
+            io->rbuf = rbuf;
+        } else {
+            io->rbuf = w_realloc (io->rbuf, io->ralloc);
+        }
+    } else if (io->rpos) {
+        memmove (io->rbuf, io->rbuf + io->rpos, avail);
+    }
+
+    io->rpos = 0;
+    io->rend = avail;
+}
+
+
+static w_io_result_t
+w_io_buffered_fill (w_io_buffered_t *io)
+{
+    /* Send pending output first, a reply may depend on it. */
+    if (io->wlen)
+        W_IO_CHECK (w_io_buffered_flush_output (io));
+
+    return w_io_read (io->wrapped, io->rbuf + io->rend, io->ralloc - io->rend);
+}
+
+
+static w_io_result_t
+w_io_buffered_read (w_io_t *iobase, void *buf, size_t len)
+{
+    w_io_buffered_t *io = (w_io_buffered_t*) iobase;
+
+    if (io->rpos == io->rend) {
+        /* Big reads go straight to the destination. */
+        if (len >= io->rsize) {
+            if (io->wlen)
+                W_IO_CHECK (w_io_buffered_flush_output (io));
+            return w_io_read (io->wrapped, buf, len);
+        }
+
+        w_io_buffered_reserve (io, io->rsize);
+        w_io_result_t r = w_io_buffered_fill (io);
+        if (w_io_failed (r) || w_io_eof (r))
+            return r;
+        io->rend += w_io_result_bytes (r);
+    }
+
+    len = w_min (len, io->rend - io->rpos);
+    memcpy (buf, io->rbuf + io->rpos, len);
+    io->rpos += len;
+    return W_IO_RESULT (len);
+}
+
+
+static w_io_result_t
+w_io_buffered_write (w_io_t *iobase, const void *buf, size_t len)
+{
+    w_io_buffered_t *io = (w_io_buffered_t*) iobase;
+
+    if (io->wlen + len > io->wsize)
+        W_IO_CHECK (w_io_buffered_flush_output (io));
+
+    /* Big writes go straight to the wrapped stream. */
+    if (len >= io->wsize)
+        return w_io_write (io->wrapped, buf, len);
+
+    if (!io->wbuf)
+        io->wbuf = w_malloc (io->wsize);
+
+    memcpy (io->wbuf + io->wlen, buf, len);
+    io->wlen += len;
+    return W_IO_RESULT (len);
+}
+
+
+static w_io_result_t
+w_io_buffered_flush (w_io_t *iobase)
+{
+    w_io_buffered_t *io = (w_io_buffered_t*) iobase;
+    W_IO_CHECK (w_io_buffered_flush_output (io));
+    return W_IO_RESULT_SUCCESS;
+}
+
+
+static w_io_result_t
+w_io_buffered_close (w_io_t *iobase)
+{
+    w_io_buffered_t *io = (w_io_buffered_t*) iobase;
+
+    w_io_result_t r = w_io_buffered_flush_output (io);
+    w_free (io->rbuf);
+    w_free (io->wbuf);
+    io->ralloc = io->rpos = io->rend = io->wlen = 0;
+    w_obj_unref (io->wrapped);
+    io->wrapped = NULL;
+
+    return w_io_failed (r) ? r : W_IO_RESULT_SUCCESS;
+}
+
+
+static int
+w_io_buffered_getfd (w_io_t *iobase)
+{
+    return w_io_get_fd (((w_io_buffered_t*) iobase)->wrapped);
+}
+
+
+static w_io_result_t
+w_io_buffered_peek (w_io_t *iobase, size_t count, const char **data)
+{
+    w_io_buffered_t *io = (w_io_buffered_t*) iobase;
+
+    /* A character pushed back with w_io_putback() goes first. */
+    if (w_unlikely (io->parent.backch != W_IO_EOF)) {
+        char ch = io->parent.backch;
+        io->parent.backch = W_IO_EOF;
+        w_io_buffered_unread (io, &ch, 1);
+    }
+
+    if (io->rend - io->rpos < count) {
+        w_io_buffered_reserve (io, w_max (count, io->rsize));
+        while (io->rend < count) {
+            w_io_result_t r = w_io_buffered_fill (io);
+            if (w_io_failed (r) || w_io_eof (r)) {
+                if (io->rend)
+                    break;
+                return r;
+            }
+            io->rend += w_io_result_bytes (r);
+        }
+    }
+
+    *data = io->rbuf + io->rpos;
+    return W_IO_RESULT (io->rend - io->rpos);
+}
+
+
+static void
+w_io_buffered_consume (w_io_t *iobase, size_t count)
+{
+    w_io_buffered_t *io = (w_io_buffered_t*) iobase;
+    w_assert (count <= io->rend - io->rpos);
+    io->rpos += count;
+}
+
+
+/*~f void w_io_buffered_init (w_io_buffered_t *stream, w_io_t *wrapped, size_t read_size, size_t write_size)
+ *
+ * Initializes a buffered `stream` object (possibly allocated in the stack)
+ * which wraps another stream.
+ *
+ * The `read_size` is the amount of data requested from the `wrapped`
+ * stream each time the read buffer runs out of data, and `write_size` the
+ * amount of written data which is accumulated before writing it to the
+ * `wrapped` stream. Passing zero uses a default size.
+ *
+ * A reference to the `wrapped` stream is kept until the buffered `stream`
+ * is closed.
+ */
+void
+w_io_buffered_init (w_io_buffered_t *io, w_io_t *wrapped,
+                    size_t read_size, size_t write_size)
+{
+    w_assert (io);
+    w_assert (wrapped);
+
+    w_io_init ((w_io_t*) io);
+
+    io->parent.close = w_io_buffered_close;
+    io->parent.write = w_io_buffered_write;
+    io->parent.read  = w_io_buffered_read;
+    io->parent.flush = w_io_buffered_flush;
+    io->parent.getfd = w_io_buffered_getfd;
+    io->parent.peek  = w_io_buffered_peek;
+    io->parent.consume = w_io_buffered_consume;
+    io->wrapped = w_obj_ref (wrapped);
+    io->rbuf    = NULL;
+    io->ralloc  = io->rpos = io->rend = 0;
+    io->rsize   = read_size ? read_size : W_IO_BUFFERED_SIZE;
+    io->wbuf    = NULL;
+    io->wlen    = 0;
+    io->wsize   = write_size ? write_size : W_IO_BUFFERED_SIZE;
+}
+
+
+/*~f w_io_t* w_io_buffered_open (w_io_t *wrapped, size_t read_size, size_t write_size)
+ *
+ * Creates a buffered stream object which wraps another stream. See
+ * :func:`w_io_buffered_init()` for the meaning of the parameters.
+ */
+w_io_t*
+w_io_buffered_open (w_io_t *wrapped, size_t read_size, size_t write_size)
+{
+    w_assert (wrapped);
+
+    w_io_buffered_t *io = w_obj_new (w_io_buffered_t);
+    w_io_buffered_init (io, wrapped, read_size, write_size);
+    return (w_io_t*) io;
+}
+
+
+/*~f void w_io_buffered_unread (w_io_buffered_t *stream, const void *data, size_t size)
+ *
+ * Pushes `size` bytes of `data` back into a buffered `stream`, to be read
+ * again before any other input. Contrary to :func:`w_io_putback()`, any
+ * amount of data can be pushed back.
+ */
+void
+w_io_buffered_unread (w_io_buffered_t *io, const void *data, size_t size)
+{
+    w_assert (io);
+
+    if (w_unlikely (size == 0))
+        return;
+
+    w_assert (data);
+
+    if (io->rpos < size) {
+        size_t avail = io->rend - io->rpos;
+        w_io_buffered_reserve (io, avail + size);
+        memmove (io->rbuf + size, io->rbuf, avail);
+        io->rpos = size;
+        io->rend = size + avail;
+    }
+
+    io->rpos -= size;
+    memcpy (io->rbuf + io->rpos, data, size);
+}
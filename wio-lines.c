@@ -0,0 +1,365 @@
+/*
+ * wio-lines.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+/**
+ * .. _wio-lines:
+ *
+ * Splitting Input in Records
+ * ==========================
+ *
+ * A record splitter reads the input of a stream and splits it in records
+ * separated by delimiter characters — typically lines of text separated by
+ * ``\n``. Records are returned as views to memory owned by the splitter,
+ * without copying them, and one by one with :func:`w_io_lines_next()`, or
+ * as many as available at once using :func:`w_io_lines_batch()`.
+ *
+ * Data read from the input is placed in a buffer and a cursor advanced
+ * over it as records are returned; pending data is moved to the start of
+ * the buffer only when there is not enough room to read more input. For
+ * streams which support :func:`w_io_peek()` (e.g. :ref:`wio-buffered`, or
+ * the streams which operate on memory) the buffered data of the stream is
+ * split in place, and records are only copied when they span more than one
+ * chunk of stream data.
+ *
+ * Looking for the delimiters uses ``memchr()`` when there is only one of
+ * them, and otherwise checks 16 or 32 bytes at a time when the compiler
+ * targets SSE2 or AVX2, respectively.
+ *
+ * The following example counts the lines of a file:
+ *
+ * .. code-block:: c
+ *
+ *      unsigned long count_lines (w_io_t *input) {
+ *          w_io_lines_t lines;
+ *          w_io_lines_init (&lines, input, "\n", 0);
+ *
+ *          unsigned long count = 0;
+ *          struct iovec iov[128];
+ *          for (;;) {
+ *              int n = w_lengthof (iov);
+ *              w_io_result_t r = w_io_lines_batch (&lines, iov, &n);
+ *              if (w_io_failed (r) || w_io_eof (r))
+ *                  break;
+ *              count += n;
+ *          }
+ *
+ *          w_io_lines_clear (&lines);
+ *          return count;
+ *      }
+ *
+ * Types
+ * -----
+ */
+
+/*~t w_io_lines_t
+ *
+ * Splits the input of a stream in records.
+ */
+
+/**
+ * Functions
+ * ---------
+ */
+
+#include "wheel.h"
+#include <errno.h>
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif /* __SSE2__ */
+
+#ifdef __AVX2__
+# include <immintrin.h>
+#endif /* __AVX2__ */
+
+
+/* Default amount of data read from the input each time. */
+#ifndef W_IO_LINES_READ_BYTES
+#define W_IO_LINES_READ_BYTES 16384
+#endif /* !W_IO_LINES_READ_BYTES */
+
+
+static inline bool
+is_delimiter (const w_io_lines_t *lines, char ch)
+{
+    for (unsigned i = 0; i < lines->ndelims; i++)
+        if (ch == lines->delims[i])
+            return true;
+    return false;
+}
+
+
+static const char*
+find_delimiter (const w_io_lines_t *lines, const char *p, const char *end)
+{
+    if (p == end)
+        return NULL;
+
+    /* C libraries already provide a vectorized memchr(). */
+    if (lines->ndelims == 1)
+        return memchr (p, lines->delims[0], end - p);
+
+    /* Unused slots repeat the first delimiter, so all four are checked. */
+#ifdef __AVX2__
+    const __m256i d0 = _mm256_set1_epi8 (lines->delims[0]);
+    const __m256i d1 = _mm256_set1_epi8 (lines->delims[1]);
+    const __m256i d2 = _mm256_set1_epi8 (lines->delims[2]);
+    const __m256i d3 = _mm256_set1_epi8 (lines->delims[3]);
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256 ((const __m256i*) p);
+        __m256i m = _mm256_or_si256 (
+                _mm256_or_si256 (_mm256_cmpeq_epi8 (v, d0), _mm256_cmpeq_epi8 (v, d1)),
+                _mm256_or_si256 (_mm256_cmpeq_epi8 (v, d2), _mm256_cmpeq_epi8 (v, d3)));
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8 (m);
+        if (mask)
+            return p + __builtin_ctz (mask);
+    }
+#endif /* __AVX2__ */
+
+#ifdef __SSE2__
+    const __m128i s0 = _mm_set1_epi8 (lines->delims[0]);
+    const __m128i s1 = _mm_set1_epi8 (lines->delims[1]);
+    const __m128i s2 = _mm_set1_epi8 (lines->delims[2]);
+    const __m128i s3 = _mm_set1_epi8 (lines->delims[3]);
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128 ((const __m128i*) p);
+        __m128i m = _mm_or_si128 (
+                _mm_or_si128 (_mm_cmpeq_epi8 (v, s0), _mm_cmpeq_epi8 (v, s1)),
+                _mm_or_si128 (_mm_cmpeq_epi8 (v, s2), _mm_cmpeq_epi8 (v, s3)));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8 (m);
+        if (mask)
+            return p + __builtin_ctz (mask);
+    }
+#endif /* __SSE2__ */
+
+    for (; p < end; p++)
+        if (is_delimiter (lines, *p))
+            return p;
+
+    return NULL;
+}
+
+
+/*
+ * Takes the next record from the data available, without reading more
+ * input. The data after the last delimiter is only a record once the end
+ * of the input has been reached.
+ */
+static bool
+take_record (w_io_lines_t *lines, const char **data, size_t *size)
+{
+    const char *stop = find_delimiter (lines,
+                                       lines->base + lines->scanned,
+                                       lines->base + lines->end);
+    size_t next;
+
+    if (stop) {
+        next = stop - lines->base + 1;
+        *size = next - lines->pos - 1;
+    } else {
+        lines->scanned = lines->end;
+        if (!lines->eof || lines->pos == lines->end)
+            return false;
+        next = lines->end;
+        *size = next - lines->pos;
+    }
+
+    *data = lines->base + lines->pos;
+    lines->pos = lines->scanned = next;
+    return true;
+}
+
+
+static void
+reserve (w_io_lines_t *lines, size_t size)
+{
+    if (lines->alloc - lines->end >= size)
+        return;
+
+    /* Move pending data to the start, grow if still not enough room. */
+    if (lines->pos) {
+        lines->end -= lines->pos;
+        lines->scanned -= lines->pos;
+        memmove (lines->buf, lines->buf + lines->pos, lines->end);
+        lines->pos = 0;
+    }
+
+    if (lines->alloc - lines->end < size) {
+        lines->alloc = w_max (lines->alloc * 2, lines->end + size);
+        lines->buf = w_realloc (lines->buf, lines->alloc);
+        lines->base = lines->buf;
+    }
+}
+
+
+static w_io_result_t
+fill (w_io_lines_t *lines)
+{
+    if (lines->peeking) {
+        /*
+         * If the stream data ends in the middle of a record, copy the
+         * partial record (which is known not to contain delimiters), and
+         * continue reading into the own buffer.
+         */
+        const char *view = lines->base + lines->pos;
+        size_t pending = lines->end - lines->pos;
+        size_t consumed = lines->end;
+
+        lines->peeking = false;
+        lines->base = lines->buf;
+        lines->pos = lines->scanned = lines->end = 0;
+        if (pending) {
+            reserve (lines, pending + lines->readsize);
+            memcpy (lines->buf, view, pending);
+            lines->end = lines->scanned = pending;
+        }
+        w_io_consume (lines->input, consumed);
+    }
+
+    if (lines->pos == lines->end && lines->input->peek) {
+        const char *view;
+        w_io_result_t r = w_io_peek (lines->input, 1, &view);
+        if (w_io_result_error (r) != ENOTSUP) {
+            if (w_io_eof (r)) {
+                lines->eof = true;
+            } else if (!w_io_failed (r)) {
+                lines->peeking = true;
+                lines->base = view;
+                lines->pos = lines->scanned = 0;
+                lines->end = w_io_result_bytes (r);
+            }
+            return r;
+        }
+    }
+
+    reserve (lines, lines->readsize);
+    w_io_result_t r = w_io_read (lines->input, lines->buf + lines->end,
+                                 lines->alloc - lines->end);
+    if (w_io_eof (r))
+        lines->eof = true;
+    else if (!w_io_failed (r))
+        lines->end += w_io_result_bytes (r);
+    return r;
+}
+
+
+/*~f void w_io_lines_init (w_io_lines_t *lines, w_io_t *input, const char *delimiters, size_t read_bytes)
+ *
+ * Initializes a record splitter which reads from an `input` stream. Records
+ * are separated by any of the characters in the `delimiters` string, which
+ * can contain up to ``W_IO_LINES_MAX_DELIMITERS`` characters.
+ *
+ * The `read_bytes` is the minimum amount of data requested from the input
+ * each time it is read. Passing zero uses a default size.
+ *
+ * The splitter does not keep a reference to the `input` stream, which must
+ * not be used by other code until :func:`w_io_lines_clear()` is called.
+ */
+void
+w_io_lines_init (w_io_lines_t *lines, w_io_t *input,
+                 const char *delimiters, size_t read_bytes)
+{
+    w_assert (lines);
+    w_assert (input);
+    w_assert (delimiters);
+
+    size_t ndelims = strlen (delimiters);
+    if (ndelims == 0 || ndelims > W_IO_LINES_MAX_DELIMITERS)
+        W_BUG ("invalid amount of delimiters");
+
+    memset (lines, 0x00, sizeof (w_io_lines_t));
+    lines->input = input;
+    lines->readsize = read_bytes ? read_bytes : W_IO_LINES_READ_BYTES;
+    lines->ndelims = ndelims;
+    for (unsigned i = 0; i < W_IO_LINES_MAX_DELIMITERS; i++)
+        lines->delims[i] = delimiters[(i < ndelims) ? i : 0];
+}
+
+
+/*~f void w_io_lines_clear (w_io_lines_t *lines)
+ *
+ * Frees the resources used by a record splitter. Input which has been read
+ * by the splitter but not returned as records is discarded.
+ */
+void
+w_io_lines_clear (w_io_lines_t *lines)
+{
+    w_assert (lines);
+
+    if (lines->peeking)
+        w_io_consume (lines->input, lines->pos);
+
+    w_free (lines->buf);
+    lines->base = NULL;
+    lines->input = NULL;
+    lines->peeking = false;
+    lines->alloc = lines->pos = lines->scanned = lines->end = 0;
+}
+
+
+/*~f w_io_result_t w_io_lines_next (w_io_lines_t *lines, const char **data, size_t *size)
+ *
+ * Obtains the next record. On success, `data` points to the record and its
+ * `size` (not including the delimiter) is returned. The data is valid until
+ * the next call to a function of the splitter. Once there are no more
+ * records, the end of file marker is returned.
+ */
+w_io_result_t
+w_io_lines_next (w_io_lines_t *lines, const char **data, size_t *size)
+{
+    w_assert (lines);
+    w_assert (data);
+    w_assert (size);
+
+    while (!take_record (lines, data, size)) {
+        if (lines->eof)
+            return W_IO_RESULT_EOF;
+        w_io_result_t r = fill (lines);
+        if (w_io_failed (r))
+            return r;
+    }
+
+    return W_IO_RESULT (*size);
+}
+
+
+/*~f w_io_result_t w_io_lines_batch (w_io_lines_t *lines, struct iovec *slices, int *count)
+ *
+ * Obtains as many records as possible, up to the `count` of elements of the
+ * `slices` array, from the data read from the input. More input is read only
+ * when no complete record is available. On success, `count` is updated with
+ * the amount of records, and their total size is returned. The data is valid
+ * until the next call to a function of the splitter. Once there are no more
+ * records, the end of file marker is returned.
+ */
+w_io_result_t
+w_io_lines_batch (w_io_lines_t *lines, struct iovec *slices, int *count)
+{
+    w_assert (lines);
+    w_assert (slices);
+    w_assert (count);
+    w_assert (*count > 0);
+
+    const char *data;
+    size_t size;
+    w_io_result_t r = w_io_lines_next (lines, &data, &size);
+    if (w_io_failed (r) || w_io_eof (r)) {
+        *count = 0;
+        return r;
+    }
+
+    size_t total = 0;
+    int n = 0;
+    do {
+        slices[n].iov_base = (void*) data;
+        slices[n].iov_len = size;
+        total += size;
+    } while (++n < *count && take_record (lines, &data, &size));
+
+    *count = n;
+    return W_IO_RESULT (total);
+}
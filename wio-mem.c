@@ -75,6 +75,76 @@ w_io_mem_read (w_io_t *iobase, void *buf, size_t len)
 }
 
 
+static w_io_result_t
+w_io_mem_writev (w_io_t *iobase, const struct iovec *iov, int iovcnt)
+{
+    w_io_mem_t *io = (w_io_mem_t*) iobase;
+    size_t n = 0;
+
+    for (int i = 0; i < iovcnt; i++) {
+        size_t len = w_min (iov[i].iov_len, io->size - io->pos);
+        memcpy (io->data + io->pos, iov[i].iov_base, len);
+        io->pos += len;
+        n += len;
+        if (len < iov[i].iov_len)
+            break;
+    }
+
+    return (n || io->pos < io->size) ? W_IO_RESULT (n)
+                                     : W_IO_RESULT_ERROR (errno = ENOSPC);
+}
+
+
+static w_io_result_t
+w_io_mem_readv (w_io_t *iobase, const struct iovec *iov, int iovcnt)
+{
+    w_io_mem_t *io = (w_io_mem_t*) iobase;
+    size_t n = 0;
+
+    for (int i = 0; i < iovcnt; i++) {
+        size_t len = w_min (iov[i].iov_len, io->size - io->pos);
+        memcpy (iov[i].iov_base, io->data + io->pos, len);
+        io->pos += len;
+        n += len;
+        if (len < iov[i].iov_len)
+            break;
+    }
+
+    return (n || io->pos < io->size) ? W_IO_RESULT (n) : W_IO_RESULT_EOF;
+}
+
+
+static w_io_result_t
+w_io_mem_peek (w_io_t *iobase, size_t count, const char **data)
+{
+    w_io_mem_t *io = (w_io_mem_t*) iobase;
+    (void) count;
+
+    /* A pushed back character can be seen if it was the last one read. */
+    if (w_unlikely (io->parent.backch != W_IO_EOF)) {
+        if (!io->pos || (char) io->data[io->pos - 1] != (char) io->parent.backch)
+            return W_IO_RESULT_ERROR (ENOTSUP);
+        io->parent.backch = W_IO_EOF;
+        io->pos--;
+    }
+
+    if (io->pos >= io->size)
+        return W_IO_RESULT_EOF;
+
+    *data = (const char*) io->data + io->pos;
+    return W_IO_RESULT (io->size - io->pos);
+}
+
+
+static void
+w_io_mem_consume (w_io_t *iobase, size_t count)
+{
+    w_io_mem_t *io = (w_io_mem_t*) iobase;
+    w_assert (count <= io->size - io->pos);
+    io->pos += count;
+}
+
+
 /*~f void w_io_mem_init (w_io_mem_t *stream, uint8_t *address, size_t size)
  *
  * Initializes a `stream` object (possibly located in the stack) to be used
@@ -91,6 +161,10 @@ w_io_mem_init (w_io_mem_t *io, uint8_t *data, size_t size)
     io->parent.close = w_io_mem_close;
     io->parent.write = w_io_mem_write;
     io->parent.read  = w_io_mem_read;
+    io->parent.writev = w_io_mem_writev;
+    io->parent.readv  = w_io_mem_readv;
+    io->parent.peek   = w_io_mem_peek;
+    io->parent.consume = w_io_mem_consume;
     io->data         = data;
     io->size         = size;
     io->pos          = 0;
@@ -0,0 +1,317 @@
+/*
+ * wio-mmap.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+/**
+ * .. _wio-mmap:
+ *
+ * Input from Memory-Mapped Files
+ * ==============================
+ *
+ * Memory-mapped streams read the contents of a file by mapping it into
+ * memory. Reading copies data straight from the mapping, without needing a
+ * system call each time, and :func:`w_io_peek()` returns a view of all the
+ * remaining contents of the file. Functions which make use of peeking, like
+ * :func:`w_io_read_until()`, :func:`w_tnetstr_read()`, the :ref:`wio-lines`
+ * record splitter and the :ref:`wcfg` parser, operate directly on the mapped
+ * bytes without copying them to intermediate buffers.
+ *
+ * The kernel is advised that the mapping is accessed sequentially, and that
+ * its contents will be needed soon. Passing ``W_IO_MMAP_POPULATE`` when
+ * creating a stream asks the kernel to read the whole file in advance, on
+ * systems which support it.
+ *
+ * Files which cannot be mapped — pipes, sockets, terminals, and files which
+ * report a size of zero, like most of those under ``/proc`` — are read
+ * using ``read()``, buffering the data so peeking is still supported.
+ *
+ * Memory-mapped streams are read-only.
+ *
+ * Types
+ * -----
+ */
+
+/*~t w_io_mmap_t
+ *
+ * Performs input from a memory-mapped file.
+ */
+
+/**
+ * Functions
+ * ---------
+ */
+
+#include "wheel.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+
+/* Amount of data read each time, for files which cannot be mapped. */
+#ifndef W_IO_MMAP_READ_SIZE
+#define W_IO_MMAP_READ_SIZE 65536
+#endif /* !W_IO_MMAP_READ_SIZE */
+
+
+static w_io_result_t
+read_fd (int fd, void *buf, size_t len)
+{
+    ssize_t ret;
+
+    do {
+        ret = read (fd, buf, len);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret == -1)
+        return W_IO_RESULT_ERROR (errno);
+    if (ret == 0)
+        return W_IO_RESULT_EOF;
+
+    return W_IO_RESULT (ret);
+}
+
+
+/*
+ * Reads from the file until at least "count" bytes are available, for
+ * files which are not mapped. Pending data is moved to the beginning of
+ * the buffer only when there is not enough room after it.
+ */
+static w_io_result_t
+w_io_mmap_fill (w_io_mmap_t *io, size_t count)
+{
+    size_t avail = io->size - io->pos;
+    size_t room = w_max (count, (size_t) W_IO_MMAP_READ_SIZE);
+
+    if (io->pos && io->alloc - io->pos < room) {
+        memmove (io->data, io->data + io->pos, avail);
+        io->pos = 0;
+        io->size = avail;
+    }
+    if (io->alloc - io->pos < room) {
+        io->alloc = w_max (io->alloc * 2, io->pos + room);
+        io->data = w_realloc (io->data, io->alloc);
+    }
+
+    while (io->size - io->pos < count) {
+        w_io_result_t r = read_fd (io->fd, io->data + io->size,
+                                   io->alloc - io->size);
+        if (w_io_failed (r) || w_io_eof (r))
+            return (io->size > io->pos) ? W_IO_RESULT_SUCCESS : r;
+        io->size += w_io_result_bytes (r);
+    }
+
+    return W_IO_RESULT_SUCCESS;
+}
+
+
+static w_io_result_t
+w_io_mmap_close (w_io_t *iobase)
+{
+    w_io_mmap_t *io = (w_io_mmap_t*) iobase;
+
+    if (io->mapped) {
+        munmap (io->data, io->size);
+        io->data = NULL;
+    } else {
+        w_free (io->data);
+    }
+    io->mapped = false;
+    io->alloc = io->size = io->pos = 0;
+
+    if (io->fd >= 0) {
+        int fd = io->fd;
+        io->fd = -1;
+        if (close (fd) == -1)
+            return W_IO_RESULT_ERROR (errno);
+    }
+    return W_IO_RESULT_SUCCESS;
+}
+
+
+static w_io_result_t
+w_io_mmap_read (w_io_t *iobase, void *buf, size_t len)
+{
+    w_io_mmap_t *io = (w_io_mmap_t*) iobase;
+
+    if (io->pos == io->size) {
+        if (io->mapped)
+            return W_IO_RESULT_EOF;
+
+        /* Big reads go straight to the destination. */
+        if (len >= W_IO_MMAP_READ_SIZE)
+            return read_fd (io->fd, buf, len);
+
+        w_io_result_t r = w_io_mmap_fill (io, 1);
+        if (w_io_failed (r) || w_io_eof (r))
+            return r;
+    }
+
+    len = w_min (len, io->size - io->pos);
+    memcpy (buf, io->data + io->pos, len);
+    io->pos += len;
+    return W_IO_RESULT (len);
+}
+
+
+static int
+w_io_mmap_getfd (w_io_t *iobase)
+{
+    return ((w_io_mmap_t*) iobase)->fd;
+}
+
+
+static w_io_result_t
+w_io_mmap_peek (w_io_t *iobase, size_t count, const char **data)
+{
+    w_io_mmap_t *io = (w_io_mmap_t*) iobase;
+
+    /*
+     * A pushed back character can be seen if it was the last one read
+     * from the mapping; the read buffer can always take it.
+     */
+    if (w_unlikely (io->parent.backch != W_IO_EOF)) {
+        char ch = io->parent.backch;
+        if (io->mapped) {
+            if (!io->pos || io->data[io->pos - 1] != ch)
+                return W_IO_RESULT_ERROR (ENOTSUP);
+            io->pos--;
+        } else if (io->pos) {
+            io->data[--io->pos] = ch;
+        } else {
+            if (io->size == io->alloc)
+                io->data = w_realloc (io->data, ++io->alloc);
+            memmove (io->data + 1, io->data, io->size++);
+            io->data[0] = ch;
+        }
+        io->parent.backch = W_IO_EOF;
+    }
+
+    if (!count)
+        count = 1;
+
+    if (io->mapped) {
+        if (io->pos >= io->size)
+            return W_IO_RESULT_EOF;
+    } else if (io->size - io->pos < count) {
+        w_io_result_t r = w_io_mmap_fill (io, count);
+        if (w_io_failed (r) || w_io_eof (r))
+            return r;
+    }
+
+    *data = io->data + io->pos;
+    return W_IO_RESULT (io->size - io->pos);
+}
+
+
+static void
+w_io_mmap_consume (w_io_t *iobase, size_t count)
+{
+    w_io_mmap_t *io = (w_io_mmap_t*) iobase;
+    w_assert (count <= io->size - io->pos);
+    io->pos += count;
+}
+
+
+/*~f void w_io_mmap_init_fd (w_io_mmap_t *stream, int fd, unsigned flags)
+ *
+ * Initializes a `stream` object (possibly allocated in the stack) to read
+ * from a file descriptor. If the descriptor refers to a regular file, the
+ * file is mapped into memory, and reading starts at the current offset of
+ * the descriptor; otherwise, it is read using ``read()``. The `flags` can
+ * be ``W_IO_MMAP_POPULATE``, to read the file contents in advance.
+ *
+ * The file descriptor is closed when the `stream` is closed.
+ */
+void
+w_io_mmap_init_fd (w_io_mmap_t *io, int fd, unsigned flags)
+{
+    w_assert (io);
+
+    w_io_init ((w_io_t*) io);
+
+    io->parent.close = w_io_mmap_close;
+    io->parent.read  = w_io_mmap_read;
+    io->parent.getfd = w_io_mmap_getfd;
+    io->parent.peek  = w_io_mmap_peek;
+    io->parent.consume = w_io_mmap_consume;
+    io->fd     = fd;
+    io->data   = NULL;
+    io->alloc  = io->size = io->pos = 0;
+    io->mapped = false;
+
+    struct stat st;
+    if (fstat (fd, &st) < 0 || !S_ISREG (st.st_mode) ||
+        st.st_size <= 0 || (uintmax_t) st.st_size > SIZE_MAX)
+        return;
+
+    off_t offset = lseek (fd, 0, SEEK_CUR);
+    if (offset < 0 || offset > st.st_size)
+        return;
+
+    int mflags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (flags & W_IO_MMAP_POPULATE)
+        mflags |= MAP_POPULATE;
+#else
+    (void) flags;
+#endif /* MAP_POPULATE */
+
+    void *data = mmap (NULL, st.st_size, PROT_READ, mflags, fd, 0);
+    if (data == MAP_FAILED)
+        return;
+
+    /* Advice is only a hint, failures are harmless. */
+#ifdef MADV_SEQUENTIAL
+    madvise (data, st.st_size, MADV_SEQUENTIAL);
+#endif /* MADV_SEQUENTIAL */
+#ifdef MADV_WILLNEED
+    madvise (data, st.st_size, MADV_WILLNEED);
+#endif /* MADV_WILLNEED */
+
+    io->data   = data;
+    io->size   = st.st_size;
+    io->pos    = offset;
+    io->mapped = true;
+}
+
+
+/*~f w_io_t* w_io_mmap_open_fd (int fd, unsigned flags)
+ *
+ * Creates a stream object to read from a file descriptor. See
+ * :func:`w_io_mmap_init_fd()` for the meaning of the parameters.
+ */
+w_io_t*
+w_io_mmap_open_fd (int fd, unsigned flags)
+{
+    w_io_mmap_t *io = w_obj_new (w_io_mmap_t);
+    w_io_mmap_init_fd (io, fd, flags);
+    return (w_io_t*) io;
+}
+
+
+/*~f w_io_t* w_io_mmap_open (const char *path, unsigned flags)
+ *
+ * Creates a stream object to read the file at `path`. This is a convenience
+ * function that calls ``open()`` and then uses :func:`w_io_mmap_open_fd()`.
+ *
+ * If opening the file fails, ``NULL`` is returned.
+ */
+w_io_t*
+w_io_mmap_open (const char *path, unsigned flags)
+{
+    w_assert (path);
+
+    int fd;
+    return ((fd = open (path, O_RDONLY)) < 0) ? NULL : w_io_mmap_open_fd (fd, flags);
+}
+
+
+/*~f bool w_io_mmap_mapped (w_io_mmap_t *stream)
+ *
+ * Checks whether the file read by a `stream` is mapped into memory.
+ */
@@ -405,9 +405,10 @@ w_io_socket_serve_thread (w_io_socket_t *io,
     /*
      * The thread keeps a reference to the I/O object. The reference counter
      * is incremented here before the thread is spawned to avoid a race
-     * condition with the w_obj_unref() in the accept-serve loop.
+     * condition with the w_obj_unref() in the accept-serve loop. From now
+     * on both threads may update the counter, so it has to be atomic.
      */
-    st->io  = w_obj_ref (io);
+    st->io  = w_obj_ref (w_obj_mark_atomic (io));
     st->hnd = handler;
 
     /*
@@ -35,6 +35,14 @@
 #include <fcntl.h>
 #include <errno.h>
 
+/*
+ * Maximum number of segments passed to a single writev() call. POSIX
+ * guarantees that at least 16 are supported, Linux and the BSDs allow 1024.
+ */
+#ifndef W_IO_UNIX_IOV_MAX
+#define W_IO_UNIX_IOV_MAX 1024
+#endif /* !W_IO_UNIX_IOV_MAX */
+
 
 static w_io_result_t
 w_io_unix_close (w_io_t *iobase)
@@ -70,6 +78,60 @@ w_io_unix_write (w_io_t *io, const void *bufp, size_t len)
 }
 
 
+static w_io_result_t
+w_io_unix_writev (w_io_t *io, const struct iovec *iov, int iovcnt)
+{
+    int fd = ((w_io_unix_t*) io)->fd;
+    ssize_t ret, n = 0;
+
+    while (iovcnt > 0) {
+        do {
+            ret = writev (fd, iov, (iovcnt < W_IO_UNIX_IOV_MAX)
+                                   ? iovcnt : W_IO_UNIX_IOV_MAX);
+        } while (ret < 0 && errno == EINTR);
+
+        /* Report partial writes, e.g. for non-blocking descriptors. */
+        if (ret == -1)
+            return n ? W_IO_RESULT (n) : W_IO_RESULT_ERROR (errno);
+
+        n += ret;
+        while (iovcnt > 0 && (size_t) ret >= iov->iov_len) {
+            ret -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        /*
+         * The caller's array is not modified, so the rest of a partially
+         * written segment goes out on its own before continuing.
+         */
+        if (iovcnt > 0 && ret > 0) {
+            struct iovec head = {
+                .iov_base = (char*) iov->iov_base + ret,
+                .iov_len  = iov->iov_len - ret,
+            };
+            iov++;
+            iovcnt--;
+
+            while (head.iov_len > 0) {
+                do {
+                    ret = writev (fd, &head, 1);
+                } while (ret < 0 && errno == EINTR);
+
+                if (ret == -1)
+                    return W_IO_RESULT (n);
+
+                n += ret;
+                head.iov_base = (char*) head.iov_base + ret;
+                head.iov_len -= ret;
+            }
+        }
+    }
+
+    return W_IO_RESULT (n);
+}
+
+
 static w_io_result_t
 w_io_unix_read (w_io_t *io, void *buf, size_t len)
 {
@@ -88,6 +150,25 @@ w_io_unix_read (w_io_t *io, void *buf, size_t len)
 }
 
 
+static w_io_result_t
+w_io_unix_readv (w_io_t *io, const struct iovec *iov, int iovcnt)
+{
+    ssize_t ret;
+
+    do {
+        ret = readv (((w_io_unix_t*) io)->fd, iov,
+                     (iovcnt < W_IO_UNIX_IOV_MAX) ? iovcnt : W_IO_UNIX_IOV_MAX);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret == -1)
+        return W_IO_RESULT_ERROR (errno);
+    if (ret == 0)
+        return W_IO_RESULT_EOF;
+
+    return W_IO_RESULT (ret);
+}
+
+
 static w_io_result_t
 w_io_unix_flush (w_io_t *io)
 {
@@ -125,6 +206,9 @@ w_io_unix_open (const char *path, int mode, unsigned perm)
 }
 
 
+static w_obj_pool_t w_io_unix_pool = W_OBJ_POOL (w_io_unix_t, 64);
+
+
 /*~f w_io_t* w_io_unix_open_fd (int fd)
  *
  * Creates a stream object to be used with an Unix file descriptor.
@@ -132,9 +216,10 @@ w_io_unix_open (const char *path, int mode, unsigned perm)
 w_io_t*
 w_io_unix_open_fd (int fd)
 {
-    w_io_unix_t *io = w_obj_new (w_io_unix_t);
+    w_io_unix_t *io = w_obj_new_pooled (&w_io_unix_pool, w_io_unix_t);
     w_io_unix_init_fd (io, fd);
-    return (w_io_t*) io;
+    /* w_io_init() resets the reference counter, mark as pooled again. */
+    return w__obj_init_pooled (io);
 }
 
 
@@ -182,6 +267,8 @@ w_io_unix_init_fd (w_io_unix_t *io, int fd)
     io->parent.read  = w_io_unix_read;
     io->parent.flush = w_io_unix_flush;
     io->parent.getfd = w_io_unix_getfd;
+    io->parent.writev = w_io_unix_writev;
+    io->parent.readv  = w_io_unix_readv;
     io->fd = fd;
 }
 
@@ -196,6 +283,8 @@ static w_io_unix_t stdout_data =
         .read   = w_io_unix_read,
         .flush  = w_io_unix_flush,
         .getfd  = w_io_unix_getfd,
+        .writev = w_io_unix_writev,
+        .readv  = w_io_unix_readv,
     },
     .fd = STDOUT_FILENO,
 };
@@ -210,6 +299,8 @@ static w_io_unix_t stderr_data =
         .read   = w_io_unix_read,
         .flush  = w_io_unix_flush,
         .getfd  = w_io_unix_getfd,
+        .writev = w_io_unix_writev,
+        .readv  = w_io_unix_readv,
     },
     .fd = STDERR_FILENO,
 };
@@ -224,6 +315,8 @@ static w_io_unix_t stdin_data =
         .read   = w_io_unix_read,
         .flush  = w_io_unix_flush,
         .getfd  = w_io_unix_getfd,
+        .writev = w_io_unix_writev,
+        .readv  = w_io_unix_readv,
     },
     .fd = STDIN_FILENO,
 };
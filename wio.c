@@ -14,6 +14,7 @@
  * The following kinds of streams are provided:
  *
  * - :ref:`wio-buf`
+ * - :ref:`wio-buffered`
  * - :ref:`wio-mem`
  * - :ref:`wio-stdio`
  * - :ref:`wio-unix`
@@ -83,6 +84,16 @@
  *      and it can be zero, e.g. for the result of :func:`w_io_close()`.
  *
  *
+ * Compiled formats
+ * ~~~~~~~~~~~~~~~~
+ *
+ * Format strings which are used many times can be parsed once using
+ * :func:`w_format_compile()`, or declared with :macro:`W_FORMAT_STATIC`,
+ * and then used with :func:`w_io_format_compiled()` and
+ * :func:`w_buf_format_compiled()`. The output is the same as when using
+ * the format string directly.
+ *
+ *
  * Reusing
  * ~~~~~~~
  *
@@ -361,10 +372,12 @@ w_io_read (w_io_t *io, void *buf, size_t len)
     w_assert (buf);
 
     /* Handle the putback character... makes things a bit messier */
+    size_t backch = 0;
     if (w_unlikely (io->backch != W_IO_EOF)) {
         *((char*) buf) = io->backch;
         buf = (char*) buf + 1;
         io->backch = W_IO_EOF;
+        backch = 1;
 
         /* Check whether more characters are to be read */
         if (!--len)
@@ -376,6 +389,10 @@ w_io_read (w_io_t *io, void *buf, size_t len)
     } else {
         r = W_IO_RESULT_ERROR (errno = EBADF);
     }
+
+    /* The putback character counts as read, even if reading failed. */
+    if (w_unlikely (backch))
+        r = W_IO_RESULT (w_io_result_bytes (r) + backch);
     return r;
 }
 
@@ -406,6 +423,136 @@ w_io_write (w_io_t *io, const void *buf, size_t len)
 }
 
 
+/*~f w_io_result_t w_io_writev (w_io_t *stream, const struct iovec *segments, int count)
+ *
+ * Writes the data from a number of memory `segments` to an output `stream`,
+ * in order. This is equivalent to calling :func:`w_io_write()` for each
+ * segment, but streams which support vectored output (like
+ * :type:`w_io_unix_t` and :type:`w_io_socket_t`) write all the segments
+ * with a single system call.
+ *
+ * The total amount of bytes written is returned. If writing fails after
+ * some of the data has been written, the amount written so far is returned
+ * (this can happen with non-blocking streams); otherwise the error is
+ * returned.
+ */
+w_io_result_t
+w_io_writev (w_io_t *io, const struct iovec *iov, int iovcnt)
+{
+    w_assert (io);
+    w_assert (iovcnt >= 0);
+    w_io_result_t r = W_IO_RESULT (0);
+
+    if (w_unlikely (iovcnt == 0))
+        return r;
+
+    w_assert (iov);
+    if (io->writev)
+        return (*io->writev) (io, iov, iovcnt);
+
+    for (int i = 0; i < iovcnt; i++) {
+        w_io_result_t wr = w_io_write (io, iov[i].iov_base, iov[i].iov_len);
+        if (w_io_failed (wr))
+            return r.bytes ? r : wr;
+        r.bytes += w_io_result_bytes (wr);
+        if (w_io_result_bytes (wr) < iov[i].iov_len)
+            break;
+    }
+    return r;
+}
+
+
+/*~f w_io_result_t w_io_readv (w_io_t *stream, const struct iovec *segments, int count)
+ *
+ * Reads data from an input `stream`, placing it in a number of memory
+ * `segments`, in order. Streams which support vectored input (like
+ * :type:`w_io_unix_t` and :type:`w_io_socket_t`) fill all the segments
+ * with a single system call; for other streams this is equivalent to
+ * calling :func:`w_io_read()` for each segment, stopping after the first
+ * one which is not filled completely.
+ *
+ * As with :func:`w_io_read()`, the amount of bytes read may be smaller
+ * than the total size of the `segments`.
+ */
+w_io_result_t
+w_io_readv (w_io_t *io, const struct iovec *iov, int iovcnt)
+{
+    w_assert (io);
+    w_assert (iovcnt >= 0);
+    w_io_result_t r = W_IO_RESULT (0);
+
+    if (w_unlikely (iovcnt == 0))
+        return r;
+
+    w_assert (iov);
+
+    /* The putback character is handled by w_io_read() */
+    if (io->readv && w_likely (io->backch == W_IO_EOF))
+        return (*io->readv) (io, iov, iovcnt);
+
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0)
+            continue;
+
+        w_io_result_t rr = w_io_read (io, iov[i].iov_base, iov[i].iov_len);
+        if (w_io_failed (rr) || w_io_eof (rr))
+            return r.bytes ? r : rr;
+
+        r.bytes += w_io_result_bytes (rr);
+        if (w_io_result_bytes (rr) < iov[i].iov_len)
+            break;
+    }
+    return r;
+}
+
+
+/*~f w_io_result_t w_io_peek (w_io_t *stream, size_t count, const char **data)
+ *
+ * Obtains a view of the input of a `stream` without consuming it. At least
+ * `count` bytes are made available, reading more input if needed, unless
+ * the end of file is reached. On success, `data` is set to point to the
+ * input and the amount of bytes available there is returned; it may be
+ * bigger than `count`. Once the input has been processed, use
+ * :func:`w_io_consume()` to skip over it.
+ *
+ * The view is valid until the next operation on the `stream`. If no input
+ * is available, the end of file marker is returned. Streams which do not
+ * support peeking fail with ``ENOTSUP``; this may also happen for streams
+ * which cannot make a character pushed back with :func:`w_io_putback()`
+ * part of the view. In both cases reading from the `stream` still works.
+ *
+ * Buffered streams (:ref:`wio-buffered`), memory-mapped files
+ * (:ref:`wio-mmap`), and the streams which operate on memory
+ * (:type:`w_io_buf_t`, :type:`w_io_mem_t`) support peeking. For the
+ * latter two, all the remaining data is always available.
+ */
+w_io_result_t
+w_io_peek (w_io_t *io, size_t count, const char **data)
+{
+    w_assert (io);
+    w_assert (data);
+
+    if (!io->peek)
+        return W_IO_RESULT_ERROR (ENOTSUP);
+
+    return (*io->peek) (io, count, data);
+}
+
+
+/*~f void w_io_consume (w_io_t *stream, size_t count)
+ *
+ * Skips over `count` bytes of input of a `stream`, which must have been
+ * made available by :func:`w_io_peek()` beforehand.
+ */
+void
+w_io_consume (w_io_t *io, size_t count)
+{
+    w_assert (io);
+    w_assert (io->consume);
+    (*io->consume) (io, count);
+}
+
+
 /*~f int w_io_getchar (w_io_t *stream)
  *
  * Reads the next character from a input `stream`.
@@ -522,21 +669,57 @@ w_io_format (w_io_t *io, const char *fmt, ...)
 }
 
 
-/*~f w_io_result_t w_io_formatv (w_io_t *stream, const char *format, va_list arguments)
- *
- * Writes data with a given `format` to an output `stream`, consuming the
- * needed additional `arguments` from the supplied ``va_list``.
- * The amount of consumed arguments depends on the `format` string.
- *
- * See :ref:`formatted-output` for more information.
+/*
+ * Size of the scratch buffer where formatted output is assembled before
+ * writing it to streams backed by a file descriptor.
  */
-w_io_result_t
-w_io_formatv (w_io_t *io, const char *fmt, va_list args)
+#ifndef W_IO_FORMAT_SCRATCH_SIZE
+#define W_IO_FORMAT_SCRATCH_SIZE 512
+#endif /* !W_IO_FORMAT_SCRATCH_SIZE */
+
+
+struct format_scratch
 {
-    w_assert (io);
-    w_assert (fmt);
+    w_io_t  parent;
+    w_io_t *output;
+    size_t  len;
+    char    data[W_IO_FORMAT_SCRATCH_SIZE];
+};
 
-    int last_errno = errno;
+
+static w_io_result_t
+format_scratch_flush (struct format_scratch *s)
+{
+    if (!s->len)
+        return W_IO_RESULT (0);
+
+    w_io_result_t r = w_io_write (s->output, s->data, s->len);
+    s->len = 0;
+    return r;
+}
+
+
+static w_io_result_t
+format_scratch_write (w_io_t *io, const void *buf, size_t len)
+{
+    struct format_scratch *s = (struct format_scratch*) io;
+
+    if (s->len + len > sizeof (s->data)) {
+        W_IO_CHECK (format_scratch_flush (s));
+        /* Big pieces of output are written directly. */
+        if (len >= sizeof (s->data))
+            return w_io_write (s->output, buf, len);
+    }
+
+    memcpy (s->data + s->len, buf, len);
+    s->len += len;
+    return W_IO_RESULT (len);
+}
+
+
+static w_io_result_t
+format_directive (w_io_t *io, int code, int last_errno, va_list *args)
+{
     size_t len_aux;
     union {
         int           vint;
@@ -550,95 +733,327 @@ w_io_formatv (w_io_t *io, const char *fmt, va_list args)
         w_io_result_t viores;
     } v;
 
+    w_io_result_t r = W_IO_RESULT (0);
+    switch (code) {
+        case 'l':
+            v.vlong = va_arg (*args, long);
+            W_IO_CHAIN (r, w_io_format_long (io, v.vlong));
+            break;
+        case 'i':
+            v.vint = va_arg (*args, int);
+            W_IO_CHAIN (r, w_io_format_long (io, v.vint));
+            break;
+        case 'c':
+            v.vint = va_arg (*args, int);
+            W_IO_CHAIN (r, w_io_putchar (io, v.vint));
+            break;
+        case 'I':
+            v.vuint = va_arg (*args, unsigned int);
+            W_IO_CHAIN (r, w_io_format_ulong (io, v.vuint));
+            break;
+        case 'L':
+            v.vulong = va_arg (*args, unsigned long);
+            W_IO_CHAIN (r, w_io_format_ulong (io, v.vulong));
+            break;
+        case 'X':
+            v.vulong = va_arg (*args, unsigned long);
+            W_IO_CHAIN (r, w_io_format_ulong_hex (io, v.vulong));
+            break;
+        case 'O':
+            v.vulong = va_arg (*args, unsigned long);
+            W_IO_CHAIN (r, w_io_format_ulong_oct (io, v.vulong));
+            break;
+        case 'f':
+        case 'F':
+            v.vfpnum = va_arg (*args, double);
+            W_IO_CHAIN (r, w_io_format_double (io, v.vfpnum));
+            break;
+        case 'p':
+            v.vpointer = (intptr_t) va_arg (*args, void*);
+            W_IO_CHAIN (r, w_io_format_ulong_hex (io, v.vpointer));
+            break;
+        case 's':
+            v.vcharp = va_arg (*args, const char*);
+            W_IO_CHAIN (r, w_io_write (io, v.vcharp, strlen (v.vcharp)));
+            break;
+        case 'B':
+            v.vbufp = va_arg (*args, w_buf_t*);
+            W_IO_CHAIN (r, w_io_write (io,
+                                       w_buf_cstr (v.vbufp),
+                                       w_buf_size (v.vbufp)));
+            break;
+        case 'S':
+            len_aux  = va_arg (*args, size_t);
+            v.vcharp = va_arg (*args, const char*);
+            W_IO_CHAIN (r, w_io_write (io, v.vcharp, len_aux));
+            break;
+        case 'e':
+            W_IO_CHAIN (r, w_io_format_long (io, last_errno));
+            break;
+        case 'E':
+            v.vcharp = strerror (last_errno);
+            W_IO_CHAIN (r, w_io_write (io, v.vcharp, strlen (v.vcharp)));
+            break;
+        case 'R':
+            v.viores = va_arg (*args, w_io_result_t);
+            W_IO_CHAIN (r, w_io_write (io, "IO<", 3));
+            if (w_io_failed (v.viores)) {
+                v.vcharp = strerror (w_io_result_error (v.viores));
+                W_IO_CHAIN (r, w_io_write (io, v.vcharp, strlen (v.vcharp)));
+            } else if (w_io_eof (v.viores)) {
+                W_IO_CHAIN (r, w_io_write (io, "EOF", 3));
+            } else {
+                W_IO_CHAIN (r, w_io_format_ulong (io, w_io_result_bytes (v.viores)));
+            }
+            W_IO_CHAIN (r, w_io_putchar (io, '>'));
+            break;
+        default:
+            W_IO_CHAIN (r, w_io_putchar (io, code));
+    }
+
+    return r;
+}
+
+
+static w_io_result_t
+format_parse_run (w_io_t *io, int last_errno, const char *fmt, va_list *args)
+{
     w_io_result_t r = W_IO_RESULT (0);
     for (; *fmt; fmt++) {
         if (*fmt != '$') {
-            W_IO_CHAIN (r, w_io_putchar (io, *fmt));
+            /* Write runs of literal text at once. */
+            size_t len = strcspn (fmt, "$");
+            W_IO_CHAIN (r, w_io_write (io, fmt, len));
+            fmt += len - 1;
             continue;
         }
+        /* A lone dollar sign at the end is ignored. */
+        if (!*(++fmt))
+            break;
+        W_IO_CHAIN (r, format_directive (io, *fmt, last_errno, args));
+    }
+    return r;
+}
 
-        switch (*(++fmt)) {
-            case 'l':
-                v.vlong = va_arg (args, long);
-                W_IO_CHAIN (r, w_io_format_long (io, v.vlong));
-                break;
-            case 'i':
-                v.vint = va_arg (args, int);
-                W_IO_CHAIN (r, w_io_format_long (io, v.vint));
-                break;
-            case 'c':
-                v.vint = va_arg (args, int);
-                W_IO_CHAIN (r, w_io_putchar (io, v.vint));
-                break;
-            case 'I':
-                v.vuint = va_arg (args, unsigned int);
-                W_IO_CHAIN (r, w_io_format_ulong (io, v.vuint));
-                break;
-            case 'L':
-                v.vulong = va_arg (args, unsigned long);
-                W_IO_CHAIN (r, w_io_format_ulong (io, v.vulong));
-                break;
-            case 'X':
-                v.vulong = va_arg (args, unsigned long);
-                W_IO_CHAIN (r, w_io_format_ulong_hex (io, v.vulong));
-                break;
-            case 'O':
-                v.vulong = va_arg (args, unsigned long);
-                W_IO_CHAIN (r, w_io_format_ulong_oct (io, v.vulong));
-                break;
-            case 'f':
-            case 'F':
-                v.vfpnum = va_arg (args, double);
-                W_IO_CHAIN (r, w_io_format_double (io, v.vfpnum));
-                break;
-            case 'p':
-                v.vpointer = (intptr_t) va_arg (args, void*);
-                W_IO_CHAIN (r, w_io_format_ulong_hex (io, v.vpointer));
-                break;
-            case 's':
-                v.vcharp = va_arg (args, const char*);
-                W_IO_CHAIN (r, w_io_write (io, v.vcharp, strlen (v.vcharp)));
-                break;
-            case 'B':
-                v.vbufp = va_arg (args, w_buf_t*);
-                W_IO_CHAIN (r, w_io_write (io,
-                                           w_buf_str (v.vbufp),
-                                           w_buf_size (v.vbufp)));
-                break;
-            case 'S':
-                len_aux  = va_arg (args, size_t);
-                v.vcharp = va_arg (args, const char*);
-                W_IO_CHAIN (r, w_io_write (io, v.vcharp, len_aux));
-                break;
-            case 'e':
-                W_IO_CHAIN (r, w_io_format_long (io, last_errno));
-                break;
-            case 'E':
-                v.vcharp = strerror (last_errno);
-                W_IO_CHAIN (r, w_io_write (io, v.vcharp, strlen (v.vcharp)));
-                break;
-            case 'R':
-                v.viores = va_arg (args, w_io_result_t);
-                W_IO_CHAIN (r, w_io_write (io, "IO<", 3));
-                if (w_io_failed (v.viores)) {
-                    v.vcharp = strerror (w_io_result_error (v.viores));
-                    W_IO_CHAIN (r, w_io_write (io, v.vcharp, strlen (v.vcharp)));
-                } else if (w_io_eof (v.viores)) {
-                    W_IO_CHAIN (r, w_io_write (io, "EOF", 3));
-                } else {
-                    W_IO_CHAIN (r, w_io_format_ulong (io, w_io_result_bytes (v.viores)));
-                }
-                W_IO_CHAIN (r, w_io_putchar (io, '>'));
-                break;
-            default:
-                W_IO_CHAIN (r, w_io_putchar (io, *fmt));
+
+static w_io_result_t
+format_compiled_run (w_io_t *io, int last_errno, const w_format_op_t *op, va_list *args)
+{
+    w_io_result_t r = W_IO_RESULT (0);
+    for (; op->text || op->code; op++) {
+        if (op->code) {
+            W_IO_CHAIN (r, format_directive (io, op->code, last_errno, args));
+        } else {
+            W_IO_CHAIN (r, w_io_write (io, op->text, op->len));
         }
     }
+    return r;
+}
 
+
+/* Runs either a format string or a list of compiled operations. */
+static w_io_result_t
+format_run (w_io_t *io, int last_errno, const char *fmt,
+            const w_format_op_t *ops, va_list args)
+{
+    /* A copy can be passed around by pointer portably. */
+    va_list ap;
+    va_copy (ap, args);
+    errno = last_errno;
+    w_io_result_t r = fmt
+        ? format_parse_run (io, last_errno, fmt, &ap)
+        : format_compiled_run (io, last_errno, ops, &ap);
+    va_end (ap);
     return r;
 }
 
 
+/*
+ * Same as format_run(), through the scratch buffer. Kept out of line so
+ * that callers which skip the buffer do not pay for its stack space.
+ */
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif /* __GNUC__ */
+static w_io_result_t
+format_run_scratch (w_io_t *io, int last_errno, const char *fmt,
+                    const w_format_op_t *ops, va_list args)
+{
+    struct format_scratch scratch;
+    w_io_init (&scratch.parent);
+    scratch.parent.write = format_scratch_write;
+    scratch.output = io;
+    scratch.len = 0;
+
+    w_io_result_t r = format_run (&scratch.parent, last_errno, fmt, ops, args);
+    w_io_result_t fr = format_scratch_flush (&scratch);
+    errno = last_errno;
+    return w_io_failed (fr) ? fr : r;
+}
+
+
+static w_io_result_t
+format_output (w_io_t *io, const char *fmt, const w_format_op_t *ops, va_list args)
+{
+    int last_errno = errno;
+
+    /*
+     * Memory-backed streams gain nothing from an additional copy, and
+     * task stacks may be too small to hold the scratch buffer.
+     */
+    if (w_io_get_fd (io) >= 0 && !w__task_running ())
+        return format_run_scratch (io, last_errno, fmt, ops, args);
+
+    return format_run (io, last_errno, fmt, ops, args);
+}
+
+
+/*~f w_io_result_t w_io_formatv (w_io_t *stream, const char *format, va_list arguments)
+ *
+ * Writes data with a given `format` to an output `stream`, consuming the
+ * needed additional `arguments` from the supplied ``va_list``.
+ * The amount of consumed arguments depends on the `format` string.
+ *
+ * For streams backed by a file descriptor, the output is assembled in a
+ * small buffer and written at once, instead of doing one write for each
+ * piece of the output. This is not done from inside tasks, to keep the
+ * stack usage low.
+ *
+ * See :ref:`formatted-output` for more information.
+ */
+w_io_result_t
+w_io_formatv (w_io_t *io, const char *fmt, va_list args)
+{
+    w_assert (io);
+    w_assert (fmt);
+    return format_output (io, fmt, NULL, args);
+}
+
+
+static w_format_op_t*
+format_compile_ops (const char *fmt)
+{
+    /* Each directive may be followed by a literal span, plus the end. */
+    unsigned n = 2;
+    for (const char *p = fmt; *p; p++)
+        if (*p == '$') n += 2;
+
+    w_format_op_t *ops = w_alloc (w_format_op_t, n);
+    w_format_op_t *op = ops;
+
+    while (*fmt) {
+        if (*fmt != '$') {
+            size_t len = strcspn (fmt, "$");
+            *op++ = (w_format_op_t) { .text = fmt, .len = len };
+            fmt += len;
+        } else if (*(++fmt)) {
+            *op++ = (w_format_op_t) { .code = *fmt++ };
+        }
+    }
+
+    *op = (w_format_op_t) { .text = NULL, .code = '\0' };
+    return ops;
+}
+
+
+static const w_format_op_t*
+format_get_ops (w_format_t *f)
+{
+#ifdef W_CONF_PTHREAD
+    w_format_op_t *ops = __atomic_load_n (&f->ops, __ATOMIC_ACQUIRE);
+    if (w_likely (ops != NULL))
+        return ops;
+
+    /* Another thread may be compiling the same format: first one wins. */
+    w_format_op_t *expected = NULL;
+    ops = format_compile_ops (f->source);
+    if (!__atomic_compare_exchange_n (&f->ops, &expected, ops, false,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        w_free (ops);
+        ops = expected;
+    }
+    return ops;
+#else
+    if (w_unlikely (!f->ops))
+        f->ops = format_compile_ops (f->source);
+    return f->ops;
+#endif /* W_CONF_PTHREAD */
+}
+
+
+static void
+w_format_free (void *obj)
+{
+    w_free (((w_format_t*) obj)->ops);
+}
+
+
+/*~f w_format_t* w_format_compile (const char *format)
+ *
+ * Parses a `format` string once, producing an object which can be used
+ * with :func:`w_io_format_compiled()` and :func:`w_buf_format_compiled()`
+ * any number of times without parsing the format string again. The
+ * format string is copied.
+ *
+ * Formats known at compile time can be declared as static variables
+ * using the :macro:`W_FORMAT_STATIC` initializer instead, in which case
+ * they are compiled the first time they are used:
+ *
+ * .. code-block:: c
+ *
+ *      static w_format_t request_format =
+ *          W_FORMAT_STATIC ("request $L from $s took $i ms\n");
+ *
+ *      W_IO_NORESULT (w_io_format_compiled (log_io, &request_format,
+ *                                           id, host, elapsed));
+ */
+w_format_t*
+w_format_compile (const char *fmt)
+{
+    w_assert (fmt);
+
+    size_t len = strlen (fmt) + 1;
+    w_format_t *f = w_obj_new_with_priv_sized (w_format_t, len);
+    f->source = memcpy (w_obj_priv (f, w_format_t), fmt, len);
+    f->ops = format_compile_ops (f->source);
+    return w_obj_dtor (f, w_format_free);
+}
+
+
+/*~f w_io_result_t w_io_format_compiled (w_io_t *stream, w_format_t *format, ...)
+ *
+ * Writes data with a compiled `format` to an output `stream`. This
+ * behaves exactly like :func:`w_io_format()`, but skips parsing the
+ * format string.
+ */
+w_io_result_t
+w_io_format_compiled (w_io_t *io, w_format_t *fmt, ...)
+{
+    w_assert (io);
+    w_assert (fmt);
+
+    va_list args;
+    va_start (args, fmt);
+    w_io_result_t r = w_io_format_compiledv (io, fmt, args);
+    va_end (args);
+    return r;
+}
+
+
+/*~f w_io_result_t w_io_format_compiledv (w_io_t *stream, w_format_t *format, va_list arguments)
+ *
+ * Writes data with a compiled `format` to an output `stream`, consuming
+ * the needed additional `arguments` from the supplied ``va_list``.
+ */
+w_io_result_t
+w_io_format_compiledv (w_io_t *io, w_format_t *fmt, va_list args)
+{
+    w_assert (io);
+    w_assert (fmt);
+    return format_output (io, NULL, format_get_ops (fmt), args);
+}
+
+
 /*~f w_io_result_t w_print (format, ...)
  *
  * Writes data in the given `format` to the standard output stream
@@ -732,6 +1147,9 @@ w_io_fscanv (w_io_t *io, const char *fmt, va_list args)
  * Passing zero for the `read_bytes` size will make the function use a default
  * chunk size — usually the size of a memory page.
  *
+ * Each record is copied into the `buffer`. To split big amounts of input in
+ * records, :ref:`wio-lines` avoids copying the data and needs fewer calls.
+ *
  * This function is intended to read records of data of variable size which
  * are separated using a certain character as a delimiter. For example,
  * usually `fortune <https://en.wikipedia.org/wiki/Fortune_%28Unix%29>`__
@@ -775,10 +1193,16 @@ w_io_read_until (w_io_t  *io,
     if (!readbytes)
         readbytes = W_IO_READ_UNTIL_BYTES;
 
+    /* Data in the overflow buffer before this offset has been searched. */
+    size_t scanned = 0;
+
     for (;;) {
-        char *pos = memchr (w_buf_data (overflow),
+        char *pos = (w_buf_size (overflow) > scanned)
+                  ? memchr (w_buf_data (overflow) + scanned,
                             stopchar,
-                            w_buf_size (overflow));
+                            w_buf_size (overflow) - scanned)
+                  : NULL;
+        scanned = w_buf_size (overflow);
 
         if (pos != NULL) {
             /*
@@ -795,6 +1219,34 @@ w_io_read_until (w_io_t  *io,
             return W_IO_RESULT (w_buf_size (buffer));
         }
 
+        /*
+         * Search the data buffered by the stream in place, if possible:
+         * when the stop character is found, the data up to it is copied
+         * only once, instead of going through the overflow buffer.
+         */
+        if (io->peek) {
+            const char *data;
+            w_io_result_t r = w_io_peek (io, 1, &data);
+            if (w_io_result_error (r) != ENOTSUP) {
+                if (w_io_failed (r) || w_io_eof (r))
+                    return r;
+
+                size_t avail = w_io_result_bytes (r);
+                const char *stop = memchr (data, stopchar, avail);
+                if (stop) {
+                    w_buf_append_buf (buffer, overflow);
+                    overflow->size = 0;
+                    w_buf_append_mem (buffer, data, stop - data);
+                    w_io_consume (io, stop - data + 1);
+                    return W_IO_RESULT (w_buf_size (buffer));
+                }
+
+                w_buf_append_mem (overflow, data, avail);
+                w_io_consume (io, avail);
+                continue;
+            }
+        }
+
         if (overflow->alloc < (w_buf_size (overflow) + readbytes))
         {
             /*
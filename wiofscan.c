@@ -12,6 +12,20 @@
 #include <math.h>
 
 
+/*
+ * Streams which support peeking allow scanning numbers directly from the
+ * buffered input. A number is only accepted when it does not extend up to
+ * the end of the available data, as more digits could follow; otherwise
+ * the character-by-character code path is used.
+ */
+static inline size_t
+peek_input (w_io_t *io, const char **data)
+{
+    w_io_result_t r = w_io_peek (io, 1, data);
+    return w_io_failed (r) ? 0 : w_io_result_bytes (r);
+}
+
+
 bool
 w_io_fscan_double (w_io_t *io, double *result)
 {
@@ -27,19 +41,46 @@ w_io_fscan_double (w_io_t *io, double *result)
     bool got_exp = false;
     bool got_dot = false;
     bool got_num = false;
+    bool negative = false;
     w_buf_t buf = W_BUF;
     int c;
 
     w_assert (io);
 
-    switch ((c = w_io_getchar (io))) {
+    const char *data;
+    size_t avail = peek_input (io, &data);
+    if (avail) {
+        double value;
+        size_t n = w_str_scan_double (data, avail, &value);
+        /*
+         * An exponent marker without digits is consumed by the slow path,
+         * which also needs to see an "inf" followed by an "i": it will be
+         * read as "infinity", or fail.
+         */
+        if (n && n < avail && (data[n] | 0x20) != 'e' &&
+            !(isinf (value) && (data[n] | 0x20) == 'i')) {
+            w_io_consume (io, n);
+            if (result)
+                *result = value;
+            return false;
+        }
+    }
+
+    /* The sign marker may be followed by a number, a NaN, or an INF. */
+    if ((c = w_io_getchar (io)) == '-' || c == '+') {
+        negative = (c == '-');
+        w_buf_append_char (&buf, c);
+        c = w_io_getchar (io);
+    }
+
+    switch (c) {
         /* If we get an "N", the only option is reading a NaN.  */
         case 'n':
         case 'N':
             if ((c = w_io_getchar (io)) != 'a' && c != 'A') goto failure;
             if ((c = w_io_getchar (io)) != 'n' && c != 'N') goto failure;
             if (result)
-                *result = NAN;
+                *result = negative ? -NAN : NAN;
             goto success;
 
         /* If we get an "I", the only option is reading an INF/INFINITY. */
@@ -47,21 +88,19 @@ w_io_fscan_double (w_io_t *io, double *result)
         case 'I':
             if ((c = w_io_getchar (io)) != 'n' && c != 'N') goto failure;
             if ((c = w_io_getchar (io)) != 'f' && c != 'F') goto failure;
-            if ((c = w_io_getchar (io)) == 'i' && c == 'I') {
+            if ((c = w_io_getchar (io)) == 'i' || c == 'I') {
                 if ((c = w_io_getchar (io)) != 'n' && c != 'N') goto failure;
                 if ((c = w_io_getchar (io)) != 'i' && c != 'I') goto failure;
                 if ((c = w_io_getchar (io)) != 't' && c != 'T') goto failure;
                 if ((c = w_io_getchar (io)) != 'y' && c != 'Y') goto failure;
+            } else {
+                w_io_putback (io, c);
             }
             if (result)
-                *result = INFINITY;
+                *result = negative ? -INFINITY : INFINITY;
             goto success;
 
-        /* Sign marker is read, next has to be a number in XX.YY[eZZ] format. */
-        case '-':
-        case '+':
-            w_buf_append_char (&buf, c);
-            break;
+        /* Otherwise, a number in XX.YY[eZZ] format. */
         default:
             w_io_putback (io, c);
     }
@@ -102,7 +141,7 @@ w_io_fscan_double (w_io_t *io, double *result)
     }
 
     if (result)
-        *result = strtod (w_buf_str (&buf), NULL);
+        *result = strtod (w_buf_cstr (&buf), NULL);
 
 success:
     w_buf_clear (&buf);
@@ -124,6 +163,18 @@ w_io_fscan_long (w_io_t *io, long *result)
 
     w_assert (io);
 
+    const char *data;
+    size_t avail = peek_input (io, &data);
+    if (avail) {
+        long value;
+        size_t n = w_str_scan_long (data, avail, &value);
+        if (n && n < avail) {
+            w_io_consume (io, n);
+            *result = value;
+            return false;
+        }
+    }
+
     switch ((chr = w_io_getchar (io))) {
         case '-':
             signchange = true;
@@ -139,11 +190,11 @@ w_io_fscan_long (w_io_t *io, long *result)
     *result = 0;
 
     if (signchange) {
-        if (uval > LONG_MAX) {
+        if (uval > (unsigned long) LONG_MAX + 1) {
             *result = LONG_MIN;
             return true;
         }
-        *result = -uval;
+        *result = (uval > LONG_MAX) ? LONG_MIN : -(long) uval;
     }
     else {
         if (uval > LONG_MAX) {
@@ -162,7 +213,21 @@ w_io_fscan_ulong (w_io_t *io, unsigned long *result)
 {
     w_assert (io);
 
+    const char *data;
+    size_t avail = peek_input (io, &data);
+    if (avail) {
+        unsigned long value;
+        size_t n = w_str_scan_ulong (data, avail, &value);
+        if (n && n < avail) {
+            w_io_consume (io, n);
+            if (result)
+                *result = value;
+            return false;
+        }
+    }
+
     unsigned long temp = 0;
+    bool overflow = false;
     int chr;
 
     /* If the next character is not a digit, signal it as format error */
@@ -177,8 +242,11 @@ start_digit:
     }
 
     do {
-        temp *= 10;
-        temp += chr - '0';
+        unsigned digit = chr - '0';
+        if (temp > (ULONG_MAX - digit) / 10)
+            overflow = true;
+        else
+            temp = temp * 10 + digit;
         chr = w_io_getchar (io);
     } while (chr != W_IO_EOF && isdigit (chr));
 
@@ -186,14 +254,11 @@ start_digit:
         w_io_putback (io, chr);
     }
 
-    /*
-     * TODO Add ULONG_MAX overflow checking
-     */
     if (result) {
-        *result = temp;
+        *result = overflow ? ULONG_MAX : temp;
     }
 
-    return false;
+    return overflow;
 }
 
 
@@ -0,0 +1,309 @@
+/*
+ * wiovbuf.c
+ * Copyright (C) 2015 Adrian Perez <aperez@igalia.com>
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+/**
+ * .. _wiovbuf:
+ *
+ * Scatter/Gather Buffers
+ * ======================
+ *
+ * Scatter/gather buffers (:type:`w_iovbuf_t`) hold a chain of memory
+ * segments, which can be written to a stream using
+ * :func:`w_io_write_iovbuf()`. Streams which support vectored output, like
+ * :type:`w_io_unix_t` and :type:`w_io_socket_t`, write all the segments
+ * with a single ``writev()`` system call. This avoids assembling all the
+ * pieces of a message into a single, contiguous (and repeatedly
+ * reallocated) block of memory before writing it.
+ *
+ * Segments can be added in three different ways:
+ *
+ * - Copying the data with :func:`w_iovbuf_append_mem()` and its variants.
+ *   Small pieces of data are copied into chunks of memory owned by the
+ *   buffer, and consecutive copies are merged into a single segment.
+ * - Borrowing the data with :func:`w_iovbuf_append_borrowed()`. The memory
+ *   must remain valid until the buffer is cleared.
+ * - Referencing a chunk of bytes with :func:`w_iovbuf_append_bytes()`. The
+ *   buffer keeps a reference to the :type:`w_bytes_t` until it is cleared.
+ *
+ * Like :type:`w_buf_t`, scatter/gather buffers are usually allocated in the
+ * stack, initialized with :macro:`W_IOVBUF`, and their resources released
+ * using :func:`w_iovbuf_clear()`.
+ *
+ * Usage
+ * -----
+ *
+ * .. code-block:: c
+ *
+ *      w_iovbuf_t response = W_IOVBUF;
+ *
+ *      w_iovbuf_format (&response, "Content-Length: $L\r\n\r\n",
+ *                       w_bytes_size (body));
+ *      w_iovbuf_append_bytes (&response, body);
+ *
+ *      w_io_result_t r = w_io_write_iovbuf (socket, &response);
+ *      w_iovbuf_clear (&response);
+ */
+
+/**
+ * Types
+ * -----
+ */
+
+/*~t w_iovbuf_t
+ *
+ * Scatter/gather buffer type.
+ */
+
+/**
+ * Macros
+ * ------
+ */
+
+/*~M W_IOVBUF
+ *
+ * Initializer for scatter/gather buffers:
+ *
+ * .. code-block:: c
+ *
+ *      w_iovbuf_t iovbuf = W_IOVBUF;
+ */
+
+/**
+ * Functions
+ * ---------
+ */
+
+#include "wheel.h"
+
+
+/* Size of the chunks of memory where copied data is stored. */
+#ifndef W_IOVBUF_CHUNK_SIZE
+#define W_IOVBUF_CHUNK_SIZE 4096
+#endif /* !W_IOVBUF_CHUNK_SIZE */
+
+/* Initial amount of segments for which memory is allocated. */
+#ifndef W_IOVBUF_MIN_SEGMENTS
+#define W_IOVBUF_MIN_SEGMENTS 8
+#endif /* !W_IOVBUF_MIN_SEGMENTS */
+
+
+struct w_iovbuf_chunk
+{
+    struct w_iovbuf_chunk *next;
+    size_t                 size;
+    size_t                 used;
+    char                   data[];
+};
+
+
+static void
+_iovbuf_add (w_iovbuf_t *iovbuf, const void *ptr, size_t size, w_bytes_t *ref)
+{
+    if (iovbuf->count > 0) {
+        struct iovec *last = &iovbuf->iov[iovbuf->count - 1];
+        if ((const char*) last->iov_base + last->iov_len == ptr &&
+            iovbuf->refs[iovbuf->count - 1] == ref) {
+            /* Contiguous with the last segment: extend it. */
+            last->iov_len += size;
+            iovbuf->size += size;
+            return;
+        }
+    }
+
+    if (iovbuf->count == iovbuf->alloc) {
+        iovbuf->alloc = iovbuf->alloc ? iovbuf->alloc * 2 : W_IOVBUF_MIN_SEGMENTS;
+        iovbuf->iov = w_resize (iovbuf->iov, struct iovec, iovbuf->alloc);
+        iovbuf->refs = w_resize (iovbuf->refs, w_bytes_t*, iovbuf->alloc);
+    }
+
+    iovbuf->iov[iovbuf->count].iov_base = (void*) ptr;
+    iovbuf->iov[iovbuf->count].iov_len = size;
+    iovbuf->refs[iovbuf->count] = ref ? w_obj_ref (ref) : NULL;
+    iovbuf->count++;
+    iovbuf->size += size;
+}
+
+
+static struct w_iovbuf_chunk*
+_iovbuf_chunk_new (size_t size)
+{
+    struct w_iovbuf_chunk *chunk =
+        w_malloc (sizeof (struct w_iovbuf_chunk) + size);
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+
+/*~f void w_iovbuf_append_mem (w_iovbuf_t *iovbuf, const void *pointer, size_t size)
+ *
+ * Appends a copy of `size` bytes of memory starting at `pointer` to a
+ * scatter/gather buffer.
+ */
+void
+w_iovbuf_append_mem (w_iovbuf_t *iovbuf, const void *ptr, size_t size)
+{
+    w_assert (iovbuf);
+
+    if (w_unlikely (size == 0))
+        return;
+
+    w_assert (ptr);
+
+    struct w_iovbuf_chunk *chunk = iovbuf->chunks;
+    if (!chunk || chunk->size - chunk->used < size) {
+        if (size > W_IOVBUF_CHUNK_SIZE / 2) {
+            /*
+             * Big pieces get a chunk of their own, which is placed after
+             * the current one, so small pieces can still be merged into
+             * the space left in the current chunk.
+             */
+            struct w_iovbuf_chunk *big = _iovbuf_chunk_new (size);
+            if (chunk) {
+                big->next = chunk->next;
+                chunk->next = big;
+            } else {
+                big->next = NULL;
+                iovbuf->chunks = big;
+            }
+            chunk = big;
+        } else {
+            chunk = _iovbuf_chunk_new (W_IOVBUF_CHUNK_SIZE);
+            chunk->next = iovbuf->chunks;
+            iovbuf->chunks = chunk;
+        }
+    }
+
+    char *dest = chunk->data + chunk->used;
+    memcpy (dest, ptr, size);
+    chunk->used += size;
+    _iovbuf_add (iovbuf, dest, size, NULL);
+}
+
+
+/*~f void w_iovbuf_append_borrowed (w_iovbuf_t *iovbuf, const void *pointer, size_t size)
+ *
+ * Appends `size` bytes of memory starting at `pointer` to a scatter/gather
+ * buffer, without copying them. The memory must remain valid and unchanged
+ * until the buffer is cleared with :func:`w_iovbuf_clear()`.
+ */
+void
+w_iovbuf_append_borrowed (w_iovbuf_t *iovbuf, const void *ptr, size_t size)
+{
+    w_assert (iovbuf);
+
+    if (w_unlikely (size == 0))
+        return;
+
+    w_assert (ptr);
+    _iovbuf_add (iovbuf, ptr, size, NULL);
+}
+
+
+/*~f void w_iovbuf_append_bytes (w_iovbuf_t *iovbuf, w_bytes_t *bytes)
+ *
+ * Appends a chunk of `bytes` to a scatter/gather buffer, without copying
+ * its contents. A reference to the object which owns the memory is kept
+ * until the buffer is cleared with :func:`w_iovbuf_clear()`.
+ */
+void
+w_iovbuf_append_bytes (w_iovbuf_t *iovbuf, w_bytes_t *bytes)
+{
+    w_assert (iovbuf);
+    w_assert (bytes);
+
+    if (w_unlikely (w_bytes_size (bytes) == 0))
+        return;
+
+    _iovbuf_add (iovbuf, w_bytes_data (bytes), w_bytes_size (bytes),
+                 w_bytes_owner (bytes));
+}
+
+
+/*~f void w_iovbuf_clear (w_iovbuf_t *iovbuf)
+ *
+ * Clears a scatter/gather buffer, releasing the memory used for copied
+ * data and the references to chunks of bytes. After clearing, the buffer
+ * can be reused.
+ */
+void
+w_iovbuf_clear (w_iovbuf_t *iovbuf)
+{
+    w_assert (iovbuf);
+
+    for (unsigned i = 0; i < iovbuf->count; i++)
+        w_obj_unref (iovbuf->refs[i]);
+
+    while (iovbuf->chunks) {
+        struct w_iovbuf_chunk *chunk = iovbuf->chunks;
+        iovbuf->chunks = chunk->next;
+        w_free (chunk);
+    }
+
+    w_free (iovbuf->iov);
+    w_free (iovbuf->refs);
+    *iovbuf = (w_iovbuf_t) W_IOVBUF;
+}
+
+
+struct iovbuf_io
+{
+    w_io_t      parent;
+    w_iovbuf_t *iovbuf;
+};
+
+
+static w_io_result_t
+iovbuf_io_write (w_io_t *io, const void *buf, size_t size)
+{
+    w_iovbuf_append_mem (((struct iovbuf_io*) io)->iovbuf, buf, size);
+    return W_IO_RESULT (size);
+}
+
+
+/*~f w_io_result_t w_iovbuf_format (w_iovbuf_t *iovbuf, const char *format, ...)
+ *
+ * Appends text with a given `format` into a scatter/gather buffer,
+ * consuming additional arguments as needed by the `format`. The text is
+ * copied into the buffer.
+ *
+ * See :ref:`formatted-output` for the available formatting options.
+ */
+w_io_result_t
+w_iovbuf_format (w_iovbuf_t *iovbuf, const char *fmt, ...)
+{
+    w_assert (iovbuf);
+    w_assert (fmt);
+
+    va_list al;
+    va_start (al, fmt);
+    w_io_result_t r = w_iovbuf_formatv (iovbuf, fmt, al);
+    va_end (al);
+    return r;
+}
+
+
+/*~f w_io_result_t w_iovbuf_formatv (w_iovbuf_t *iovbuf, const char *format, va_list arguments)
+ *
+ * Appends text with a given `format` into a scatter/gather buffer,
+ * consuming additional `arguments` as needed by the `format`.
+ *
+ * See :ref:`formatted-output` for the available formatting options.
+ */
+w_io_result_t
+w_iovbuf_formatv (w_iovbuf_t *iovbuf, const char *fmt, va_list args)
+{
+    w_assert (iovbuf);
+    w_assert (fmt);
+
+    struct iovbuf_io io;
+    w_io_init ((w_io_t*) &io);
+    io.parent.write = iovbuf_io_write;
+    io.iovbuf = iovbuf;
+
+    return w_io_formatv ((w_io_t*) &io, fmt, args);
+}
@@ -11,12 +11,14 @@
  * List Container
  * ==============
  *
- * The implementation uses a doubly-linked list, meaning that most
- * operations are very efficient, and the list can be traversed both
- * forward and backward.
- *
- * The functions which use numeric indexes to refer to elements in
- * the list can be slow, and should be avoided if possible:
+ * By default the implementation uses a doubly-linked list, meaning that
+ * most operations are very efficient, and the list can be traversed both
+ * forward and backward. Lists created with :func:`w_list_new_with_backend()`
+ * can be stored in a growable array instead, which supports the same
+ * operations.
+ *
+ * For linked lists, the functions which use numeric indexes to refer to
+ * elements in the list can be slow, and should be avoided if possible:
  * :func:`w_list_at()`, :func:`w_list_insert_at()`,
  * and :func:`w_list_del_at()`. Negative numeric indexes can be
  * passed to functions, with the same meaning as in Python: ``-1``
@@ -108,6 +110,15 @@
 #include <stdarg.h>
 
 
+#ifndef W_LIST_DEFAULT_BACKEND
+#define W_LIST_DEFAULT_BACKEND W_LIST_LINKED
+#endif /* !W_LIST_DEFAULT_BACKEND */
+
+#ifndef W_LIST_ARRAY_MIN_SIZE
+#define W_LIST_ARRAY_MIN_SIZE 8
+#endif /* !W_LIST_ARRAY_MIN_SIZE */
+
+
 TAILQ_HEAD (w_list_head, w_list_entry);
 
 struct w_list_entry
@@ -116,6 +127,24 @@ struct w_list_entry
     TAILQ_ENTRY (w_list_entry) tailq;
 };
 
+/*
+ * Array-backed lists use a ring buffer with a power-of-two capacity. At
+ * least one slot is always left unused, so the position before the first
+ * element never aliases the last one (see w_list_array_pos).
+ */
+struct w_list_array
+{
+    void  **items;
+    size_t  capacity;
+    size_t  start;
+};
+
+union w_list_priv
+{
+    struct w_list_head  head;
+    struct w_list_array array;
+};
+
 
 #define _W_LIST_HE        \
     struct w_list_head *h; \
@@ -123,6 +152,151 @@ struct w_list_entry
     w_assert (list);         \
     h = w_obj_priv (list, w_list_t)
 
+#define W_LIST_ARRAY(_l) \
+    ((struct w_list_array*) w_obj_priv ((_l), w_list_t))
+
+
+static inline void**
+w_list_array_slot (const struct w_list_array *a, size_t pos)
+{
+    return a->items + ((a->start + pos) & (a->capacity - 1));
+}
+
+
+/* Position of an iterator, -1 means "before the first element". */
+static inline long
+w_list_array_pos (const struct w_list_array *a, w_iterator_t i)
+{
+    size_t pos = ((size_t) (i - a->items) - a->start) & (a->capacity - 1);
+    return (pos == a->capacity - 1) ? -1 : (long) pos;
+}
+
+
+static void
+w_list_array_reserve (w_list_t *list, struct w_list_array *a)
+{
+    if (w_likely (list->size + 1 < a->capacity))
+        return;
+
+    size_t capacity = a->capacity ? a->capacity * 2 : W_LIST_ARRAY_MIN_SIZE;
+    void **items = list->arena
+        ? w_arena_alloc (list->arena, capacity * sizeof (void*))
+        : w_alloc (void*, capacity);
+
+    for (size_t pos = 0; pos < list->size; pos++)
+        items[pos] = *w_list_array_slot (a, pos);
+
+    /* Memory from arenas is released along with the arena. */
+    if (!list->arena)
+        w_free (a->items);
+
+    a->items = items;
+    a->capacity = capacity;
+    a->start = 0;
+}
+
+
+static void
+w_list_array_insert (w_list_t *list, size_t pos, void *item)
+{
+    struct w_list_array *a = W_LIST_ARRAY (list);
+    w_assert (pos <= list->size);
+
+    w_list_array_reserve (list, a);
+
+    /* Move the elements on the shorter side of the insertion point. */
+    if (pos < list->size - pos) {
+        a->start = (a->start - 1) & (a->capacity - 1);
+        for (size_t k = 0; k < pos; k++)
+            *w_list_array_slot (a, k) = *w_list_array_slot (a, k + 1);
+    }
+    else {
+        for (size_t k = list->size; k > pos; k--)
+            *w_list_array_slot (a, k) = *w_list_array_slot (a, k - 1);
+    }
+
+    *w_list_array_slot (a, pos) = list->refs ? w_obj_ref (item) : item;
+    list->size++;
+}
+
+
+/*
+ * Removes the element at a position. When "front" is set, the preceding
+ * elements are always the ones moved, which keeps an iterator to the
+ * removed element valid for w_list_next().
+ */
+static void*
+w_list_array_remove (w_list_t *list, size_t pos, bool front)
+{
+    struct w_list_array *a = W_LIST_ARRAY (list);
+    w_assert (pos < list->size);
+
+    void *item = *w_list_array_slot (a, pos);
+
+    if (front || pos < list->size - pos - 1) {
+        for (size_t k = pos; k > 0; k--)
+            *w_list_array_slot (a, k) = *w_list_array_slot (a, k - 1);
+        a->start = (a->start + 1) & (a->capacity - 1);
+    }
+    else {
+        for (size_t k = pos + 1; k < list->size; k++)
+            *w_list_array_slot (a, k - 1) = *w_list_array_slot (a, k);
+    }
+
+    list->size--;
+    return item;
+}
+
+
+static inline struct w_list_entry*
+w_list_entry_new (w_list_t *list)
+{
+    return list->arena
+        ? w_arena_alloc (list->arena, sizeof (struct w_list_entry))
+        : w_new (struct w_list_entry);
+}
+
+
+static inline void
+w_list_entry_free (w_list_t *list, struct w_list_entry *e)
+{
+    /* Memory from arenas is released along with the arena. */
+    if (!list->arena)
+        w_free (e);
+}
+
+
+static void
+w_list_free (void *obj)
+{
+    w_list_t *list = obj;
+    w_list_clear (list);
+
+    if (list->backend == W_LIST_ARRAY && !list->arena)
+        w_free (W_LIST_ARRAY (list)->items);
+}
+
+
+static w_list_t*
+w_list_init (w_list_t *list, bool refs, w_list_backend_t backend)
+{
+    list->refs = refs;
+    list->size = 0;
+    list->backend = backend;
+
+    switch (backend) {
+        case W_LIST_LINKED:
+            TAILQ_INIT ((struct w_list_head*) w_obj_priv (list, w_list_t));
+            break;
+        case W_LIST_ARRAY:
+            *W_LIST_ARRAY (list) = (struct w_list_array) { NULL, 0, 0 };
+            break;
+        default:
+            W_BUG ("unknown list backend");
+    }
+    return w_obj_dtor (list, w_list_free);
+}
+
 
 /*~f w_list_t* w_list_new (bool reference_counted)
  *
@@ -131,13 +305,51 @@ struct w_list_entry
 w_list_t*
 w_list_new (bool refs)
 {
-    w_list_t *list = w_obj_new_with_priv_sized (w_list_t,
-                                                sizeof (struct w_list_head));
-    struct w_list_head *h = w_obj_priv (list, w_list_t);
-    list->refs = refs;
-    list->size = 0;
-    TAILQ_INIT (h);
-    return w_obj_dtor (list, (void (*)(void*)) w_list_clear);
+    return w_list_new_with_backend (refs, W_LIST_DEFAULT_BACKEND);
+}
+
+
+/*~f w_list_t* w_list_new_with_backend (bool reference_counted, w_list_backend_t backend)
+ *
+ * Creates a new list using a particular storage `backend`:
+ *
+ * - ``W_LIST_LINKED``: Doubly-linked list. Inserting and deleting elements
+ *   never moves other elements, so iterators stay valid.
+ * - ``W_LIST_ARRAY``: Growable ring buffer. Adding and removing elements at
+ *   both ends takes amortized *O(1)* time, :func:`w_list_at()` runs in
+ *   *O(1)* time, and iteration is much more cache-friendly. Inserting or
+ *   deleting elements in the middle moves the elements on the shorter side,
+ *   which invalidates iterators, with one exception: the element pointed
+ *   to by the iterator of a :func:`w_list_foreach()` loop can be deleted
+ *   with :func:`w_list_del()`.
+ *
+ * The default backend used by :func:`w_list_new()` can be chosen at build
+ * time defining ``W_LIST_DEFAULT_BACKEND``.
+ */
+w_list_t*
+w_list_new_with_backend (bool refs, w_list_backend_t backend)
+{
+    return w_list_init (w_obj_new_with_priv_sized (w_list_t,
+                                                   sizeof (union w_list_priv)),
+                        refs, backend);
+}
+
+
+/*~f w_list_t* w_list_new_in (w_arena_t *arena, bool reference_counted)
+ *
+ * Creates a new list in an `arena`. The list and its elements are
+ * allocated from the arena.
+ */
+w_list_t*
+w_list_new_in (w_arena_t *arena, bool refs)
+{
+    w_assert (arena);
+
+    w_list_t *list = w_arena_alloc0 (arena, sizeof (w_list_t) +
+                                            sizeof (union w_list_priv));
+    w__arena_obj_init ((w_obj_t*) list);
+    list->arena = arena;
+    return w_list_init (list, refs, W_LIST_DEFAULT_BACKEND);
 }
 
 
@@ -150,12 +362,22 @@ w_list_clear (w_list_t *list)
 {
     _W_LIST_HE;
 
+    if (list->backend == W_LIST_ARRAY) {
+        struct w_list_array *a = W_LIST_ARRAY (list);
+        if (list->refs)
+            for (size_t pos = 0; pos < list->size; pos++)
+                w_obj_unref (*w_list_array_slot (a, pos));
+        list->size = 0;
+        a->start = 0;
+        return;
+    }
+
     while (!TAILQ_EMPTY (h)) {
         e = TAILQ_FIRST (h);
         TAILQ_REMOVE (h, e, tailq);
         if (list->refs)
             w_obj_unref (e->value);
-        w_free (e);
+        w_list_entry_free (list, e);
     }
     list->size = 0;
 }
@@ -170,7 +392,15 @@ w_list_push_tail (w_list_t *list, void *item)
 {
     _W_LIST_HE;
 
-    e = w_new (struct w_list_entry);
+    if (list->backend == W_LIST_ARRAY) {
+        struct w_list_array *a = W_LIST_ARRAY (list);
+        w_list_array_reserve (list, a);
+        *w_list_array_slot (a, list->size++) =
+            list->refs ? w_obj_ref (item) : item;
+        return;
+    }
+
+    e = w_list_entry_new (list);
     e->value = list->refs ? w_obj_ref (item) : item;
 
     TAILQ_INSERT_TAIL (h, e, tailq);
@@ -187,7 +417,12 @@ w_list_push_head (w_list_t *list, void *item)
 {
     _W_LIST_HE;
 
-    e = w_new (struct w_list_entry);
+    if (list->backend == W_LIST_ARRAY) {
+        w_list_array_insert (list, 0, item);
+        return;
+    }
+
+    e = w_list_entry_new (list);
     e->value = list->refs ? w_obj_ref (item) : item;
 
     TAILQ_INSERT_HEAD (h, e, tailq);
@@ -211,11 +446,14 @@ w_list_pop_head (w_list_t *list)
 
     w_assert (list->size > 0);
 
+    if (list->backend == W_LIST_ARRAY)
+        return w_list_array_remove (list, 0, true);
+
     e = TAILQ_FIRST (h);
     TAILQ_REMOVE (h, e, tailq);
     list->size--;
     r = e->value;
-    w_free (e);
+    w_list_entry_free (list, e);
     return r;
 }
 
@@ -236,11 +474,14 @@ w_list_pop_tail (w_list_t *list)
 
     w_assert (list->size > 0);
 
+    if (list->backend == W_LIST_ARRAY)
+        return w_list_array_remove (list, list->size - 1, false);
+
     e = TAILQ_LAST (h, w_list_head);
     TAILQ_REMOVE (h, e, tailq);
     list->size--;
     r = e->value;
-    w_free (e);
+    w_list_entry_free (list, e);
     return r;
 }
 
@@ -259,6 +500,9 @@ w_list_at (const w_list_t *list, long index)
     pos = (index < 0) ? list->size + index : (size_t) index;
     w_assert (pos < list->size);
 
+    if (list->backend == W_LIST_ARRAY)
+        return *w_list_array_slot (W_LIST_ARRAY (list), pos);
+
     e = TAILQ_FIRST (h);
     while (pos--)
         e = TAILQ_NEXT (e, tailq);
@@ -275,6 +519,12 @@ void*
 w_list_head (const w_list_t *list)
 {
     _W_LIST_HE;
+
+    if (list->backend == W_LIST_ARRAY) {
+        w_assert (list->size > 0);
+        return *w_list_array_slot (W_LIST_ARRAY (list), 0);
+    }
+
     e = TAILQ_FIRST (h);
     return e->value;
 }
@@ -288,6 +538,12 @@ void*
 w_list_tail (const w_list_t *list)
 {
     _W_LIST_HE;
+
+    if (list->backend == W_LIST_ARRAY) {
+        w_assert (list->size > 0);
+        return *w_list_array_slot (W_LIST_ARRAY (list), list->size - 1);
+    }
+
     e = TAILQ_LAST (h, w_list_head);
     return e->value;
 }
@@ -301,6 +557,10 @@ w_iterator_t
 w_list_first (const w_list_t *list)
 {
     _W_LIST_HE;
+
+    if (list->backend == W_LIST_ARRAY)
+        return list->size ? w_list_array_slot (W_LIST_ARRAY (list), 0) : NULL;
+
     e = TAILQ_FIRST (h);
     return (w_iterator_t) e;
 }
@@ -314,6 +574,12 @@ w_iterator_t
 w_list_last (const w_list_t *list)
 {
     _W_LIST_HE;
+
+    if (list->backend == W_LIST_ARRAY)
+        return list->size
+            ? w_list_array_slot (W_LIST_ARRAY (list), list->size - 1)
+            : NULL;
+
     e = TAILQ_LAST (h, w_list_head);
     return (w_iterator_t) e;
 }
@@ -330,6 +596,14 @@ w_list_next (const w_list_t *list, w_iterator_t i)
     _W_LIST_HE;
     e = (struct w_list_entry*) i;
 
+    if (list->backend == W_LIST_ARRAY) {
+        if (!i)
+            return NULL;
+        const struct w_list_array *a = W_LIST_ARRAY (list);
+        size_t pos = w_list_array_pos (a, i) + 1;
+        return (pos < list->size) ? w_list_array_slot (a, pos) : NULL;
+    }
+
     if (!i || e == TAILQ_LAST (h, w_list_head))
         return NULL;
 
@@ -348,6 +622,14 @@ w_list_prev (const w_list_t *list, w_iterator_t i)
     _W_LIST_HE;
     e = (struct w_list_entry*) i;
 
+    if (list->backend == W_LIST_ARRAY) {
+        if (!i)
+            return NULL;
+        const struct w_list_array *a = W_LIST_ARRAY (list);
+        long pos = w_list_array_pos (a, i);
+        return (pos > 0) ? w_list_array_slot (a, pos - 1) : NULL;
+    }
+
     if (!i || e == TAILQ_FIRST (h))
         return NULL;
 
@@ -365,7 +647,13 @@ w_list_insert_before (w_list_t *list, w_iterator_t i, void *item)
     _W_LIST_HE;
     w_unused (h);
 
-    e = w_new (struct w_list_entry);
+    if (list->backend == W_LIST_ARRAY) {
+        w_list_array_insert (list, w_list_array_pos (W_LIST_ARRAY (list), i),
+                             item);
+        return;
+    }
+
+    e = w_list_entry_new (list);
     e->value = list->refs ? w_obj_ref (item) : item;
 
     TAILQ_INSERT_BEFORE ((struct w_list_entry*) i, e, tailq);
@@ -382,7 +670,14 @@ w_list_insert_after (w_list_t *list, w_iterator_t i, void *item)
 {
     _W_LIST_HE;
 
-    e = w_new (struct w_list_entry);
+    if (list->backend == W_LIST_ARRAY) {
+        w_list_array_insert (list,
+                             w_list_array_pos (W_LIST_ARRAY (list), i) + 1,
+                             item);
+        return;
+    }
+
+    e = w_list_entry_new (list);
     e->value = list->refs ? w_obj_ref (item) : item;
 
     TAILQ_INSERT_AFTER (h, (struct w_list_entry*) i, e, tailq);
@@ -403,7 +698,14 @@ w_list_insert_at (w_list_t *list, long index, void *item)
 {
     _W_LIST_HE;
 
-    e = w_new (struct w_list_entry);
+    if (list->backend == W_LIST_ARRAY) {
+        size_t pos = (index == -1) ? list->size
+                   : (index < 0) ? list->size + index : (size_t) index;
+        w_list_array_insert (list, pos, item);
+        return;
+    }
+
+    e = w_list_entry_new (list);
     e->value = list->refs ? w_obj_ref (item) : item;
 
     if (index == -1) {
@@ -433,6 +735,16 @@ void
 w_list_del (w_list_t *list, w_iterator_t i)
 {
     _W_LIST_HE;
+
+    if (list->backend == W_LIST_ARRAY) {
+        void *item = w_list_array_remove (list,
+                                          w_list_array_pos (W_LIST_ARRAY (list), i),
+                                          true);
+        if (list->refs)
+            w_obj_unref (item);
+        return;
+    }
+
     e = (struct w_list_entry*) i;
     TAILQ_REMOVE (h, e, tailq);
     if (list->refs)
@@ -454,6 +766,13 @@ w_list_del_at (w_list_t *list, long index)
     pos = (index < 0) ? list->size + index : (size_t) index;
     w_assert (pos < list->size);
 
+    if (list->backend == W_LIST_ARRAY) {
+        void *item = w_list_array_remove (list, pos, false);
+        if (list->refs)
+            w_obj_unref (item);
+        return;
+    }
+
     e = TAILQ_FIRST (h);
     while (pos--)
         e = TAILQ_NEXT (e, tailq);
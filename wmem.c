@@ -84,12 +84,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 
 /*~f void* w_malloc(size_t size)
  *
  * Allocates a chunk of memory from the heap of a given `size` and returns a
- * pointer to it. The returned pointer is guaranteed to be valid.
+ * pointer to it. The returned pointer is guaranteed to be valid. The contents
+ * of the memory are undefined: use :func:`w_calloc()` (or the :func:`w_new0()`
+ * and :func:`w_alloc0()` macros) to obtain zero-filled memory.
  *
  * If it was not possible to allocate memory, a fatal error is printed to
  * standard error and execution aborted.
@@ -102,9 +106,31 @@ w_malloc (size_t sz)
         W_FATAL ("virtual memory exhausted (tried to allocate $L bytes)\n",
                  (unsigned long) sz);
     }
+    return p;
+}
+
 
-    /* FIXME This should be removed */
-    memset(p, 0x00, sz);
+/*~f void* w_calloc(size_t count, size_t size)
+ *
+ * Allocates zero-filled memory from the heap for an array of `count`
+ * elements of a given `size`, and returns a pointer to it. The returned
+ * pointer is guaranteed to be valid.
+ *
+ * This is faster than clearing memory allocated with :func:`w_malloc()`,
+ * particularly for big chunks of memory, because the system usually
+ * provides memory pages which are already zero-filled.
+ *
+ * If it was not possible to allocate memory, a fatal error is printed to
+ * standard error and execution aborted.
+ */
+void*
+w_calloc (size_t n, size_t sz)
+{
+    void *p = calloc(n, sz);
+    if (w_unlikely (p == NULL)) {
+        W_FATAL ("virtual memory exhausted (tried to allocate $L*$L bytes)\n",
+                 (unsigned long) n, (unsigned long) sz);
+    }
     return p;
 }
 
@@ -255,3 +281,190 @@ w__lobj_cleanup (void *ptr)
  *      if (need_more_values ())
  *          values = w_resize (values, int, 20);
  */
+
+
+
+/**
+ * Arenas
+ * ------
+ *
+ * Arenas hand out memory from big chunks by moving a pointer forward. All
+ * the memory allocated from an arena is released at once, either by
+ * resetting the arena to a previously obtained mark, or by destroying it.
+ *
+ * .. code-block:: c
+ *
+ *      w_arena_t *arena = w_arena_new (0, 0);
+ *      while (next_request (&req)) {
+ *          w_variant_t *body = w_tnetstr_parse_in (arena, &req.data);
+ *          handle_request (body);
+ *          w_arena_clear (arena);  // Frees the parsed body in O(1).
+ *      }
+ *      w_obj_unref (arena);
+ */
+
+struct w_arena_chunk
+{
+    struct w_arena_chunk *prev;
+    size_t                size;   /* Including this header. */
+};
+
+#define W_ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+
+static struct w_arena_chunk*
+w_arena_chunk_new (const w_arena_t *arena, size_t size)
+{
+    struct w_arena_chunk *chunk;
+
+    if (arena->flags & (W_ARENA_MMAP | W_ARENA_HUGE_PAGES)) {
+        size_t page = (arena->flags & W_ARENA_HUGE_PAGES)
+            ? W_ARENA_HUGE_PAGE_SIZE : (size_t) sysconf (_SC_PAGESIZE);
+        size = (size + page - 1) & ~(page - 1);
+        chunk = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+        if (arena->flags & W_ARENA_HUGE_PAGES)
+            chunk = mmap (NULL, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif /* MAP_HUGETLB */
+
+        /* Fall-back to normal pages, which may be made transparently huge. */
+        if (chunk == MAP_FAILED) {
+            chunk = mmap (NULL, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (chunk == MAP_FAILED)
+                W_FATAL ("virtual memory exhausted (tried to map $L bytes)\n",
+                         (unsigned long) size);
+#ifdef MADV_HUGEPAGE
+            if (arena->flags & W_ARENA_HUGE_PAGES)
+                madvise (chunk, size, MADV_HUGEPAGE);
+#endif /* MADV_HUGEPAGE */
+        }
+    }
+    else {
+        chunk = w_malloc (size);
+    }
+
+    chunk->size = size;
+    return chunk;
+}
+
+
+static void
+w_arena_chunk_free (const w_arena_t *arena, struct w_arena_chunk *chunk)
+{
+    if (arena->flags & (W_ARENA_MMAP | W_ARENA_HUGE_PAGES))
+        munmap (chunk, chunk->size);
+    else
+        w_free (chunk);
+}
+
+
+static void
+_w_arena_dtor (void *obj)
+{
+    w_arena_t *arena = obj;
+    w_arena_clear (arena);
+    if (arena->spare)
+        w_arena_chunk_free (arena, arena->spare);
+}
+
+
+/*~f w_arena_t* w_arena_new (size_t chunk_size, unsigned flags)
+ *
+ * Creates a new arena, which obtains memory from the system in chunks of
+ * `chunk_size` bytes, or :macro:`W_ARENA_CHUNK_SIZE` if zero is passed.
+ * Passing ``W_ARENA_MMAP`` in the `flags` allocates chunks using ``mmap()``,
+ * and ``W_ARENA_HUGE_PAGES`` tries to use huge pages for them.
+ */
+w_arena_t*
+w_arena_new (size_t chunk_size, unsigned flags)
+{
+    w_arena_t *arena = w_obj_new (w_arena_t);
+    arena->chunk_size = chunk_size ? chunk_size : W_ARENA_CHUNK_SIZE;
+    arena->flags = flags;
+    return w_obj_dtor (arena, _w_arena_dtor);
+}
+
+
+/*
+ * Slow path of w_arena_alloc_aligned(): starts a new chunk. Allocations
+ * bigger than the chunk size get a chunk of their own.
+ */
+void*
+w__arena_grow (w_arena_t *arena, size_t size, size_t align)
+{
+    struct w_arena_chunk *chunk;
+    size_t needed = sizeof (struct w_arena_chunk) + size + align;
+
+    if (arena->spare && arena->spare->size >= needed) {
+        chunk = arena->spare;
+        arena->spare = NULL;
+    }
+    else {
+        chunk = w_arena_chunk_new (arena, needed > arena->chunk_size
+                                          ? needed : arena->chunk_size);
+    }
+
+    chunk->prev  = arena->chunk;
+    arena->chunk = chunk;
+    arena->bump  = (char*) (chunk + 1);
+    arena->limit = (char*) chunk + chunk->size;
+    return w_arena_alloc_aligned (arena, size, align);
+}
+
+
+/*~f void* w_arena_realloc (w_arena_t *arena, void *address, size_t old_size, size_t new_size)
+ *
+ * Resizes a chunk of memory at `address` allocated from an `arena` from
+ * its `old_size` to a `new_size`, keeping its contents. If the chunk is
+ * the last allocated from the arena it is resized in place if possible,
+ * otherwise a new chunk is allocated and the contents copied to it.
+ */
+void*
+w_arena_realloc (w_arena_t *arena, void *ptr, size_t old_size, size_t size)
+{
+    w_assert (arena);
+
+    if (ptr && (char*) ptr + old_size == arena->bump &&
+        size <= (size_t) (arena->limit - (char*) ptr)) {
+        arena->bump = (char*) ptr + size;
+        return ptr;
+    }
+
+    void *p = w_arena_alloc (arena, size);
+    if (ptr)
+        memcpy (p, ptr, (old_size < size) ? old_size : size);
+    return p;
+}
+
+
+/*~f void w_arena_reset (w_arena_t *arena, w_arena_mark_t mark)
+ *
+ * Releases all the memory allocated from an `arena` after the `mark` was
+ * obtained using :func:`w_arena_mark()`. Destructors of objects allocated
+ * in the released memory are not run.
+ */
+void
+w_arena_reset (w_arena_t *arena, w_arena_mark_t mark)
+{
+    w_assert (arena);
+
+    while (arena->chunk != mark.chunk) {
+        struct w_arena_chunk *chunk = arena->chunk;
+        w_assert (chunk);
+        arena->chunk = chunk->prev;
+
+        /* Keep one chunk around, it is likely to be needed again soon. */
+        if (!arena->spare && chunk->size <= 2 * arena->chunk_size) {
+            arena->spare = chunk;
+        }
+        else {
+            w_arena_chunk_free (arena, chunk);
+        }
+    }
+
+    arena->bump  = mark.bump;
+    arena->limit = arena->chunk ? (char*) arena->chunk + arena->chunk->size : NULL;
+}
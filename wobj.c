@@ -296,6 +296,12 @@
 
 #include "wheel.h"
 
+#ifdef W_CONF_PTHREAD
+# include <pthread.h>
+#endif /* W_CONF_PTHREAD */
+
+static void w__obj_pool_put (void *obj);
+
 
 /*~f void* w_obj_ref (void *object)
  *
@@ -307,9 +313,24 @@
 void*
 w_obj_ref (void *obj)
 {
-    if (w_likely (obj != NULL))
-        if (w_likely (((w_obj_t*) obj)->__refs != (size_t) -1))
-            ((w_obj_t*) obj)->__refs++;
+    if (w_likely (obj != NULL)) {
+        w_obj_t *o = (w_obj_t*) obj;
+        size_t refs = __atomic_load_n (&o->__refs, __ATOMIC_RELAXED);
+
+        if (w_unlikely (refs == (size_t) -1))
+            return obj;
+
+        /*
+         * Taking a new reference needs no ordering: the caller already
+         * holds one, so the object cannot be destroyed meanwhile.
+         */
+        if (refs & W__OBJ_ATOMIC) {
+            __atomic_fetch_add (&o->__refs, 1, __ATOMIC_RELAXED);
+        }
+        else {
+            o->__refs++;
+        }
+    }
     return obj;
 }
 
@@ -328,12 +349,28 @@ void*
 w_obj_unref (void *obj)
 {
     if (w_likely (obj != NULL)) {
-        if (w_unlikely (((w_obj_t*) obj)->__refs == (size_t) -1)) {
+        w_obj_t *o = (w_obj_t*) obj;
+        size_t refs = __atomic_load_n (&o->__refs, __ATOMIC_RELAXED);
+
+        if (w_unlikely (refs == (size_t) -1)) {
             w_obj_destroy (obj);
             return NULL;
         }
 
-        if (--((w_obj_t*) obj)->__refs == 0) {
+        if (refs & W__OBJ_ATOMIC) {
+            /*
+             * Releasing a reference publishes the changes done to the
+             * object to the thread which drops the last one, which in
+             * turn must see them before running the destructor.
+             */
+            refs = __atomic_sub_fetch (&o->__refs, 1, __ATOMIC_ACQ_REL);
+            if ((refs & ~W__OBJ_FLAGS) == 0) {
+                w_obj_destroy (obj);
+                return NULL;
+            }
+        }
+        /* Objects from arenas and pools have some of W__OBJ_FLAGS set. */
+        else if ((--o->__refs & ~W__OBJ_FLAGS) == 0) {
             w_obj_destroy (obj);
             return NULL;
         }
@@ -362,7 +399,14 @@ w_obj_destroy (void *obj)
         o->__dtor = NULL;
     }
 
-    if (w_likely (o->__refs != (size_t) -1)) {
+    /* Static objects have all the bits set, including W__OBJ_ARENA. */
+    if (w_unlikely (o->__refs & W__OBJ_ARENA))
+        return;
+
+    if (o->__refs & W__OBJ_POOLED) {
+        w__obj_pool_put (o);
+    }
+    else {
         w_free (o);
     }
 }
@@ -423,11 +467,37 @@ w_obj_mark_static (void *obj)
 }
 
 
+/*~f void* w_obj_mark_atomic (void *object)
+ *
+ * Marks an `object` as being shared among threads. Its reference counter
+ * will be updated using atomic operations from then on, which is slower
+ * but allows calling :func:`w_obj_ref()` and :func:`w_obj_unref()` from
+ * different threads at the same time. This function must be called before
+ * the `object` is made visible to other threads.
+ *
+ * When the library is built with ``W_CONF_ATOMIC_REFS`` defined, all
+ * objects are created with atomic reference counters.
+ *
+ * The `object` itself is returned, to allow easy chaining of other
+ * function calls.
+ */
+void*
+w_obj_mark_atomic (void *obj)
+{
+    w_assert (obj);
+
+    if (w_likely (((w_obj_t*) obj)->__refs != (size_t) -1))
+        ((w_obj_t*) obj)->__refs |= W__OBJ_ATOMIC;
+    return obj;
+}
+
+
 /*~f type* w_obj_new (type)
  *
  * Creates a new instance of an object of a given `type`.
  *
- * Freshly created objects always have a reference count of ``1``.
+ * Freshly created objects always have a reference count of ``1``, and the
+ * rest of their fields are zero-filled.
  */
 
 /*~f type* w_obj_new_with_priv_sized (type, size_t size)
@@ -485,3 +555,280 @@ w_obj_mark_static (void *obj)
  * using this function on objects which do not have a private data area is
  * undefined.
  */
+
+
+/**
+ * Object Pools
+ * ------------
+ *
+ * Object types which are created and destroyed at high rates can keep the
+ * memory of destroyed objects in a pool, to be reused for new objects:
+ *
+ * .. code-block:: c
+ *
+ *      static w_obj_pool_t my_type_pool = W_OBJ_POOL (my_type, 128);
+ *
+ *      my_type* my_type_new (void) {
+ *          return w_obj_new_pooled (&my_type_pool, my_type);
+ *      }
+ *
+ * Objects are returned to their pool automatically by
+ * :func:`w_obj_destroy()`.
+ */
+
+/*~M W_OBJ_POOL(type, max_free)
+ *
+ * Initializer for a pool of objects of a given `type`, which keeps up to
+ * `max_free` unused objects.
+ */
+
+/*~M W_OBJ_POOL_MAGAZINE_SIZE
+ *
+ * Number of objects cached by each thread for each pool.
+ */
+#ifndef W_OBJ_POOL_MAGAZINE_SIZE
+#define W_OBJ_POOL_MAGAZINE_SIZE 32
+#endif /* !W_OBJ_POOL_MAGAZINE_SIZE */
+
+/*
+ * Pooled objects are preceded by a pointer to their pool, padded to keep
+ * the alignment of the object. Unused objects are chained using their
+ * first bytes.
+ */
+#define W_OBJ_POOL_HEADER (2 * sizeof (void*))
+
+#define W_OBJ_POOL_OF(_o) \
+    (*((w_obj_pool_t**) (((char*) (_o)) - W_OBJ_POOL_HEADER)))
+
+struct w_obj_pool_counters
+{
+    unsigned long hits;
+    unsigned long misses;
+    long          in_use;
+};
+
+struct w_obj_pool_state
+{
+    void                      *free_list;
+    size_t                     n_free;
+    struct w_obj_pool_counters counters;
+    unsigned long              high_water;
+#ifdef W_CONF_PTHREAD
+    pthread_mutex_t            lock;
+    pthread_key_t              key;
+#endif /* W_CONF_PTHREAD */
+};
+
+
+static inline void
+w_obj_pool_add_counters (struct w_obj_pool_state *state,
+                         struct w_obj_pool_counters *counters)
+{
+    state->counters.hits   += counters->hits;
+    state->counters.misses += counters->misses;
+    state->counters.in_use += counters->in_use;
+    if (state->counters.in_use > 0 &&
+        (unsigned long) state->counters.in_use > state->high_water)
+        state->high_water = state->counters.in_use;
+    *counters = (struct w_obj_pool_counters) { 0, 0, 0 };
+}
+
+
+static inline void
+w_obj_pool_release (w_obj_pool_t *pool, struct w_obj_pool_state *state, void *obj)
+{
+    if (state->n_free < pool->max_free) {
+        *((void**) obj) = state->free_list;
+        state->free_list = obj;
+        state->n_free++;
+    }
+    else {
+        free ((char*) obj - W_OBJ_POOL_HEADER);
+    }
+}
+
+
+#ifdef W_CONF_PTHREAD
+
+struct w_obj_pool_magazine
+{
+    w_obj_pool_t              *pool;
+    size_t                     count;
+    struct w_obj_pool_counters counters;
+    void                      *items[W_OBJ_POOL_MAGAZINE_SIZE];
+};
+
+static pthread_mutex_t w_obj_pool_init_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* Moves objects from a magazine to the shared free list. */
+static void
+w_obj_pool_flush (struct w_obj_pool_magazine *mag, size_t keep)
+{
+    struct w_obj_pool_state *state = mag->pool->state;
+    pthread_mutex_lock (&state->lock);
+    while (mag->count > keep)
+        w_obj_pool_release (mag->pool, state, mag->items[--mag->count]);
+    w_obj_pool_add_counters (state, &mag->counters);
+    pthread_mutex_unlock (&state->lock);
+}
+
+
+static void
+w_obj_pool_magazine_free (void *data)
+{
+    struct w_obj_pool_magazine *mag = data;
+    w_obj_pool_flush (mag, 0);
+    w_free (mag);
+}
+
+#endif /* W_CONF_PTHREAD */
+
+
+static struct w_obj_pool_state*
+w_obj_pool_get_state (w_obj_pool_t *pool)
+{
+#ifdef W_CONF_PTHREAD
+    struct w_obj_pool_state *state = __atomic_load_n (&pool->state, __ATOMIC_ACQUIRE);
+    if (w_likely (state != NULL))
+        return state;
+
+    pthread_mutex_lock (&w_obj_pool_init_lock);
+    if (!(state = pool->state)) {
+        state = w_new0 (struct w_obj_pool_state);
+        pthread_mutex_init (&state->lock, NULL);
+        if (pthread_key_create (&state->key, w_obj_pool_magazine_free))
+            W_FATAL ("Cannot create thread-local storage key\n");
+        __atomic_store_n (&pool->state, state, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock (&w_obj_pool_init_lock);
+    return state;
+#else
+    if (w_unlikely (!pool->state))
+        pool->state = w_new0 (struct w_obj_pool_state);
+    return pool->state;
+#endif /* W_CONF_PTHREAD */
+}
+
+
+#ifdef W_CONF_PTHREAD
+static struct w_obj_pool_magazine*
+w_obj_pool_get_magazine (w_obj_pool_t *pool, struct w_obj_pool_state *state)
+{
+    struct w_obj_pool_magazine *mag = pthread_getspecific (state->key);
+    if (w_unlikely (!mag)) {
+        mag = w_new0 (struct w_obj_pool_magazine);
+        mag->pool = pool;
+        pthread_setspecific (state->key, mag);
+    }
+    return mag;
+}
+#endif /* W_CONF_PTHREAD */
+
+
+void*
+w__obj_pool_get (w_obj_pool_t *pool)
+{
+    struct w_obj_pool_state *state = w_obj_pool_get_state (pool);
+    struct w_obj_pool_counters *counters;
+    void *obj = NULL;
+
+#ifdef W_CONF_PTHREAD
+    struct w_obj_pool_magazine *mag = w_obj_pool_get_magazine (pool, state);
+    counters = &mag->counters;
+
+    /* Refill half of the magazine from the shared free list. */
+    if (w_unlikely (!mag->count)) {
+        pthread_mutex_lock (&state->lock);
+        while (state->free_list && mag->count < W_OBJ_POOL_MAGAZINE_SIZE / 2) {
+            mag->items[mag->count++] = state->free_list;
+            state->free_list = *((void**) state->free_list);
+            state->n_free--;
+        }
+        w_obj_pool_add_counters (state, counters);
+        pthread_mutex_unlock (&state->lock);
+    }
+    if (w_likely (mag->count))
+        obj = mag->items[--mag->count];
+#else
+    counters = &state->counters;
+    if (state->free_list) {
+        obj = state->free_list;
+        state->free_list = *((void**) obj);
+        state->n_free--;
+    }
+#endif /* W_CONF_PTHREAD */
+
+    if (w_likely (obj != NULL)) {
+        counters->hits++;
+    }
+    else {
+        char *mem = w_malloc (W_OBJ_POOL_HEADER + pool->size);
+        *((w_obj_pool_t**) mem) = pool;
+        obj = mem + W_OBJ_POOL_HEADER;
+        counters->misses++;
+    }
+    counters->in_use++;
+
+#ifndef W_CONF_PTHREAD
+    if ((unsigned long) state->counters.in_use > state->high_water)
+        state->high_water = state->counters.in_use;
+#endif /* !W_CONF_PTHREAD */
+
+    return memset (obj, 0x00, pool->size);
+}
+
+
+static void
+w__obj_pool_put (void *obj)
+{
+    w_obj_pool_t *pool = W_OBJ_POOL_OF (obj);
+    struct w_obj_pool_state *state = pool->state;
+    w_assert (state);
+
+#ifdef W_CONF_PTHREAD
+    struct w_obj_pool_magazine *mag = w_obj_pool_get_magazine (pool, state);
+    if (w_unlikely (mag->count == W_OBJ_POOL_MAGAZINE_SIZE))
+        w_obj_pool_flush (mag, W_OBJ_POOL_MAGAZINE_SIZE / 2);
+    mag->items[mag->count++] = obj;
+    mag->counters.in_use--;
+#else
+    w_obj_pool_release (pool, state, obj);
+    state->counters.in_use--;
+#endif /* W_CONF_PTHREAD */
+}
+
+
+/*~f void w_obj_pool_stats (w_obj_pool_t *pool, w_obj_pool_stats_t *stats)
+ *
+ * Obtains the statistics of an object `pool`. The counters of the calling
+ * thread are always up to date, but those of other threads may lag behind.
+ */
+void
+w_obj_pool_stats (w_obj_pool_t *pool, w_obj_pool_stats_t *stats)
+{
+    w_assert (pool);
+    w_assert (stats);
+
+    struct w_obj_pool_state *state = w_obj_pool_get_state (pool);
+    size_t n_free = 0;
+
+#ifdef W_CONF_PTHREAD
+    struct w_obj_pool_magazine *mag = w_obj_pool_get_magazine (pool, state);
+    pthread_mutex_lock (&state->lock);
+    w_obj_pool_add_counters (state, &mag->counters);
+    n_free = mag->count;
+#endif /* W_CONF_PTHREAD */
+
+    *stats = (w_obj_pool_stats_t) {
+        .hits       = state->counters.hits,
+        .misses     = state->counters.misses,
+        .in_use     = state->counters.in_use > 0 ? state->counters.in_use : 0,
+        .high_water = state->high_water,
+        .free       = n_free + state->n_free,
+    };
+
+#ifdef W_CONF_PTHREAD
+    pthread_mutex_unlock (&state->lock);
+#endif /* W_CONF_PTHREAD */
+}
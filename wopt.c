@@ -488,9 +488,9 @@ _w_opt_parse_file (w_parse_t *p, void *ctx)
                 status = (*opt->action) (&oc);
             }
 
-            /* Clean up after ourselves */
-            for (narg = 0; narg < opt->narg; narg++)
-                w_free (args[narg]);
+            /* Clean up after ourselves; input may end before opt->narg */
+            for (unsigned i = 0; i < narg; i++)
+                w_free (args[i]);
             w_free (args);
 
         }
@@ -517,12 +517,26 @@ w_opt_parse_io (const w_opt_t *opt,
     w_assert (opt != NULL);
     w_assert (input != NULL);
 
+    /*
+     * The parser reads one character at a time, which for streams backed
+     * by a file descriptor means one system call per character.
+     */
+    w_io_buffered_t buffered;
+    bool use_buffered = w_io_get_fd (input) >= 0;
+    if (use_buffered) {
+        w_io_buffered_init (&buffered, input, 0, 0);
+        input = (w_io_t*) &buffered;
+    }
+
     char *errmsg;
     w_parse_t parser;
     w_parse_run (&parser, input, '#',
                  _w_opt_parse_file,
                  (void*) opt, &errmsg);
 
+    if (use_buffered)
+        W_IO_NORESULT (w_io_close (input));
+
     bool ret = (errmsg == NULL);
 
     if (msg == NULL) {
@@ -11,6 +11,91 @@
 #include <ctype.h>
 
 
+/*
+ * Appends to "buf" the characters from the input accepted by a predicate,
+ * reading them straight from the data buffered by the input stream. The
+ * first character which is not accepted is left in the input. Returns the
+ * amount of characters appended, which is always zero for streams which
+ * do not support peeking.
+ */
+static size_t
+parse_append_run (w_parse_t *p, w_buf_t *buf,
+                  bool (*accept) (const w_parse_t*, int))
+{
+    size_t total = 0;
+
+    for (;;) {
+        const char *data;
+        w_io_result_t r = w_io_peek (p->input, 1, &data);
+        if (w_io_failed (r) || w_io_eof (r))
+            return total;
+
+        size_t avail = w_io_result_bytes (r);
+        size_t n = 0;
+        while (n < avail && (*accept) (p, (unsigned char) data[n]))
+            n++;
+
+        w_buf_append_mem (buf, data, n);
+        w_io_consume (p->input, n);
+        total += n;
+
+        if (n < avail)
+            return total;
+    }
+}
+
+
+/*
+ * Skips the rest of a commented line, up to the newline character, which
+ * is read and returned (or end-of-file).
+ */
+static int
+parse_skip_comment (w_parse_t *p)
+{
+    const char *data;
+    int chr;
+
+    for (;;) {
+        w_io_result_t r = w_io_peek (p->input, 1, &data);
+        if (w_io_failed (r) || w_io_eof (r))
+            break;
+
+        size_t avail = w_io_result_bytes (r);
+        const char *eol = memchr (data, '\n', avail);
+        w_io_consume (p->input, eol ? (size_t) (eol - data) : avail);
+        if (eol)
+            break;
+    }
+
+    while ((chr = w_io_getchar (p->input)) != '\n' && chr != W_IO_EOF)
+        /* empty statement */;
+
+    return chr;
+}
+
+
+static bool
+is_ident_char (const w_parse_t *p, int chr)
+{
+    return (isalnum (chr) || chr == '_') && chr != p->comment;
+}
+
+
+static bool
+is_word_char (const w_parse_t *p, int chr)
+{
+    return !isspace (chr) && chr != p->comment;
+}
+
+
+static bool
+is_plain_string_char (const w_parse_t *p, int chr)
+{
+    (void) p;
+    return chr != '"' && chr != '\\';
+}
+
+
 void
 w_parse_skip_ws (w_parse_t *p)
 {
@@ -36,8 +121,7 @@ w_parse_getchar (w_parse_t *p)
         p->lpos++;
 
         if (p->comment && p->look == p->comment) {
-            while ((p->look = w_io_getchar (p->input)) != '\n' &&
-                   (p->look != W_IO_EOF)) /* empty statement */;
+            p->look = parse_skip_comment (p);
 
             if (w_unlikely (p->look != W_IO_EOF)) {
                 w_io_putback (p->input, '\n');
@@ -105,6 +189,7 @@ w_parse_ident (w_parse_t *p)
 
     while (isalnum (p->look) || p->look == '_') {
         w_buf_append_char (&buf, p->look);
+        p->lpos += parse_append_run (p, &buf, is_ident_char);
         w_parse_getchar (p);
     }
 
@@ -254,6 +339,7 @@ w_parse_word (w_parse_t *p)
 
     while (!isspace (p->look) && p->look != W_IO_EOF) {
         w_buf_append_char (&buf, p->look);
+        p->lpos += parse_append_run (p, &buf, is_word_char);
         w_parse_getchar (p);
     }
 
@@ -268,10 +354,13 @@ char*
 w_parse_string (w_parse_t *p)
 {
     w_buf_t buf = W_BUF;
-    int     chr = w_io_getchar (p->input);
+    int     chr;
 
     w_assert (p != NULL);
 
+    parse_append_run (p, &buf, is_plain_string_char);
+    chr = w_io_getchar (p->input);
+
     for (; chr != '"' && chr != W_IO_EOF; chr = w_io_getchar (p->input)) {
         if (chr == '\\') {
             /* escaped sequences */
@@ -297,6 +386,7 @@ w_parse_string (w_parse_t *p)
             }
         }
         w_buf_append_char (&buf, chr);
+        parse_append_run (p, &buf, is_plain_string_char);
     }
 
     /* Premature end of string. */
@@ -13,6 +13,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <math.h>
+#include <float.h>
 
 #ifdef W_CONF_SIPHASH
 static inline int siphash (const uint8_t *in, size_t inlen,
@@ -343,3 +344,269 @@ w_str_time_period (const char *str, unsigned long long *val)
 
     return (*val = v, true);
 }
+
+
+/*
+ * Checks whether the eight bytes in "chunk" are all decimal digits, and
+ * converts them into their numeric value. Digits are loaded in memory
+ * order, so this is only usable on little-endian machines.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+# define W_STR_SCAN_SWAR 1
+
+static inline bool
+scan_eight_digits (const char *str, uint64_t *val)
+{
+    uint64_t chunk;
+    memcpy (&chunk, str, sizeof (chunk));
+
+    if (((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+         (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+        != 0x3333333333333333ULL)
+        return false;
+
+    chunk = ((chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    *val = ((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+    return true;
+}
+#endif /* __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ */
+
+
+static inline bool
+is_digit (char ch)
+{
+    return (unsigned char) (ch - '0') < 10;
+}
+
+
+size_t
+w_str_scan_ulong (const char *str, size_t len, unsigned long *val)
+{
+    unsigned long v = 0;
+    size_t i = 0;
+
+    w_assert (val);
+
+    if (len && str[0] == '+')
+        i++;
+
+    const size_t start = i;
+
+#ifdef W_STR_SCAN_SWAR
+    uint64_t chunk;
+    while (len - i >= 8 && scan_eight_digits (str + i, &chunk)) {
+        if (v > (ULONG_MAX - chunk) / 100000000UL)
+            return 0;
+        v = v * 100000000UL + chunk;
+        i += 8;
+    }
+#endif /* W_STR_SCAN_SWAR */
+
+    for (; i < len && is_digit (str[i]); i++) {
+        unsigned digit = str[i] - '0';
+        if (v > (ULONG_MAX - digit) / 10)
+            return 0;
+        v = v * 10 + digit;
+    }
+
+    if (i == start)
+        return 0;
+
+    *val = v;
+    return i;
+}
+
+
+size_t
+w_str_scan_long (const char *str, size_t len, long *val)
+{
+    bool negative = false;
+    unsigned long uval;
+    size_t i = 0;
+
+    w_assert (val);
+
+    if (len && (str[0] == '-' || str[0] == '+')) {
+        negative = (str[0] == '-');
+        i++;
+    }
+
+    if (i == len || !is_digit (str[i]))
+        return 0;
+
+    size_t n = w_str_scan_ulong (str + i, len - i, &uval);
+    if (!n)
+        return 0;
+
+    if (negative) {
+        if (uval > (unsigned long) LONG_MAX + 1)
+            return 0;
+        *val = (uval > LONG_MAX) ? LONG_MIN : -(long) uval;
+    } else {
+        if (uval > LONG_MAX)
+            return 0;
+        *val = uval;
+    }
+
+    return i + n;
+}
+
+
+static inline bool
+match_nocase (const char *str, size_t len, const char *word, size_t wlen)
+{
+    if (len < wlen)
+        return false;
+    for (size_t i = 0; i < wlen; i++)
+        if ((str[i] | 0x20) != word[i])
+            return false;
+    return true;
+}
+
+
+/*
+ * Powers of ten which are exactly representable as doubles. A mantissa
+ * of up to 53 bits multiplied or divided by one of them gives a correctly
+ * rounded result (Clinger's fast path), provided that the arithmetic is
+ * done in double precision.
+ */
+static const double s_exact_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+#ifndef W_STR_SCAN_DOUBLE_BUFSIZE
+#define W_STR_SCAN_DOUBLE_BUFSIZE 128
+#endif /* !W_STR_SCAN_DOUBLE_BUFSIZE */
+
+
+size_t
+w_str_scan_double (const char *str, size_t len, double *val)
+{
+    bool negative = false;
+    size_t i = 0;
+
+    w_assert (val);
+
+    if (len && (str[0] == '-' || str[0] == '+')) {
+        negative = (str[0] == '-');
+        i++;
+    }
+
+    if (i < len && !is_digit (str[i]) && str[i] != '.') {
+        if (match_nocase (str + i, len - i, "nan", 3)) {
+            *val = negative ? -NAN : NAN;
+            return i + 3;
+        }
+        if (match_nocase (str + i, len - i, "infinity", 8)) {
+            *val = negative ? -INFINITY : INFINITY;
+            return i + 8;
+        }
+        if (match_nocase (str + i, len - i, "inf", 3)) {
+            *val = negative ? -INFINITY : INFINITY;
+            return i + 3;
+        }
+        return 0;
+    }
+
+    /*
+     * Accumulate up to 19 significant digits, which always fit in 64 bits,
+     * keeping track of the decimal exponent. Leading zeroes do not count.
+     */
+    uint64_t mantissa = 0;
+    unsigned digits = 0;
+    bool truncated = false;
+    bool got_num = false;
+    long exp10 = 0;
+
+    for (; i < len && is_digit (str[i]); i++) {
+        got_num = true;
+        if (digits < 19) {
+            if (mantissa || str[i] != '0') {
+                mantissa = mantissa * 10 + (str[i] - '0');
+                digits++;
+            }
+        } else {
+            truncated = true;
+        }
+    }
+
+    if (i < len && str[i] == '.') {
+        for (i++; i < len && is_digit (str[i]); i++) {
+            got_num = true;
+            if (digits < 19) {
+                if (mantissa || str[i] != '0') {
+                    mantissa = mantissa * 10 + (str[i] - '0');
+                    digits++;
+                }
+                exp10--;
+            } else {
+                truncated = true;
+            }
+        }
+    }
+
+    if (!got_num)
+        return 0;
+
+    /* The exponent is only consumed if there are digits after the marker. */
+    if (i < len && (str[i] | 0x20) == 'e') {
+        size_t j = i + 1;
+        bool negexp = false;
+        if (j < len && (str[j] == '-' || str[j] == '+'))
+            negexp = (str[j++] == '-');
+        if (j < len && is_digit (str[j])) {
+            long e = 0;
+            for (; j < len && is_digit (str[j]); j++)
+                if (e < 100000)
+                    e = e * 10 + (str[j] - '0');
+            exp10 += negexp ? -e : e;
+            i = j;
+        }
+    }
+
+    /* Too many significant digits: leave the rounding to strtod(). */
+    if (truncated)
+        goto slow_path;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    if (mantissa <= (UINT64_C(1) << 53) &&
+        exp10 >= -22 && exp10 <= 22) {
+        double v = (double) mantissa;
+        if (exp10 < 0)
+            v /= s_exact_pow10[-exp10];
+        else
+            v *= s_exact_pow10[exp10];
+        *val = negative ? -v : v;
+        return i;
+    }
+#endif /* FLT_EVAL_METHOD == 0 */
+
+slow_path:
+    {
+        /*
+         * The span has been validated as a decimal number, so strtod()
+         * consumes all of it. It needs a null-terminated copy, though.
+         */
+        char stackbuf[W_STR_SCAN_DOUBLE_BUFSIZE];
+        char *buf = (i < sizeof (stackbuf)) ? stackbuf : w_malloc (i + 1);
+        memcpy (buf, str, i);
+        buf[i] = '\0';
+
+        int saved_errno = errno;
+        errno = 0;
+        double v = strtod (buf, NULL);
+        bool overflow = (errno == ERANGE && isinf (v));
+        errno = saved_errno;
+
+        if (buf != stackbuf)
+            w_free (buf);
+
+        if (overflow)
+            return 0;
+
+        *val = v;
+        return i;
+    }
+}
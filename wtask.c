@@ -300,6 +300,18 @@ w_task_current (void)
 }
 
 
+/*
+ * Used by code which needs to know whether it is running on the (possibly
+ * small) stack of a task. Unlike w_task_current(), this may be called
+ * from anywhere.
+ */
+bool
+w__task_running (void)
+{
+    return s_current_task != NULL;
+}
+
+
 /*~f void w_task_set_is_system (w_task_t *task, bool is_system)
  *
  * Set whether a `task` is a system task. System tasks are those which
@@ -428,6 +440,7 @@ w_task_run_scheduler (void)
                 s_num_tasks--;
             free_task_and_stack (s_current_task);
         }
+        s_current_task = NULL;
     }
 }
 
@@ -555,6 +568,91 @@ w_task_yield_io_write (w_io_t *io, const void *buf, size_t len)
 }
 
 
+/*~f w_io_result_t w_task_yield_io_writev (w_io_t *stream, const struct iovec *segments, int count)
+ *
+ * Writes the data from a number of memory `segments` to an output `stream`
+ * using :func:`w_io_writev()`, suspending the current task as needed.
+ *
+ * If the `stream` has been set as non-blocking, the current task will give
+ * up the CPU and wait until the stream accepts writing data as many times
+ * as needed, until all the data is written, or an error is found.
+ */
+w_io_result_t
+w_task_yield_io_writev (w_io_t *io, const struct iovec *iov, int iovcnt)
+{
+    CHECK_SCHEDULER ();
+    w_assert (io);
+
+    size_t n = 0, offset = 0;
+    while (iovcnt > 0) {
+        w_io_result_t r;
+        if (offset) {
+            /* Finish writing a partially written segment first. */
+            struct iovec rest = {
+                .iov_base = (char*) iov->iov_base + offset,
+                .iov_len  = iov->iov_len - offset,
+            };
+            r = w_io_writev (io, &rest, 1);
+        } else {
+            w_assert (iov);
+            r = w_io_writev (io, iov, iovcnt);
+        }
+
+        if (w_io_failed (r)) {
+            int err = w_io_result_error (r);
+            if (err == EAGAIN || err == EWOULDBLOCK) {
+                yield_to_scheduler (TASK_WAITIO);
+                continue;
+            }
+            return r;
+        }
+
+        size_t written = w_io_result_bytes (r);
+        n += written;
+
+        /* Skip over the segments which have been written completely. */
+        written += offset;
+        while (iovcnt > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        offset = written;
+    }
+    return W_IO_RESULT (n);
+}
+
+
+/*~f w_io_result_t w_task_yield_io_readv (w_io_t *stream, const struct iovec *segments, int count)
+ *
+ * Reads data from an input `stream` into a number of memory `segments`
+ * using :func:`w_io_readv()`, suspending the current task as needed.
+ *
+ * If the `stream` has been set as non-blocking, the current task will give
+ * up the CPU and wait until data is available for reading. Note that,
+ * contrary to :func:`w_task_yield_io_read()`, this returns as soon as some
+ * data has been read, even if the `segments` have not been filled.
+ */
+w_io_result_t
+w_task_yield_io_readv (w_io_t *io, const struct iovec *iov, int iovcnt)
+{
+    CHECK_SCHEDULER ();
+    w_assert (io);
+
+    for (;;) {
+        w_io_result_t r = w_io_readv (io, iov, iovcnt);
+        if (w_io_failed (r)) {
+            int err = w_io_result_error (r);
+            if (err == EAGAIN || err == EWOULDBLOCK) {
+                yield_to_scheduler (TASK_WAITIO);
+                continue;
+            }
+        }
+        return r;
+    }
+}
+
+
 static int
 w_io_task_getfd (w_io_t *iobase)
 {
@@ -607,6 +705,26 @@ w_io_task_write (w_io_t *iobase, const void *buf, size_t len)
 }
 
 
+static w_io_result_t
+w_io_task_writev (w_io_t *iobase, const struct iovec *iov, int iovcnt)
+{
+    w_io_task_t *io = (w_io_task_t*) iobase;
+    return io->wrapped
+        ? w_task_yield_io_writev (io->wrapped, iov, iovcnt)
+        : W_IO_RESULT_ERROR (errno = EBADF);
+}
+
+
+static w_io_result_t
+w_io_task_readv (w_io_t *iobase, const struct iovec *iov, int iovcnt)
+{
+    w_io_task_t *io = (w_io_task_t*) iobase;
+    return io->wrapped
+        ? w_task_yield_io_readv (io->wrapped, iov, iovcnt)
+        : W_IO_RESULT_ERROR (errno = EBADF);
+}
+
+
 /*~f bool w_io_task_init (w_io_task_t *wrapper, w_io_t *stream)
  *
  * Initializes a stream `wrapper` object (possibly allocated in the stack)
@@ -639,11 +757,16 @@ w_io_task_init (w_io_task_t *io, w_io_t *wrapped)
     io->parent.flush = w_io_task_flush;
     io->parent.getfd = w_io_task_getfd;
     io->parent.close = w_io_task_close;
+    io->parent.writev = w_io_task_writev;
+    io->parent.readv  = w_io_task_readv;
     io->wrapped = w_obj_ref (wrapped);
     return true;
 }
 
 
+static w_obj_pool_t w_io_task_pool = W_OBJ_POOL (w_io_task_t, 64);
+
+
 /*~f w_io_t* w_io_task_open (w_io_t *stream)
  *
  * Wraps a `stream` and returns an object that behaves like the wrapped
@@ -657,9 +780,9 @@ w_io_task_init (w_io_task_t *io, w_io_t *wrapped)
 w_io_t*
 w_io_task_open (w_io_t *wrapped)
 {
-    w_io_task_t *io = w_obj_new (w_io_task_t);
+    w_io_task_t *io = w_obj_new_pooled (&w_io_task_pool, w_io_task_t);
     if (w_io_task_init (io, wrapped))
-        return (w_io_t*) io;
+        return w__obj_init_pooled (io);
     w_obj_destroy (io);
     return NULL;
 }
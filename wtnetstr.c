@@ -77,6 +77,31 @@ w_tnetstr_write_bool (w_io_t *io, bool value)
 }
 
 
+/*
+ * Writes a length-prefixed payload followed by its type tag using a single
+ * vectored write, instead of the several writes done by w_io_format().
+ */
+static w_io_result_t
+write_payload (w_io_t *io, const void *data, size_t len, char tag)
+{
+    char header[_W_TNS_SIZE_DIGITS + 1];
+    char *p = header + sizeof (header);
+    size_t n = len;
+
+    *--p = ':';
+    do {
+        *--p = '0' + n % 10;
+    } while ((n /= 10));
+
+    const struct iovec iov[3] = {
+        { .iov_base = p,            .iov_len = header + sizeof (header) - p },
+        { .iov_base = (void*) data, .iov_len = len },
+        { .iov_base = &tag,         .iov_len = 1 },
+    };
+    return w_io_writev (io, iov, 3);
+}
+
+
 w_io_result_t
 w_tnetstr_dump_string (w_buf_t *buffer, const char *value)
 {
@@ -101,7 +126,7 @@ w_tnetstr_write_string (w_io_t *io, const char *value)
     if (w_unlikely ((len) > _W_TNS_MAX_PAYLOAD))
         return W_IO_RESULT_ERROR (EINVAL);
 
-    return w_io_format (io, "$L:$S,", len, len, value);
+    return write_payload (io, value, len, _W_TNS_TAG_STRING);
 }
 
 
@@ -127,7 +152,8 @@ w_tnetstr_write_buffer (w_io_t *io, const w_buf_t *value)
     if (w_unlikely (w_buf_size (value) > _W_TNS_MAX_PAYLOAD))
         return W_IO_RESULT_ERROR (EINVAL);
 
-    return w_io_format (io, "$L:$B,", w_buf_size (value), value);
+    return write_payload (io, w_buf_const_data (value), w_buf_size (value),
+                          _W_TNS_TAG_STRING);
 }
 
 
@@ -232,6 +258,7 @@ w_tnetstr_dump (w_buf_t *buffer, const w_variant_t *value)
 
     switch (w_variant_type (value)) {
         case W_VARIANT_TYPE_BUFFER:
+        case W_VARIANT_TYPE_BYTES:
             W_FATAL ("Invalid variant with type W_VARIANT_BUFFER.\n"
                      "This is a programming error.\n");
             break;
@@ -277,6 +304,7 @@ w_tnetstr_write (w_io_t *io, const w_variant_t *value)
 
     switch (w_variant_type (value)) {
         case W_VARIANT_TYPE_BUFFER:
+        case W_VARIANT_TYPE_BYTES:
             W_FATAL ("Invalid variant with type W_VARIANT_BUFFER.\n"
                      "This is a programming error.\n");
             break;
@@ -364,26 +392,78 @@ slice_payload (const w_buf_t *buffer, w_buf_t* slice, int type_tag)
     slice->data  = ++pbuf;
     slice->size  = plen;
     slice->alloc = 0;
+    slice->arena = NULL;
 
     return false;
 }
 
 
+/*
+ * Checks whether a complete item is at the start of the data which can be
+ * peeked from a stream, and returns its size. Zero is returned if peeking
+ * is unsupported, or the item is incomplete or malformed; then the caller
+ * reads it character by character, which takes care of reporting errors.
+ * Only the data already available is checked for the size prefix, so this
+ * never waits for more input than the item itself.
+ */
+static size_t
+peek_item (w_io_t *io, const char **data)
+{
+    if (!io->peek)
+        return 0;
+
+    w_io_result_t r = w_io_peek (io, 1, data);
+    if (w_io_failed (r) || w_io_eof (r))
+        return 0;
+
+    size_t avail = w_io_result_bytes (r);
+    size_t plen = 0;
+    unsigned i;
+
+    for (i = 0; i < avail && i <= _W_TNS_SIZE_DIGITS && (*data)[i] != ':'; i++) {
+        if (w_unlikely ((*data)[i] < '0' || (*data)[i] > '9'))
+            return 0;
+        plen = plen * 10 + ((*data)[i] - '0');
+    }
+
+    if (i >= avail || (*data)[i] != ':' || plen > _W_TNS_MAX_PAYLOAD)
+        return 0;
+
+    size_t size = i + plen + 2; /* colon + payload + type tag */
+    if (size > avail) {
+        r = w_io_peek (io, size, data);
+        if (w_io_failed (r) || w_io_eof (r) || w_io_result_bytes (r) < size)
+            return 0;
+    }
+    return size;
+}
+
+
 bool
 w_tnetstr_read_to_buffer (w_io_t *io, w_buf_t *buffer)
 {
     w_assert (io);
     w_assert (buffer);
 
+    /* Copy the whole item at once when the stream has it at hand. */
+    const char *data;
+    size_t size = peek_item (io, &data);
+    if (size) {
+        w_buf_append_mem (buffer, data, size);
+        w_io_consume (io, size);
+        return false;
+    }
+
     unsigned blen = _W_TNS_SIZE_DIGITS + 1; /* number + colon */
-    unsigned plen;
+    unsigned plen = 0;
     int ch = '\0';
 
-    for (plen = 0; blen-- && (ch = w_io_getchar (io)) != ':'; plen *= 10) {
+    while (blen-- && (ch = w_io_getchar (io)) != ':') {
+        if (w_unlikely (ch < '0' || ch > '9'))
+            goto return_error;
         w_buf_append_char (buffer, ch);
-        plen += ch - '0';
+        plen = plen * 10 + (ch - '0');
     }
-    plen /= 10;
 
     if (w_unlikely (plen > _W_TNS_MAX_PAYLOAD || ch != ':'))
         goto return_error;
@@ -391,15 +471,47 @@ w_tnetstr_read_to_buffer (w_io_t *io, w_buf_t *buffer)
     w_buf_append_char (buffer, ':');
 
     /*
-     * Extend buffer to fit the payload data plus the terminating character.
+     * Extend buffer to fit the payload data plus the terminating character,
+     * which may arrive in pieces when reading from pipes or sockets.
      */
     blen = w_buf_size (buffer);
     w_buf_resize (buffer, ++plen + blen);
-    w_io_result_t r = w_io_read (io, w_buf_data (buffer) + blen, plen);
+    while (plen) {
+        w_io_result_t r = w_io_read (io, w_buf_data (buffer) + blen, plen);
+        if (w_io_failed (r) || w_io_eof (r))
+            goto return_error;
+        blen += w_io_result_bytes (r);
+        plen -= w_io_result_bytes (r);
+    }
+    return false;
 
 return_error:
     w_buf_clear (buffer);
-    return w_io_failed (r) || w_io_result_bytes (r) != plen;
+    return true;
+}
+
+
+w_variant_t*
+w_tnetstr_read (w_io_t *io)
+{
+    w_assert (io);
+
+    /* Parse directly from the stream data, e.g. a memory-mapped file. */
+    const char *data;
+    size_t size = peek_item (io, &data);
+    if (size) {
+        const w_buf_t buffer = { .data = (char*) data, .size = size };
+        w_variant_t *variant = w_tnetstr_parse (&buffer);
+        w_io_consume (io, size);
+        return variant;
+    }
+
+    w_buf_t buf = W_BUF;
+    w_variant_t *variant = NULL;
+    if (!w_tnetstr_read_to_buffer (io, &buf))
+        variant = w_tnetstr_parse (&buf);
+    w_buf_clear (&buf);
+    return variant;
 }
 
 
@@ -418,7 +530,6 @@ bool
 w_tnetstr_parse_float (const w_buf_t *buffer, double *value)
 {
     w_buf_t payload;
-    w_io_buf_t iobuf;
 
     w_assert (buffer);
     w_assert (value);
@@ -428,8 +539,9 @@ w_tnetstr_parse_float (const w_buf_t *buffer, double *value)
         slice_payload (buffer, &payload, _W_TNS_TAG_FLOAT))
         return true;
 
-    w_io_buf_init (&iobuf, &payload, false);
-    return w_io_fscan_double ((w_io_t*) &iobuf, value);
+    /* The whole payload must be the number. */
+    size_t size = w_buf_size (&payload);
+    return !size || w_str_scan_double (w_buf_const_data (&payload), size, value) != size;
 }
 
 
@@ -437,7 +549,6 @@ bool
 w_tnetstr_parse_number (const w_buf_t *buffer, long *value)
 {
     w_buf_t payload;
-    w_io_buf_t iobuf;
 
     w_assert (buffer);
     w_assert (value);
@@ -447,8 +558,9 @@ w_tnetstr_parse_number (const w_buf_t *buffer, long *value)
         slice_payload (buffer, &payload, _W_TNS_TAG_NUMBER))
         return true;
 
-    w_io_buf_init (&iobuf, &payload, false);
-    return w_io_fscan_long ((w_io_t*) &iobuf, value);
+    /* The whole payload must be the number. */
+    size_t size = w_buf_size (&payload);
+    return !size || w_str_scan_long (w_buf_const_data (&payload), size, value) != size;
 }
 
 
@@ -504,15 +616,16 @@ w_tnetstr_parse_string (const w_buf_t *buffer, w_buf_t *value)
 }
 
 
-bool
-w_tnetstr_parse_list (const w_buf_t *buffer, w_list_t *value)
+static w_variant_t* parse_variant (w_arena_t*, w_bytes_t*, const w_buf_t*);
+
+
+static bool
+parse_list (w_arena_t *arena, w_bytes_t *source,
+            const w_buf_t *buffer, w_list_t *value)
 {
     w_buf_t payload;
     size_t szdone = 0;
 
-    w_assert (buffer);
-    w_assert (value);
-
     if (slice_payload (buffer, &payload, _W_TNS_TAG_LIST))
         return true;
 
@@ -522,7 +635,7 @@ w_tnetstr_parse_list (const w_buf_t *buffer, w_list_t *value)
             .size = w_buf_size (&payload) - szdone,
         };
         w_variant_t *variant;
-        if (!(variant = w_tnetstr_parse (&curitem)))
+        if (!(variant = parse_variant (arena, source, &curitem)))
             return true;
 
         szdone += peek_item_size (&curitem);
@@ -536,25 +649,33 @@ w_tnetstr_parse_list (const w_buf_t *buffer, w_list_t *value)
 
 
 bool
-w_tnetstr_parse_dict (const w_buf_t *buffer, w_dict_t *value)
+w_tnetstr_parse_list (const w_buf_t *buffer, w_list_t *value)
 {
-    w_buf_t payload;
-    size_t szdone = 0;
-
     w_assert (buffer);
     w_assert (value);
+    return parse_list (NULL, NULL, buffer, value);
+}
+
+
+static bool
+parse_dict (w_arena_t *arena, w_bytes_t *source,
+            const w_buf_t *buffer, w_dict_t *value)
+{
+    w_buf_t payload;
+    size_t szdone = 0;
 
     if (slice_payload (buffer, &payload, _W_TNS_TAG_DICT))
         return true;
 
     while (szdone < w_buf_size (&payload)) {
-        w_buf_t key = W_BUF;
+        /* Keys are used directly from the input, they get copied anyway. */
+        w_buf_t key;
         w_buf_t curitem = {
             .data = w_buf_data (&payload) + szdone,
             .size = w_buf_size (&payload) - szdone,
         };
         w_variant_t *variant;
-        if (w_tnetstr_parse_string (&curitem, &key))
+        if (slice_payload (&curitem, &key, _W_TNS_TAG_STRING))
             return true;
 
         szdone += peek_item_size (&curitem);
@@ -563,24 +684,38 @@ w_tnetstr_parse_dict (const w_buf_t *buffer, w_dict_t *value)
             .data = w_buf_data (&payload) + szdone,
             .size = w_buf_size (&payload) - szdone,
         };
-        if (!(variant = w_tnetstr_parse (&curitem))) {
-            w_buf_clear (&key);
+        if (!(variant = parse_variant (arena, source, &curitem)))
             return true;
-        }
 
         szdone += peek_item_size (&curitem);
 
         w_dict_setn (value, w_buf_data (&key), w_buf_size (&key), variant);
         w_obj_unref (variant);
-        w_buf_clear (&key);
     }
 
     return false;
 }
 
 
-w_variant_t*
-w_tnetstr_parse (const w_buf_t *buffer)
+bool
+w_tnetstr_parse_dict (const w_buf_t *buffer, w_dict_t *value)
+{
+    w_assert (buffer);
+    w_assert (value);
+    return parse_dict (NULL, NULL, buffer, value);
+}
+
+
+#define NEW_VARIANT(...) \
+    (arena ? w_variant_new_in (arena, __VA_ARGS__) : w_variant_new (__VA_ARGS__))
+
+/*
+ * When parsing from a w_bytes_t, the "source" is the chunk of bytes which
+ * contains the input, and string values share its memory instead of
+ * being copied.
+ */
+static w_variant_t*
+parse_variant (w_arena_t *arena, w_bytes_t *source, const w_buf_t *buffer)
 {
     w_variant_t *ret = NULL;
     size_t item_len;
@@ -593,8 +728,6 @@ w_tnetstr_parse (const w_buf_t *buffer)
         w_dict_t *vdict;
     } v = { W_BUF };
 
-    w_assert (buffer);
-
     item_len = peek_item_size (buffer);
 
     if (item_len < _W_TNS_MIN_LENGTH)
@@ -603,41 +736,57 @@ w_tnetstr_parse (const w_buf_t *buffer)
     switch (w_buf_const_data (buffer)[item_len-1]) {
         case _W_TNS_TAG_NULL:
             if (!w_tnetstr_parse_null (buffer))
-                ret = w_variant_new (W_VARIANT_TYPE_NULL);
+                ret = NEW_VARIANT (W_VARIANT_TYPE_NULL);
             break;
 
         case _W_TNS_TAG_FLOAT:
             if (!w_tnetstr_parse_float (buffer, &v.vdouble))
-                ret = w_variant_new (W_VARIANT_TYPE_FLOAT, v.vdouble);
+                ret = NEW_VARIANT (W_VARIANT_TYPE_FLOAT, v.vdouble);
             break;
 
         case _W_TNS_TAG_NUMBER:
             if (!w_tnetstr_parse_number (buffer, &v.vlong))
-                ret = w_variant_new (W_VARIANT_TYPE_NUMBER, v.vlong);
+                ret = NEW_VARIANT (W_VARIANT_TYPE_NUMBER, v.vlong);
             break;
 
         case _W_TNS_TAG_STRING:
-            if (!w_tnetstr_parse_string (buffer, &v.vbuf))
-                ret = w_variant_new (W_VARIANT_TYPE_BUFFER, &v.vbuf);
-            w_buf_clear (&v.vbuf);
+            if (slice_payload (buffer, &v.vbuf, _W_TNS_TAG_STRING))
+                break;
+            if (source) {
+                /*
+                 * A slice in the stack is enough: the variant only keeps
+                 * a reference to its owner, which is the chunk of bytes
+                 * with the input.
+                 */
+                w_bytes_t slice = {
+                    .owner = w_bytes_owner (source),
+                    .data  = w_buf_data (&v.vbuf),
+                    .size  = w_buf_size (&v.vbuf),
+                };
+                ret = NEW_VARIANT (W_VARIANT_TYPE_BYTES, &slice);
+            } else {
+                /* The payload is copied by the new variant. */
+                ret = NEW_VARIANT (W_VARIANT_TYPE_BUFFER, &v.vbuf);
+            }
             break;
 
         case _W_TNS_TAG_BOOLEAN:
             if (!w_tnetstr_parse_bool (buffer, &v.vbool))
-                ret = w_variant_new (W_VARIANT_TYPE_BOOL, v.vbool);
+                ret = NEW_VARIANT (W_VARIANT_TYPE_BOOL, v.vbool);
             break;
 
         case _W_TNS_TAG_LIST:
-            v.vlist = w_list_new (true);
-            if (!w_tnetstr_parse_list (buffer, v.vlist))
-                ret = w_variant_new (W_VARIANT_TYPE_LIST, v.vlist);
+            v.vlist = arena ? w_list_new_in (arena, true)
+                            : w_list_new_with_backend (true, W_LIST_ARRAY);
+            if (!parse_list (arena, source, buffer, v.vlist))
+                ret = NEW_VARIANT (W_VARIANT_TYPE_LIST, v.vlist);
             w_obj_unref (v.vlist);
             break;
 
         case _W_TNS_TAG_DICT:
-            v.vdict = w_dict_new (true);
-            if (!w_tnetstr_parse_dict (buffer, v.vdict))
-                ret = w_variant_new (W_VARIANT_TYPE_DICT, v.vdict);
+            v.vdict = arena ? w_dict_new_in (arena, true) : w_dict_new (true);
+            if (!parse_dict (arena, source, buffer, v.vdict))
+                ret = NEW_VARIANT (W_VARIANT_TYPE_DICT, v.vdict);
             w_obj_unref (v.vdict);
             break;
     }
@@ -645,3 +794,34 @@ w_tnetstr_parse (const w_buf_t *buffer)
     return ret;
 }
 
+#undef NEW_VARIANT
+
+
+w_variant_t*
+w_tnetstr_parse (const w_buf_t *buffer)
+{
+    w_assert (buffer);
+    return parse_variant (NULL, NULL, buffer);
+}
+
+
+w_variant_t*
+w_tnetstr_parse_in (w_arena_t *arena, const w_buf_t *buffer)
+{
+    w_assert (arena);
+    w_assert (buffer);
+    return parse_variant (arena, NULL, buffer);
+}
+
+
+w_variant_t*
+w_tnetstr_parse_bytes (w_bytes_t *bytes)
+{
+    w_assert (bytes);
+
+    const w_buf_t buffer = {
+        .data = (char*) w_bytes_data (bytes),
+        .size = w_bytes_size (bytes),
+    };
+    return parse_variant (NULL, bytes, &buffer);
+}
@@ -21,8 +21,16 @@ _w_variant_clear (w_variant_t *v)
             break;
 
         case W_VARIANT_TYPE_BUFFER:
+        case W_VARIANT_TYPE_BYTES:
         case W_VARIANT_TYPE_STRING:
-            w_buf_clear (&v->value.stringbuf);
+            if (v->shared) {
+                /* The memory belongs to the shared chunk of bytes. */
+                w_obj_unref (v->shared);
+                v->shared = NULL;
+                v->value.stringbuf = (w_buf_t) W_BUF;
+            } else {
+                w_buf_clear (&v->value.stringbuf);
+            }
             break;
 
         case W_VARIANT_TYPE_LIST:
@@ -47,14 +55,13 @@ _w_variant_dtor (void *obj)
 }
 
 
-w_variant_t*
-w_variant_new (w_variant_type_t type, ...)
+static w_variant_t*
+w_variant_init (w_variant_t *variant, w_arena_t *arena,
+                w_variant_type_t type, va_list args)
 {
-    va_list args;
-    w_variant_t *variant = w_obj_new (w_variant_t);
     memset (&variant->value, 0x00, sizeof (w_variant_value_t));
+    variant->shared = NULL;
 
-    va_start (args, type);
     switch ((variant->type = type)) {
         case W_VARIANT_TYPE_INVALID:
         case W_VARIANT_TYPE_NULL:
@@ -74,14 +81,20 @@ w_variant_new (w_variant_type_t type, ...)
             break;
 
         case W_VARIANT_TYPE_STRING:
+            variant->value.stringbuf.arena = arena;
             w_buf_set_str (&variant->value.stringbuf, va_arg (args, const char*));
             break;
 
         case W_VARIANT_TYPE_BUFFER:
+            variant->value.stringbuf.arena = arena;
             w_buf_append_buf (&variant->value.stringbuf, va_arg (args, const w_buf_t*));
             variant->type = W_VARIANT_TYPE_STRING;
             break;
 
+        case W_VARIANT_TYPE_BYTES:
+            w_variant_set_bytes (variant, va_arg (args, w_bytes_t*));
+            break;
+
         case W_VARIANT_TYPE_DICT:
             variant->value.dict = w_obj_ref (va_arg (args, w_dict_t*));
             break;
@@ -94,12 +107,39 @@ w_variant_new (w_variant_type_t type, ...)
             variant->value.obj = w_obj_ref (va_arg (args, w_obj_t*));
             break;
     }
-    va_end (args);
 
     return w_obj_dtor (variant, _w_variant_dtor);
 }
 
 
+static w_obj_pool_t w_variant_pool = W_OBJ_POOL (w_variant_t, 1024);
+
+
+w_variant_t*
+w_variant_new (w_variant_type_t type, ...)
+{
+    va_list args;
+    va_start (args, type);
+    w_variant_t *variant = w_variant_init (w_obj_new_pooled (&w_variant_pool, w_variant_t), NULL, type, args);
+    va_end (args);
+    return variant;
+}
+
+
+w_variant_t*
+w_variant_new_in (w_arena_t *arena, w_variant_type_t type, ...)
+{
+    va_list args;
+    w_assert (arena);
+
+    va_start (args, type);
+    w_variant_t *variant = w_variant_init (w_arena_obj_new (arena, w_variant_t),
+                                           arena, type, args);
+    va_end (args);
+    return variant;
+}
+
+
 w_variant_t*
 w_variant_clear (w_variant_t *variant)
 {
@@ -108,3 +148,24 @@ w_variant_clear (w_variant_t *variant)
     variant->type = W_VARIANT_TYPE_INVALID;
     return variant;
 }
+
+
+void
+w__variant_unshare (w_variant_t *variant)
+{
+    w_assert (variant);
+    w_assert (variant->shared);
+
+    /*
+     * Strings which share memory with a w_bytes_t are copied before
+     * handing out a pointer to them, because adding the terminating
+     * null character would modify memory which is not ours.
+     */
+    const char *data = w_buf_const_data (&variant->value.stringbuf);
+    size_t size = w_buf_size (&variant->value.stringbuf);
+
+    variant->value.stringbuf = (w_buf_t) W_BUF;
+    w_buf_append_mem (&variant->value.stringbuf, data, size);
+    w_obj_unref (variant->shared);
+    variant->shared = NULL;
+}